@@ -0,0 +1,342 @@
+//! \file bootloader.cpp
+//! \brief CAN bootloader of the MotorBoard (boot section, see can_boot.h for the protocol)
+//! \date 2026 10 18
+//!
+//! The bootloader runs at reset (BOOTRST fuse programmed). It starts the application
+//! immediately, unless:
+//!     - the application requested it (CAN_BOOT_EE_REQUEST, see CONFIG_ENTER_BOOTLOADER),
+//!     - there is no application,
+//!     - a staged image has not been completely copied (it is copied first).
+//! It works without interruptions: the CAN MOBs are polled, and the flash operations on the
+//! staging area (RWW section) run while the frames of the next page are received.
+
+#include <avr/io.h>
+#include <avr/boot.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
+#include <stdint.h>
+#include "can_boot.h"
+
+#define MOB_SEND            0           //!< The MOB used to send the replies
+#define MOB_RECEIVE_FIRST   1           //!< The first MOB receiving the frames of the node
+#define MOB_RECEIVE_LAST    5           //!< The last MOB receiving the frames (5 frames of buffering)
+
+#define TIMEOUT_OVERFLOWS   3           //!< Timer 1 overflows (4.2s each) without frame before starting the application
+
+//! \struct PageBuffer
+//! \brief A page being received
+struct PageBuffer
+{
+    uint8_t  data[CAN_BOOT_PAGE_SIZE];  //!< The page content
+    uint16_t received;                  //!< Received data frames (one bit per frame)
+    uint16_t crc;                       //!< CRC given by the page header
+    uint8_t  page;                      //!< Page number (in the staging area)
+    bool     header;                    //!< true when the page header has been received
+};
+
+static PageBuffer buffers[2];           //!< The pages in flight (by parity)
+static uint8_t    node;                 //!< The node identifier
+static bool       started;              //!< true when a transfer is started
+static uint16_t   imageSize;            //!< Size of the image being transferred
+static uint16_t   imageCrc;             //!< CRC of the image being transferred
+static uint8_t    idleOverflows;        //!< Timer 1 overflows since the last frame
+static bool       writing;              //!< true while a page is written (only the page headers are processed)
+
+//! \brief Wait for the end of the transmission (aborted after a few ms, if not acknowledged)
+static void waitSent()
+{
+    for (uint16_t i=0; i<0xFFFF && (CANEN2 & (1 << MOB_SEND)); i++);
+    CANPAGE  = MOB_SEND << 4;
+    CANCDMOB = 0x00;
+}
+
+//! \brief Send a frame to the host (waits for the previous one)
+static void send(uint8_t dlc, const uint8_t* data)
+{
+    waitSent();
+    uint16_t id = CAN_BOOT_ID(node, CAN_BOOT_TYPE_REPLY);
+    CANPAGE  = MOB_SEND << 4;
+    CANSTMOB = 0x00;
+    CANIDT4  = 0x00;
+    CANIDT3  = 0x00;
+    CANIDT2  = (uint8_t)(id << 5);
+    CANIDT1  = (uint8_t)(id >> 3);
+    for (uint8_t i=0; i<dlc; i++) {
+        CANPAGE = (MOB_SEND << 4) | i;
+        CANMSG  = data[i];
+    }
+    CANCDMOB = 0x40 | dlc;
+}
+
+//! \brief Send a reply
+static void reply(uint8_t command, uint8_t status, uint8_t page=0)
+{
+    uint8_t data[3] = {command, status, page};
+    send(3, data);
+}
+
+//! \brief Initialize the CAN controller (500kb/s) and the receiving MOBs
+static void initCAN()
+{
+    DDRC  |= 0x80; // standby pin of the MCP2562 (PC7), enabled
+    PORTC &= 0x7F;
+
+    CANGCON = (1 << SWRES);
+    for (uint8_t mob=0; mob<6; mob++) {
+        CANPAGE  = mob << 4;
+        CANSTMOB = 0x00;
+        CANCDMOB = 0x00;
+    }
+    CANBT1 = 0x06;
+    CANBT2 = 0x04;
+    CANBT3 = 0x13;
+
+    // all the frames of the node (data and commands)
+    uint16_t id = CAN_BOOT_ID(node, 0);
+    for (uint8_t mob=MOB_RECEIVE_FIRST; mob<=MOB_RECEIVE_LAST; mob++) {
+        CANPAGE  = mob << 4;
+        CANIDT4  = 0x00;
+        CANIDT3  = 0x00;
+        CANIDT2  = (uint8_t)(id << 5);
+        CANIDT1  = (uint8_t)(id >> 3);
+        CANIDM4  = 0x04; // no remote frames
+        CANIDM3  = 0x00;
+        CANIDM2  = (uint8_t)(CAN_BOOT_ID_MASK << 5);
+        CANIDM1  = (uint8_t)(CAN_BOOT_ID_MASK >> 3);
+        CANCDMOB = 0x80;
+    }
+    CANGCON = 0x02; // enable
+}
+
+//! \brief CRC of a flash area
+static uint16_t flashCrc(uint16_t address, uint16_t size)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i=0; i<size; i++) {
+        crc = canBootCrc(crc, pgm_read_byte((const uint8_t*)(address + i)));
+    }
+    return crc;
+}
+
+//! \brief Program a flash page (the data comes from RAM or from the flash)
+//! \param address : the page address
+//! \param data : the content in RAM, 0 to copy the page at source
+//! \param source : the address of the content in flash (if data is 0)
+//! \param wait : function called while the flash is busy
+static void writePage(uint16_t address, const uint8_t* data, uint16_t source, void (*wait)())
+{
+    boot_page_erase(address);
+    while (boot_spm_busy()) { if (wait) wait(); }
+    boot_rww_enable();
+    for (uint8_t i=0; i<CAN_BOOT_PAGE_SIZE; i+=2) {
+        uint16_t word;
+        if (data) {
+            word = data[i] | ((uint16_t)data[i+1] << 8);
+        } else {
+            word = pgm_read_word((const uint16_t*)(source + i));
+        }
+        boot_page_fill(address + i, word);
+    }
+    boot_page_write(address);
+    while (boot_spm_busy()) { if (wait) wait(); }
+    boot_rww_enable();
+}
+
+//! \brief Install the staged image over the application (blocking)
+//! \return true if the application has the CRC of the staged image
+static bool install(uint16_t size, uint16_t crc)
+{
+    if (size == 0 || size > CAN_BOOT_STAGING_SIZE) return false;
+    if (flashCrc(CAN_BOOT_STAGING_START, size) != crc) return false;
+
+    // an interrupted copy is done again at the next reset
+    eeprom_update_word((uint16_t*)CAN_BOOT_EE_SIZE, size);
+    eeprom_update_word((uint16_t*)CAN_BOOT_EE_CRC, crc);
+    eeprom_update_byte((uint8_t*)CAN_BOOT_EE_STATE, CAN_BOOT_STATE_PENDING);
+
+    for (uint16_t offset=0; offset<size; offset+=CAN_BOOT_PAGE_SIZE) {
+        writePage(offset, 0, CAN_BOOT_STAGING_START + offset, 0);
+    }
+    if (flashCrc(0, size) != crc) return false;
+
+    eeprom_update_byte((uint8_t*)CAN_BOOT_EE_STATE, CAN_BOOT_STATE_NONE);
+    return true;
+}
+
+//! \brief Start the application (the peripherals used are reset)
+static void runApplication()
+{
+    waitSent(); // last reply sent
+    CANGCON = (1 << SWRES);
+    TCCR1B  = 0;
+    TCNT1   = 0;
+    TIFR1   = 0xFF;
+    boot_rww_enable();
+    asm volatile ("jmp 0");
+}
+
+//! \brief true if an application is programmed
+static bool hasApplication()
+{
+    return pgm_read_word((const uint16_t*)0) != 0xFFFF;
+}
+
+//! \brief Process a command frame
+static void command(const uint8_t* data, uint8_t dlc)
+{
+    switch (data[0]) {
+    case CAN_BOOT_CMD_START:
+        if (dlc < 5) break;
+        imageSize = ((uint16_t)data[1] << 8) | data[2];
+        imageCrc  = ((uint16_t)data[3] << 8) | data[4];
+        started = (imageSize != 0 && imageSize <= CAN_BOOT_STAGING_SIZE);
+        buffers[0].received = buffers[1].received = 0;
+        buffers[0].header = buffers[1].header = false;
+        reply(CAN_BOOT_CMD_START, started ? CAN_BOOT_OK : CAN_BOOT_ERR_SIZE);
+        break;
+
+    case CAN_BOOT_CMD_PAGE: {
+        if (dlc < 4) break;
+        uint8_t page = data[1];
+        if (!started) { reply(CAN_BOOT_CMD_PAGE, CAN_BOOT_ERR_STATE, page); break; }
+        if ((uint16_t)page * CAN_BOOT_PAGE_SIZE >= imageSize) { reply(CAN_BOOT_CMD_PAGE, CAN_BOOT_ERR_PAGE, page); break; }
+        PageBuffer* buffer = &buffers[page & 0x01];
+        if (!buffer->header || buffer->page != page) {
+            // new page (or sent again): the data frames received before the header are kept
+            if (buffer->header) buffer->received = 0;
+            buffer->page = page;
+        }
+        buffer->crc = ((uint16_t)data[2] << 8) | data[3];
+        buffer->header = true;
+        break;
+    }
+
+    case CAN_BOOT_CMD_COMMIT:
+        if (!started) { reply(CAN_BOOT_CMD_COMMIT, CAN_BOOT_ERR_STATE); break; }
+        if (install(imageSize, imageCrc)) {
+            reply(CAN_BOOT_CMD_COMMIT, CAN_BOOT_OK);
+            runApplication();
+        }
+        started = false;
+        reply(CAN_BOOT_CMD_COMMIT, CAN_BOOT_ERR_CRC);
+        break;
+
+    case CAN_BOOT_CMD_RUN:
+        if (hasApplication()) {
+            reply(CAN_BOOT_CMD_RUN, CAN_BOOT_OK);
+            runApplication();
+        }
+        reply(CAN_BOOT_CMD_RUN, CAN_BOOT_ERR_NO_APP);
+        break;
+
+    default:
+        break;
+    }
+}
+
+//! \brief Read the received frames (data frames are stored, commands processed)
+static void pollCAN()
+{
+    for (uint8_t mob=MOB_RECEIVE_FIRST; mob<=MOB_RECEIVE_LAST; mob++) {
+        CANPAGE = mob << 4;
+        if (!(CANSTMOB & (1 << RXOK))) continue;
+
+        uint8_t type = (CANIDT2 >> 5) | ((CANIDT1 & 0x07) << 3);
+        uint8_t dlc  = CANCDMOB & 0x0F;
+        uint8_t data[8];
+        if (dlc > 8) dlc = 8;
+        for (uint8_t i=0; i<dlc; i++) {
+            CANPAGE = (mob << 4) | i;
+            data[i] = CANMSG;
+        }
+        CANPAGE  = mob << 4;
+        CANSTMOB = 0x00;
+        CANCDMOB = 0x80; // ready for the next frame
+        idleOverflows = 0;
+
+        if (type == CAN_BOOT_TYPE_COMMAND) {
+            // during a write, the other commands are ignored (the host sends them again)
+            if (dlc > 0 && (!writing || data[0] == CAN_BOOT_CMD_PAGE)) command(data, dlc);
+        } else if ((type & ~(CAN_BOOT_TYPE_PARITY | 0x0F)) == CAN_BOOT_TYPE_DATA && dlc == 8 && started) {
+            PageBuffer* buffer = &buffers[(type & CAN_BOOT_TYPE_PARITY) ? 1 : 0];
+            uint8_t position = type & 0x0F;
+            for (uint8_t i=0; i<8; i++) {
+                buffer->data[position*8 + i] = data[i];
+            }
+            buffer->received |= ((uint16_t)1 << position);
+        }
+    }
+}
+
+//! \brief Write the complete pages in the staging area
+static void processPages()
+{
+    for (uint8_t parity=0; parity<2; parity++) {
+        PageBuffer* buffer = &buffers[parity];
+        if (!buffer->header || buffer->received != 0xFFFF) continue;
+
+        uint8_t page = buffer->page;
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i=0; i<CAN_BOOT_PAGE_SIZE; i++) crc = canBootCrc(crc, buffer->data[i]);
+
+        uint8_t status = CAN_BOOT_ERR_CRC;
+        if (crc == buffer->crc) {
+            uint16_t address = CAN_BOOT_STAGING_START + (uint16_t)page * CAN_BOOT_PAGE_SIZE;
+            // the frames of the other page are received during the write
+            writing = true;
+            writePage(address, buffer->data, 0, pollCAN);
+            writing = false;
+            status = (flashCrc(address, CAN_BOOT_PAGE_SIZE) == crc) ? CAN_BOOT_OK : CAN_BOOT_ERR_WRITE;
+        }
+        buffer->header = false;
+        buffer->received = 0;
+        reply(CAN_BOOT_CMD_PAGE, status, page);
+    }
+}
+
+//! \fn int main(void)
+//! \brief The main function of the bootloader
+int main(void)
+{
+    // the application resets through the watchdog to enter the bootloader
+    MCUSR = 0;
+    wdt_disable();
+
+    node = eeprom_read_byte((const uint8_t*)CAN_BOOT_EE_NODE);
+    if (node >= CAN_BOOT_MAX_NODES) node = CAN_BOOT_DEFAULT_NODE;
+
+    // finish an interrupted installation
+    bool stay = false;
+    if (eeprom_read_byte((const uint8_t*)CAN_BOOT_EE_STATE) == CAN_BOOT_STATE_PENDING) {
+        stay = !install(eeprom_read_word((const uint16_t*)CAN_BOOT_EE_SIZE),
+                        eeprom_read_word((const uint16_t*)CAN_BOOT_EE_CRC));
+        if (stay) eeprom_update_byte((uint8_t*)CAN_BOOT_EE_STATE, CAN_BOOT_STATE_NONE);
+    }
+
+    if (eeprom_read_byte((const uint8_t*)CAN_BOOT_EE_REQUEST) == CAN_BOOT_REQUEST_MAGIC) {
+        eeprom_update_byte((uint8_t*)CAN_BOOT_EE_REQUEST, 0xFF);
+        stay = true;
+    }
+    if (!hasApplication()) stay = true;
+    if (!stay) runApplication();
+
+    // timer 1, normal mode, clk/1024: overflow every 4.2s
+    TCCR1A = 0;
+    TCCR1B = (1 << CS12) | (1 << CS10);
+
+    initCAN();
+    uint8_t ready[2] = {CAN_BOOT_CMD_READY, CAN_BOOT_VERSION};
+    send(2, ready);
+
+    while (1) {
+        pollCAN();
+        processPages();
+
+        // back to the application if the host is gone
+        if (TIFR1 & (1 << TOV1)) {
+            TIFR1 = (1 << TOV1);
+            if (++idleOverflows >= TIMEOUT_OVERFLOWS && hasApplication()) runApplication();
+        }
+    }
+}
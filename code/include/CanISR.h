@@ -150,4 +150,125 @@
 		CANMSG = buffer[i];
 	}
 	CANCDMOB = 0x40 | dlc;							// send the message using the proper MOB
-  }
\ No newline at end of file
+  }
+
+  //! \fn uint8_t getData()
+  //! \brief Reading the data received by a CAN MOB.
+  //!
+  //! Copy the data received by a CAN MOB between 0 to 6 in a buffer (8 bytes max).
+  //! Returns the DLC of the received frame.
+  uint8_t getData (uint8_t mobNumber, uint8_t* buffer)
+  {
+	CANPAGE = (mobNumber << 4) & 0xF0;				// Mob selection
+
+	uint8_t dlc = CANCDMOB & 0x0F;					// get the DLC of the CAN frame
+	if (dlc > 8) { dlc = 8; }
+
+	for (int i=0; i < dlc; i++)
+	{
+		CANPAGE &= 0xF0;
+		CANPAGE |= i;
+		buffer[i] = CANMSG;
+	}
+	return dlc;
+  }
+
+  //! \fn bool isCANMOBBusy()
+  //! \brief Check if a CAN MOB is still in use.
+  //!
+  //! Returns true while a CAN MOB between 0 to 6 is enabled (transmission not completed yet).
+  bool isCANMOBBusy (uint8_t mobNumber)
+  {
+	return CANEN2 & (1 << mobNumber);
+  }
+
+  //! \fn void rearmCANMOBasReceiver()
+  //! \brief Re-arm a CAN MOB after a reception.
+  //!
+  //! Reset the status of a CAN MOB between 0 to 6 and configure it for the next reception.
+  void rearmCANMOBasReceiver (uint8_t mobNumber)
+  {
+	CANPAGE   = (mobNumber << 4) & 0xF0;			// selection of correct MOB
+	CANSTMOB  = 0x00;								// Reset the status of the MOB
+	CANCDMOB  = 0x80;								// Config as reception MOB
+	CANIE2   |= (1 << mobNumber);					// Enable the interruption over the MOB (for the next one)
+	CANSIT2  &= ~(1 << mobNumber);					// remove the MOB raised flag
+  }
+
+  //! \fn void clearCANMOBStatus()
+  //! \brief Acknowledge the interruption of a CAN MOB.
+  //!
+  //! Reset the status of a CAN MOB between 0 to 5 (TXOK after a transmission), its configuration is kept.
+  void clearCANMOBStatus (uint8_t mobNumber)
+  {
+	CANPAGE  = (mobNumber << 4) & 0xF0;				// selection of correct MOB
+	CANSTMOB = 0x00;								// Reset the status of the MOB (and its interruption)
+  }
+
+  //! \fn void initCANMOBasAutoReply()
+  //! \brief Initialize a CAN MOB as an automatic reply to remote frames.
+  //!
+  //! Initialize a CAN MOB between 0 to 5 to answer the remote frames of an ID by itself.
+  //! The MOB is armed by updateCANMOBAutoReply, with the payload. The controller disables
+  //! the MOB once the reply is sent: its interruption (TXOK) is enabled, for
+  //! rearmCANMOBAutoReply.
+  void initCANMOBasAutoReply (uint8_t mobNumber, uint32_t ID)
+  {
+	CANPAGE  = (mobNumber << 4) & 0xF0;				// selection of correct MOB
+	CANCDMOB = 0x00;								// disabled until the first payload
+	CANSTMOB = 0x00;
+	CANIE2  |= (1 << mobNumber);					// Enable the interruption over the MOB (reply sent)
+
+	CANIDT3 = 0x00;
+	CANIDT2 = (uint8_t)( (ID & 0x00F)<< 5 );		// identifier implementation
+	CANIDT1 = (uint8_t)( ID >> 3 );
+
+	CANIDM4 = 0x04;									// mask over the rtr value (remote frames only)
+	CANIDM3 = 0xFF;									// mask over the identifier
+	CANIDM2 = 0xFF;
+	CANIDM1 = 0xFF;
+  }
+
+  //! \fn void rearmCANMOBAutoReply()
+  //! \brief Re-arm an automatic reply CAN MOB after a reply.
+  //!
+  //! Reset the status of a CAN MOB initialized by initCANMOBasAutoReply and enable it again
+  //! for the next remote frame, with the payload already in the MOB (from the CAN interruption, TXOK).
+  void rearmCANMOBAutoReply (uint8_t mobNumber, uint8_t dlc)
+  {
+	CANPAGE  = (mobNumber << 4) & 0xF0;				// Mob selection
+	CANSTMOB = 0x00;								// Reset the status of the MOB (and its interruption)
+	CANIDT4  = 0x04;								// remote frame expected (reset when the reply is sent)
+	CANCDMOB = 0x80 | 0x20 | dlc;					// reception, with the reply valid (RPLV)
+  }
+
+  //! \fn bool updateCANMOBAutoReply()
+  //! \brief Update the payload of an automatic reply CAN MOB.
+  //!
+  //! Write the payload of a CAN MOB initialized by initCANMOBasAutoReply in place: the MOB
+  //! stays enabled, a remote frame received meanwhile is still answered. The payload is
+  //! written with the interrupts disabled (about 3us) while the controller neither receives
+  //! nor transmits: a remote frame (47 bits, 94us at 500kb/s) cannot be received and answered
+  //! during the write, so a reply is never a mix of two payloads. The MOB is armed by the first
+  //! update, and again if it was not re-armed since its last reply (rearmCANMOBAutoReply).
+  //! Returns false if the bus was busy (the previous payload is kept until the next update).
+  bool updateCANMOBAutoReply (uint8_t mobNumber, uint8_t dlc, const uint8_t* buffer)
+  {
+	bool written = false;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!(CANGSTA & ((1 << TXBSY) | (1 << RXBSY))))	// no frame on the bus
+		{
+			CANPAGE = (mobNumber << 4) & 0xF0;		// Mob selection
+			for (int i=0; i < dlc; i++)
+			{
+				CANPAGE &= 0xF0;
+				CANPAGE |= i;
+				CANMSG = buffer[i];
+			}
+			if (!(CANEN2 & (1 << mobNumber))) { rearmCANMOBAutoReply(mobNumber, dlc); }
+			written = true;
+		}
+	}
+	return written;
+  }
@@ -0,0 +1,87 @@
+#ifndef CAN_BOOT_H
+#define CAN_BOOT_H
+
+//! \file can_boot.h
+//! \brief CAN bootloader protocol (shared by the bootloader, the application and the host flasher)
+//! \date 2026 10 18
+//!
+//! The frames use standard identifiers: CAN_BOOT_ID(node, type)
+//!     | 1 | node (4 bits) | type (6 bits) |
+//! The types 0x00-0x0F and 0x20-0x2F are the data frames of a page: 8 bytes, bits 0-3 give
+//! the position in the page, bit 5 the parity of the page number (two pages can be in flight).
+//! CAN_BOOT_TYPE_COMMAND frames go from the host to the node, CAN_BOOT_TYPE_REPLY frames
+//! from the node to the host.
+//!
+//! The image is first written in the staging area. Once its CRC is checked (COMMIT), it is
+//! copied over the application, with an EEPROM flag to finish the copy after a power loss.
+//! An interrupted or corrupted transfer never touches the application: the old image runs.
+//!
+//! Flashing sequence (host):
+//!     - COMMAND | START | size(MSB) | size(LSB) | crc(MSB) | crc(LSB)   -> REPLY | START | status
+//!     - for each page, at most CAN_BOOT_WINDOW pages not acknowledged:
+//!       COMMAND | PAGE | page | crc(MSB) | crc(LSB), then the 16 data frames
+//!                                                                      -> REPLY | PAGE | status | page
+//!     - COMMAND | COMMIT                                               -> REPLY | COMMIT | status
+//!       then the node starts the application
+
+#include <stdint.h>
+
+#define CAN_BOOT_ID_BASE        0x400       //!< Identifiers of the bootloader frames
+#define CAN_BOOT_ID(node, type) (CAN_BOOT_ID_BASE | ((uint16_t)(node) << 6) | (type)) //!< Identifier of a frame
+#define CAN_BOOT_ID_MASK        0x7C0       //!< Mask of the identifiers of a node
+#define CAN_BOOT_MAX_NODES      16          //!< Number of node identifiers
+#define CAN_BOOT_DEFAULT_NODE   0           //!< Node identifier when none is stored in EEPROM
+
+#define CAN_BOOT_TYPE_DATA      0x00        //!< Data frames (| parity << 5 | position)
+#define CAN_BOOT_TYPE_PARITY    0x20        //!< Data frames of the odd pages
+#define CAN_BOOT_TYPE_COMMAND   0x10        //!< Command frame (host -> node)
+#define CAN_BOOT_TYPE_REPLY     0x11        //!< Reply frame (node -> host)
+
+// Commands (first byte of the command and reply frames)
+#define CAN_BOOT_CMD_READY      0x01        //!< Reply only: | version | the bootloader is waiting for commands
+#define CAN_BOOT_CMD_START      0x02        //!< | size(2) | crc(2) | start a transfer
+#define CAN_BOOT_CMD_PAGE       0x03        //!< | page | crc(2) | page header, the data frames follow
+#define CAN_BOOT_CMD_COMMIT     0x04        //!< check the image, install it and start it
+#define CAN_BOOT_CMD_RUN        0x05        //!< start the application without flashing
+
+// Status (second byte of the replies)
+#define CAN_BOOT_OK             0x00        //!< Success
+#define CAN_BOOT_ERR_SIZE       0x01        //!< The image does not fit in the staging area
+#define CAN_BOOT_ERR_STATE      0x02        //!< No transfer started
+#define CAN_BOOT_ERR_PAGE       0x03        //!< Page out of the image
+#define CAN_BOOT_ERR_CRC        0x04        //!< CRC error (page or image)
+#define CAN_BOOT_ERR_WRITE      0x05        //!< Flash content different after the write
+#define CAN_BOOT_ERR_NO_APP     0x06        //!< No application to start
+
+#define CAN_BOOT_VERSION        1           //!< Protocol version
+#define CAN_BOOT_PAGE_SIZE      128         //!< Flash page size (SPM_PAGESIZE of the ATmega32M1)
+#define CAN_BOOT_FRAMES_PER_PAGE (CAN_BOOT_PAGE_SIZE/8) //!< Data frames per page
+#define CAN_BOOT_WINDOW         2           //!< Pages sent before the acknowledgement of the first one
+
+// Flash layout (bytes): | application | staging | bootloader |
+#define CAN_BOOT_START          0x7000      //!< Bootloader start (boot section of 4K bytes, BOOTSZ=00)
+#define CAN_BOOT_STAGING_SIZE   (CAN_BOOT_START/2) //!< Maximum size of the application (14K bytes)
+#define CAN_BOOT_STAGING_START  CAN_BOOT_STAGING_SIZE //!< Start of the staging area
+
+// EEPROM layout (end of the 1K bytes EEPROM)
+#define CAN_BOOT_EE_REQUEST     0x3F8       //!< Set to CAN_BOOT_REQUEST_MAGIC by the application to stay in the bootloader
+#define CAN_BOOT_EE_NODE        0x3F9       //!< Node identifier (0xFF: CAN_BOOT_DEFAULT_NODE)
+#define CAN_BOOT_EE_STATE       0x3FA       //!< State of the staged image (CAN_BOOT_STATE_XXX)
+#define CAN_BOOT_EE_SIZE        0x3FC       //!< Size of the staged image (word)
+#define CAN_BOOT_EE_CRC         0x3FE       //!< CRC of the staged image (word)
+
+#define CAN_BOOT_REQUEST_MAGIC  0xB0        //!< Value of CAN_BOOT_EE_REQUEST to stay in the bootloader
+#define CAN_BOOT_STATE_NONE     0xFF        //!< Nothing to install
+#define CAN_BOOT_STATE_PENDING  0x01        //!< The staged image is valid, the copy is not finished
+
+//! \fn uint16_t canBootCrc(uint16_t crc, uint8_t data)
+//! \brief Update a CRC-CCITT (reflected, initial value 0xFFFF) with a byte
+//! (same result as _crc_ccitt_update of avr-libc, also available on the host)
+static inline uint16_t canBootCrc(uint16_t crc, uint8_t data)
+{
+    data ^= (uint8_t)crc;
+    data ^= (uint8_t)(data << 4);
+    return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+#endif // CAN_BOOT_H
@@ -0,0 +1,71 @@
+#include "capture.h"
+
+#define CAPTURE_INDEX_MASK (CAPTURE_NB_RECORDS-1) //!< Index wrapping (power of 2)
+
+Capture::Capture() :
+    _head(0),
+    _nbRecords(0),
+    _state(CAPTURE_IDLE),
+    _triggers(0),
+    _events(0),
+    _source(0),
+    _postTrigger(0),
+    _remaining(0),
+    _threshold(0)
+{}
+
+void Capture::arm(uint8_t triggers, uint8_t postTrigger, uint8_t threshold)
+{
+    _state = CAPTURE_IDLE; // not recorded while changing the settings
+    if (postTrigger > CAPTURE_NB_RECORDS-1) postTrigger = CAPTURE_NB_RECORDS-1;
+    _triggers = triggers | CAPTURE_TRIGGER_MANUAL;
+    _postTrigger = postTrigger;
+    _threshold = threshold;
+    _head = 0;
+    _nbRecords = 0;
+    _events = 0;
+    _source = 0;
+    _state = CAPTURE_ARMED;
+}
+
+void Capture::stop()
+{
+    _state = CAPTURE_IDLE;
+}
+
+// Called from the timer interruption
+void Capture::record(const CaptureRecord& rec, uint8_t events)
+{
+    if (!isRecording()) return;
+
+    _buffer[_head] = rec;
+    _head = (_head + 1) & CAPTURE_INDEX_MASK;
+    if (_nbRecords < CAPTURE_NB_RECORDS) _nbRecords++;
+
+    if (_state == CAPTURE_ARMED) {
+        events |= _events;
+        _events = 0;
+        int16_t error = (int16_t)rec.target - rec.val;
+        if (error < 0) error = -error;
+        if (error > _threshold) events |= CAPTURE_TRIGGER_ERROR;
+
+        events &= _triggers;
+        if (!events) return;
+        _source = events;
+        _remaining = _postTrigger;
+        _state = CAPTURE_TRIGGERED;
+    }
+
+    if (_remaining == 0) {
+        _state = CAPTURE_DONE;
+    } else {
+        _remaining--;
+    }
+}
+
+const CaptureRecord& Capture::getRecord(uint8_t position)
+{
+    // the oldest record is at _head once the buffer has been filled
+    uint8_t oldest = (_nbRecords < CAPTURE_NB_RECORDS) ? 0 : _head;
+    return _buffer[(oldest + position) & CAPTURE_INDEX_MASK];
+}
@@ -0,0 +1,117 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+//! \file capture.h
+//! \brief Capture class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define CAPTURE_NB_RECORDS      64      //!< Size of the capture buffer (power of 2, 8 bytes per record)
+
+// Trigger sources (can be ORed together)
+#define CAPTURE_TRIGGER_FAULT   0x01    //!< A fault is latched by the protection
+#define CAPTURE_TRIGGER_ERROR   0x02    //!< The speed error is over the threshold
+#define CAPTURE_TRIGGER_COMMAND 0x04    //!< A new speed target is received
+#define CAPTURE_TRIGGER_MANUAL  0x08    //!< Triggered by a configuration command (always enabled)
+
+// States of the capture
+#define CAPTURE_IDLE            0       //!< Not recording
+#define CAPTURE_ARMED           1       //!< Recording, waiting for a trigger
+#define CAPTURE_TRIGGERED       2       //!< Recording the post-trigger records
+#define CAPTURE_DONE            3       //!< Stopped after the post-trigger records, the buffer can be dumped
+
+//! \struct CaptureRecord
+//! \brief Signals of one control tick, packed on 8 bytes (one CAN frame)
+struct CaptureRecord
+{
+    int8_t   val;       //!< Measured counter value (saturated)
+    int8_t   target;    //!< Target counter value (saturated)
+    int8_t   p;         //!< PID proportional term (counter value, saturated)
+    int8_t   i;         //!< PID integral term (counter value, saturated)
+    int8_t   d;         //!< PID derivative term (counter value, saturated)
+    int16_t  pwm;       //!< Speed applied to the motor (see Motor_dc::setSpeed)
+    uint8_t  current;   //!< Current measurement (ADC value / 4)
+};
+
+//! \class Capture
+//! \brief Capture class.
+//!
+//! Triggered capture of the control loop signals ("oscilloscope mode"). Once armed,
+//! a record is written at each tick in a circular buffer. When a trigger fires, the
+//! recording continues for the post-trigger records, then stops: the buffer holds the
+//! records before and after the trigger, until it is dumped and armed again.
+//! Recording costs a copy of 8 bytes per tick, and nothing when not armed.
+class Capture
+{
+public:
+
+    //! \brief Capture constructor (idle, empty buffer)
+    Capture();
+
+    //! \brief arm Start recording, waiting for a trigger
+    //!
+    //! \param[in] triggers : the trigger sources (CAPTURE_TRIGGER_XXX, ORed)
+    //! \param[in] postTrigger : number of records after the trigger (bounded to CAPTURE_NB_RECORDS-1)
+    //! \param[in] threshold : the speed error threshold (counter value, CAPTURE_TRIGGER_ERROR)
+    void arm(uint8_t triggers, uint8_t postTrigger, uint8_t threshold);
+
+    //! \brief stop Stop recording (the records are kept)
+    void stop();
+
+    //! \brief trigger Signal an event, taken into account at the next record
+    //!
+    //! \param[in] source : the trigger source (CAPTURE_TRIGGER_XXX)
+    inline void trigger(uint8_t source) { _events |= source; }
+
+    //! \brief record Record the signals of a tick, and check the triggers
+    //!
+    //! \param[in] rec : the signals
+    //! \param[in] events : the trigger sources raised during this tick
+    void record(const CaptureRecord& rec, uint8_t events);
+
+    //! \brief getState Get the state of the capture
+    //! \return CAPTURE_IDLE, CAPTURE_ARMED, CAPTURE_TRIGGERED or CAPTURE_DONE
+    inline uint8_t getState() { return _state; }
+
+    //! \brief isRecording Check if a record has to be given at each tick
+    inline bool isRecording() { return _state == CAPTURE_ARMED || _state == CAPTURE_TRIGGERED; }
+
+    //! \brief getNbRecords Get the number of records in the buffer
+    inline uint8_t getNbRecords() { return _nbRecords; }
+
+    //! \brief getTriggerPosition Get the position of the trigger record (from the oldest record)
+    inline uint8_t getTriggerPosition() { return _nbRecords - 1 - _postTrigger; }
+
+    //! \brief getTriggerSource Get the sources of the trigger
+    inline uint8_t getTriggerSource() { return _source; }
+
+    //! \brief getPostTrigger Get the number of records after the trigger
+    inline uint8_t getPostTrigger() { return _postTrigger; }
+
+    //! \brief getRecord Get a record
+    //! \param[in] position : position of the record, from the oldest one
+    //! \return the record
+    const CaptureRecord& getRecord(uint8_t position);
+
+    //! \brief saturate Bound a value to a record field
+    //! \param[in] value : the value
+    //! \return the value bounded to -128..127
+    static inline int8_t saturate(int16_t value) {
+        return (value > 127) ? 127 : ((value < -128) ? -128 : value);
+    }
+
+private:
+    CaptureRecord     _buffer[CAPTURE_NB_RECORDS]; //!< The circular buffer
+    uint8_t           _head;        //!< Index of the next record to write
+    uint8_t           _nbRecords;   //!< Number of records in the buffer
+    volatile uint8_t  _state;       //!< State of the capture
+    uint8_t           _triggers;    //!< Enabled trigger sources
+    volatile uint8_t  _events;      //!< Events signaled since the last record
+    uint8_t           _source;      //!< Sources of the trigger
+    uint8_t           _postTrigger; //!< Number of records after the trigger
+    uint8_t           _remaining;   //!< Remaining records after the trigger
+    uint8_t           _threshold;   //!< Speed error threshold
+};
+
+#endif // CAPTURE_H
@@ -8,7 +8,7 @@
 
 #include <avr/io.h>        // for the ATMEGA registers definition
 #include <avr/interrupt.h> // for the interruptions
-#include "spi.h"
+#include "spi_bus.h"
 
 //Count modes 
 #define NQUAD   0x00          //!< non-quadrature mode
@@ -56,6 +56,16 @@
 #define EN_CNTR  0x00 //!<counting enabled 
 #define DIS_CNTR 0x04 //!< counting disabled 
 
+// Status register bits
+#define STR_CY  0x80  //!< carry (counter overflow), latched
+#define STR_BW  0x40  //!< borrow (counter underflow), latched
+#define STR_CMP 0x20  //!< compare (CNTR = DTR), latched
+#define STR_IDX 0x10  //!< index, latched
+#define STR_CEN 0x08  //!< counting enabled
+#define STR_PLS 0x04  //!< power loss (set at power up), latched
+#define STR_UD  0x02  //!< count direction (1: up)
+#define STR_S   0x01  //!< sign of the counter value
+
 // LS7366R op-code list
 #define CLR_MDR0   0x08  //!< TODO
 #define CLR_MDR1   0x10  //!< TODO
@@ -70,45 +80,55 @@
 #define WRITE_MDR0 0x88  //!< TODO
 #define WRITE_DTR  0x98  //!< TODO
 #define LOAD_CNTR  0xE0  //!< TODO
-#define LOAD_OTR   0xE4  //!< TODO
+#define LOAD_OTR   0xE8  //!< Counter value latched in the OTR (register field 101, 0xE4 would load CNTR from DTR)
 
 
+//! \class Counter
+//! \brief Counter class.
+//!
+//! LS7366R quadrature counter, on an SPI bus (SpiBus). The bus and the index of
+//! the counter on the bus are template parameters, so that the chip select is toggled
+//! with single bit instructions at each transaction.
+//! With the SPI_BUS_ALL index, the commands without answer are sent to all the counters
+//! of the bus at once (the read functions do not compile).
+//!
+//! \tparam BUS : the SPI bus of the counter (SpiBus<SPI_CS_A, ...>)
+//! \tparam DEVICE : the index of the counter on the bus, or SPI_BUS_ALL
+template<class BUS, uint8_t DEVICE>
 class Counter{
     public:
         //! \brief Counter constructor
         //!
-        //! Counter constructor
-        //!
-        //! \param spi : pointer over the SPI interface
-        //! \param port : pointer over the counter port
-        //! \param ddr : TODO
-        //! \param[in] pin : the counter pin
-        Counter(Spi *spi, volatile uint8_t *port, volatile uint8_t *ddr, uint8_t pin);
-
-        //! \brief Counter destructor
+        //! Counter constructor (the chip select is initialized by the bus)
         //!
-        //! Counter destructor
-        ~Counter();
+        //! \param bus : pointer over the SPI bus
+        Counter(BUS *bus) : _bus(bus) {}
 
         //! \brief clear_mode_register_0 TODO
         //!
         //! TODO
-        void clear_mode_register_0();
+        void clear_mode_register_0() { command(CLR_MDR0); }
 
         //! \brief clear_mode_register_1 TODO
         //!
         //! TODO
-        void clear_mode_register_1();
+        void clear_mode_register_1() { command(CLR_MDR1); }
 
         //! \brief clear_status_register TODO
         //!
         //! TODO
-        void clear_status_register();
+        void clear_status_register() { command(CLR_STR); }
 
         //! \brief clear_counter clear counter
         //!
         //! Clear the counter value (to 0)
-        void clear_counter();
+        void clear_counter() { command(CLR_CNTR); }
+
+        //! \brief load_OTR Latch the counter value in the OTR
+        //!
+        //! Snapshot of the counter value, read later with read_OTR (with the
+        //! SPI_BUS_ALL index, all the counters are latched at the same time)
+        void load_OTR() { command(LOAD_OTR); }
 
 
         //! \brief write_mode_register_0 TODO
@@ -137,7 +157,17 @@ class Counter{
         //!Read the counter value (int32_t)
         //!
         //! return : The value of the counter
-        int32_t read_counter();
+        int32_t read_counter() { return read_register_32(READ_CNTR); }
+
+        //! \brief read_mode_register_0 Read the mode register 0
+        //!
+        //! return : The value of MDR0
+        uint8_t read_mode_register_0() { return read_register(READ_MDR0); }
+
+        //! \brief read_mode_register_1 Read the mode register 1
+        //!
+        //! return : The value of MDR1
+        uint8_t read_mode_register_1() { return read_register(READ_MDR1); }
 
         //! \brief read_status_register TODO
         //!
@@ -146,17 +176,113 @@ class Counter{
         //! return : The value of the status register
         uint8_t read_status_register();
 
-        //! \brief read_OTR TODO
+        //! \brief read_OTR Read the output register (int32_t)
         //!
-        //!TODO
+        //! The OTR holds the counter value latched by LOAD_OTR, or by the index
+        //! pulse in the INDX_LOADO mode
         //!
         //! return : The value of the OTR
-        long read_OTR();
+        int32_t read_OTR() { return read_register_32(READ_OTR); }
 
     protected:
-        Spi* _spi;                     //!< The SPI interface pointer, to communicate with the counter
-        volatile uint8_t *_port, _pin; //!< The pointer of the port and pi of the counter
+        //! \brief command Send a one byte op-code
+        //! \param[in] opcode : the op-code
+        void command(uint8_t opcode);
+
+        //! \brief read_register Read a one byte register
+        //! \param[in] opcode : the read op-code (READ_MDR0, READ_MDR1, READ_STR)
+        //! \return the value of the register
+        uint8_t read_register(uint8_t opcode);
+
+        //! \brief read_register_32 Read a four bytes register (BYTE_4 mode)
+        //! \param[in] opcode : the read op-code (READ_CNTR, READ_OTR)
+        //! \return the value of the register
+        int32_t read_register_32(uint8_t opcode);
+
+        BUS* _bus;                     //!< The SPI bus pointer, to communicate with the counter
 
 };
 
+template<class BUS, uint8_t DEVICE>
+void Counter<BUS, DEVICE>::command(uint8_t opcode){
+    BUS::template select<DEVICE>();
+
+    _bus->send(opcode);
+
+    BUS::template deselect<DEVICE>();
+}
+
+template<class BUS, uint8_t DEVICE>
+int32_t Counter<BUS, DEVICE>::read_register_32(uint8_t opcode){
+    static_assert(DEVICE != SPI_BUS_ALL, "the counters would all drive MISO");
+
+    int32_t data=0;
+    int8_t  i=4;
+
+    BUS::template select<DEVICE>();
+
+
+    _bus->transfer(opcode);
+
+    while (i>0)
+    {
+        data = (data <<8) | (_bus->transfer(0x00));
+        i--;
+    }
+
+    BUS::template deselect<DEVICE>();
+    return data;
+}
+
+template<class BUS, uint8_t DEVICE>
+void Counter<BUS, DEVICE>::write_mode_register_0(uint8_t data){
+    BUS::template select<DEVICE>();
+
+    _bus->send(WRITE_MDR0);
+    _bus->send(data);
+
+    BUS::template deselect<DEVICE>();
+}
+
+template<class BUS, uint8_t DEVICE>
+void Counter<BUS, DEVICE>::write_mode_register_1(uint8_t data){
+    BUS::template select<DEVICE>();
+
+    _bus->send(WRITE_MDR1);
+    _bus->send(data);
+
+
+    BUS::template deselect<DEVICE>();
+}
+
+template<class BUS, uint8_t DEVICE>
+void Counter<BUS, DEVICE>::write_data_register(int32_t data){
+    BUS::template select<DEVICE>();
+
+    _bus->send(WRITE_DTR);
+    for (uint8_t i=0;i<4;i++)
+    {
+        _bus->send((uint8_t)(data >> (8*(3 - i))));
+    }
+
+    BUS::template deselect<DEVICE>();
+}
+
+template<class BUS, uint8_t DEVICE>
+uint8_t Counter<BUS, DEVICE>::read_status_register(){
+    return read_register(READ_STR);
+}
+
+template<class BUS, uint8_t DEVICE>
+uint8_t Counter<BUS, DEVICE>::read_register(uint8_t opcode){
+    static_assert(DEVICE != SPI_BUS_ALL, "the counters would all drive MISO");
+    BUS::template select<DEVICE>();
+
+    _bus->transfer(opcode);
+    uint8_t data = _bus->transfer(0x00);
+
+    BUS::template deselect<DEVICE>();
+    return data;
+}
+
 #endif
@@ -0,0 +1,52 @@
+#include "disturbance_observer.h"
+
+DisturbanceObserver::DisturbanceObserver(uint8_t bandwidth, uint16_t timeConstant) :
+    _enabled(false)
+{
+    setParameters(bandwidth, timeConstant);
+    reset();
+}
+
+void DisturbanceObserver::setParameters(uint8_t bandwidth, uint16_t timeConstant)
+{
+    _bandwidth = (bandwidth == 0) ? 1 : bandwidth;
+    _timeConstant = timeConstant;
+}
+
+void DisturbanceObserver::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+    reset();
+}
+
+void DisturbanceObserver::reset()
+{
+    _estimate = 0;
+    _lastSpeed = 0;
+    _lastCommand = 0;
+    _primed = false;
+}
+
+// Called from the timer interruption
+int16_t DisturbanceObserver::update(int16_t speed, int16_t limit)
+{
+    if (_primed) {
+        // command giving this speed without load (inverse of the nominal model),
+        // the values are bounded against the counter glitches (no overflow)
+        int32_t acceleration = (int32_t)speed - _lastSpeed;
+        if (acceleration > 4096) acceleration = 4096;
+        if (acceleration < -4096) acceleration = -4096;
+        int32_t nominal = speed + (((int32_t)_timeConstant * acceleration) >> 8);
+        int32_t load = (int32_t)_lastCommand - nominal;
+        if (load > limit) load = limit;
+        if (load < -limit) load = -limit;
+        // first order filter (Q8)
+        _estimate += (((load << 8) - _estimate) * _bandwidth) >> 8;
+        int32_t max = (int32_t)limit << 8;
+        if (_estimate > max) _estimate = max;
+        if (_estimate < -max) _estimate = -max;
+    }
+    _lastSpeed = speed;
+    _primed = true;
+    return getEstimate();
+}
@@ -0,0 +1,73 @@
+#ifndef DISTURBANCE_OBSERVER_H
+#define DISTURBANCE_OBSERVER_H
+
+//! \file disturbance_observer.h
+//! \brief DisturbanceObserver class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+//! \class DisturbanceObserver
+//! \brief DisturbanceObserver class.
+//!
+//! Load disturbance observer of the velocity loop, in fixed point. The nominal model of
+//! the motor is a first order, with a unit gain from the command to the speed (both in
+//! counter values per tick, see TIC2PWM_FACTOR) and a mechanical time constant. Its inverse
+//! gives the command that would produce the measured speed without load:
+//!     nominal = speed + timeConstant * (speed - previous speed)
+//! The difference with the command applied at the previous tick is the load, low-pass
+//! filtered (the bandwidth is the filter gain per tick). The estimate is added to the
+//! command: the load is rejected faster than by the PID integrator.
+class DisturbanceObserver
+{
+public:
+
+    //! \brief DisturbanceObserver constructor (disabled)
+    //!
+    //! \param[in] bandwidth : the filter gain per tick (Q8, 1 to 255)
+    //! \param[in] timeConstant : the mechanical time constant of the motor (ticks, Q8)
+    DisturbanceObserver(uint8_t bandwidth, uint16_t timeConstant);
+
+    //! \brief setParameters Set the parameters of the observer
+    //!
+    //! \param[in] bandwidth : the filter gain per tick (Q8, 1 to 255), the cut-off frequency
+    //!                        is about bandwidth / (256 * 2 * PI * tick period)
+    //! \param[in] timeConstant : the mechanical time constant of the motor (ticks, Q8)
+    void setParameters(uint8_t bandwidth, uint16_t timeConstant);
+
+    //! \brief setEnabled Enable or disable the observer (the estimate is reset)
+    //! \param[in] enabled : true to estimate the load
+    void setEnabled(bool enabled);
+
+    //! \brief isEnabled Check if the observer is enabled
+    inline bool isEnabled() { return _enabled; }
+
+    //! \brief reset Reset the estimate (the motor is stopped or not controlled by the PID)
+    void reset();
+
+    //! \brief update Estimate the load, to call at each tick before computing the command
+    //!
+    //! \param[in] speed : the measured speed (counter value of the tick)
+    //! \param[in] limit : the maximum estimate (absolute value, counter value)
+    //! \return the estimated load (counter value, to add to the command)
+    int16_t update(int16_t speed, int16_t limit);
+
+    //! \brief setCommand Give the command applied at this tick (used by the next update)
+    //! \param[in] command : the command, load compensation included (counter value)
+    inline void setCommand(int16_t command) { _lastCommand = command; }
+
+    //! \brief getEstimate Get the last estimate
+    //! \return the estimated load (counter value)
+    inline int16_t getEstimate() { return _estimate >> 8; }
+
+private:
+    int32_t  _estimate;     //!< The estimated load (Q8)
+    int16_t  _lastSpeed;    //!< The speed of the previous tick
+    int16_t  _lastCommand;  //!< The command of the previous tick
+    uint16_t _timeConstant; //!< The mechanical time constant (ticks, Q8)
+    uint8_t  _bandwidth;    //!< The filter gain per tick (Q8)
+    bool     _enabled;      //!< true if the observer is enabled
+    bool     _primed;       //!< true if the previous speed and command are known
+};
+
+#endif // DISTURBANCE_OBSERVER_H
@@ -0,0 +1,54 @@
+#include "encoder_health.h"
+#include "counter.h"
+
+EncoderHealth::EncoderHealth(uint8_t samplePeriod, uint8_t maxSpeed, uint8_t maxJump) :
+    _samplePeriod(samplePeriod),
+    _tickCount(0),
+    _maxSpeed(maxSpeed),
+    _maxJump(maxJump),
+    _lastVal(0),
+    _lastStatus(0)
+{
+    clear();
+}
+
+bool EncoderHealth::tick()
+{
+    if (++_tickCount < _samplePeriod) return false;
+    _tickCount = 0;
+    return true;
+}
+
+bool EncoderHealth::checkStatus(uint8_t status)
+{
+    _lastStatus = status;
+    if (status == 0xFF) {
+        // nothing else can be trusted
+        count(ENCODER_LINK);
+        return false;
+    }
+    if (!(status & STR_CEN)) count(ENCODER_DISABLED);
+    if (status & STR_PLS) count(ENCODER_POWER_LOSS);
+    if (status & (STR_CY | STR_BW)) count(ENCODER_WRAP);
+    return status & (STR_PLS | STR_CY | STR_BW);
+}
+
+void EncoderHealth::checkSpeed(int16_t val)
+{
+    int16_t jump = val - _lastVal;
+    _lastVal = val;
+    if (val > _maxSpeed || val < -_maxSpeed) count(ENCODER_OVERSPEED);
+    if (jump > _maxJump || jump < -_maxJump) count(ENCODER_JUMP);
+}
+
+void EncoderHealth::clear()
+{
+    for (uint8_t i=0; i<ENCODER_NB_ANOMALIES; i++) {
+        _counts[i] = 0;
+    }
+}
+
+void EncoderHealth::count(uint8_t anomaly)
+{
+    if (_counts[anomaly] != 0xFF) _counts[anomaly]++;
+}
@@ -0,0 +1,75 @@
+#ifndef ENCODER_HEALTH_H
+#define ENCODER_HEALTH_H
+
+//! \file encoder_health.h
+//! \brief EncoderHealth class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+// Anomalies (index of the counters)
+#define ENCODER_LINK            0   //!< The status register reads 0xFF (SPI link, MISO stuck high)
+#define ENCODER_DISABLED        1   //!< The counting is disabled (MDR1 lost, or MISO stuck low)
+#define ENCODER_POWER_LOSS      2   //!< The counter has been powered down (counter value and modes lost)
+#define ENCODER_WRAP            3   //!< The counter has wrapped (carry or borrow, not expected in 32 bits)
+#define ENCODER_OVERSPEED       4   //!< The counter value of a tick is over the motor maximum speed
+#define ENCODER_JUMP            5   //!< The counter value changed more than the motor can accelerate in a tick
+#define ENCODER_NB_ANOMALIES    6   //!< Number of anomalies
+
+//! \class EncoderHealth
+//! \brief EncoderHealth class.
+//!
+//! Encoder and counter diagnostics. The status register of the counter is sampled
+//! at a low rate (tick() tells when), and the counter value of each tick is checked
+//! against the motor model (maximum speed and acceleration). The anomalies are
+//! counted (saturated), a bad cable or noise shows up in the counters before the
+//! robot misbehaves.
+class EncoderHealth
+{
+public:
+
+    //! \brief EncoderHealth constructor
+    //!
+    //! \param[in] samplePeriod : the number of ticks between two status samples
+    //! \param[in] maxSpeed : the maximum counter value of a tick (absolute value)
+    //! \param[in] maxJump : the maximum change of the counter value between two ticks
+    EncoderHealth(uint8_t samplePeriod, uint8_t maxSpeed, uint8_t maxJump);
+
+    //! \brief tick Count the ticks, to call at each control tick
+    //! \return true if the status register has to be sampled (checkStatus)
+    bool tick();
+
+    //! \brief checkStatus Check a status register sample
+    //! \param[in] status : the status register (STR)
+    //! \return true if latched flags have to be cleared (CLR_STR)
+    bool checkStatus(uint8_t status);
+
+    //! \brief checkSpeed Check the counter value of a tick
+    //! \param[in] val : the counter value of the tick
+    void checkSpeed(int16_t val);
+
+    //! \brief getCount Get the number of occurrences of an anomaly (saturated)
+    //! \param[in] anomaly : ENCODER_XXX
+    inline uint8_t getCount(uint8_t anomaly) { return _counts[anomaly]; }
+
+    //! \brief getLastStatus Get the last status register sample
+    inline uint8_t getLastStatus() { return _lastStatus; }
+
+    //! \brief clear Reset the anomaly counters
+    void clear();
+
+private:
+    //! \brief count Count an anomaly
+    //! \param[in] anomaly : ENCODER_XXX
+    void count(uint8_t anomaly);
+
+    uint8_t _counts[ENCODER_NB_ANOMALIES]; //!< The number of occurrences of each anomaly
+    uint8_t _samplePeriod;  //!< The number of ticks between two status samples
+    uint8_t _tickCount;     //!< The ticks since the last status sample
+    uint8_t _maxSpeed;      //!< The maximum counter value of a tick
+    uint8_t _maxJump;       //!< The maximum change of the counter value between two ticks
+    int16_t _lastVal;       //!< The counter value of the previous tick
+    uint8_t _lastStatus;    //!< The last status register sample
+};
+
+#endif // ENCODER_HEALTH_H
@@ -0,0 +1,55 @@
+#include "encoder_index.h"
+
+EncoderIndex::EncoderIndex(uint16_t countsPerIndex, uint8_t tolerance) :
+    _lastIndex(0),
+    _countsPerIndex(1)
+{
+    setCountsPerIndex(countsPerIndex, tolerance);
+}
+
+void EncoderIndex::setCountsPerIndex(uint16_t countsPerIndex, uint8_t tolerance)
+{
+    if (countsPerIndex == 0) return;
+    _countsPerIndex = countsPerIndex;
+    _tolerance = tolerance;
+    _referenced = false;
+    _nbIndexes = 0;
+    _nbErrors = 0;
+    _lastError = 0;
+}
+
+// Called from the timer interruption
+void EncoderIndex::onIndex(int32_t count)
+{
+    _nbIndexes++;
+    if (_referenced) {
+        int32_t distance = count - _lastIndex;
+        if (distance < 0) distance = -distance;
+        // the next index (one revolution) or the same index again
+        int32_t error = (distance > _countsPerIndex/2) ? distance - _countsPerIndex : distance;
+        if (error > _tolerance || error < -(int16_t)_tolerance) {
+            if (error > 32767) error = 32767;
+            if (error < -32768) error = -32768;
+            _lastError = error;
+            if (_nbErrors != 0xFF) _nbErrors++;
+        }
+    }
+    // the next index is checked from this one
+    _lastIndex = count;
+    _referenced = true;
+}
+
+// Called from the timer interruption
+void EncoderIndex::onLostIndex()
+{
+    _nbIndexes++;
+    // the position of this index is not known, the next one is not checked
+    _referenced = false;
+}
+
+uint16_t EncoderIndex::getAngle(int32_t count)
+{
+    int32_t angle = (count - _lastIndex) % _countsPerIndex;
+    if (angle < 0) angle += _countsPerIndex;
+    return angle;
+}
@@ -0,0 +1,77 @@
+#ifndef ENCODER_INDEX_H
+#define ENCODER_INDEX_H
+
+//! \file encoder_index.h
+//! \brief EncoderIndex class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+//! \class EncoderIndex
+//! \brief EncoderIndex class.
+//!
+//! Index pulse tracking. The counter latches its value in the OTR at each index
+//! pulse (INDX_LOADO), this value is given to onIndex(). Two successive indexes
+//! are expected to be one revolution apart (the counts per index), or at the same
+//! position when the shaft turned back through the same index. Otherwise, counts
+//! have been missed (negative error) or added (positive error) by the counter,
+//! the error is recorded and the tracking restarts from this index.
+//! The latch position depends on the direction (the index pulse is a few counts
+//! wide), hence a tolerance.
+class EncoderIndex
+{
+public:
+
+    //! \brief EncoderIndex constructor
+    //!
+    //! \param[in] countsPerIndex : the number of counts between two indexes (one revolution)
+    //! \param[in] tolerance : the error (counts) accepted between two indexes
+    EncoderIndex(uint16_t countsPerIndex, uint8_t tolerance);
+
+    //! \brief setCountsPerIndex Change the parameters, and restart the tracking
+    //!
+    //! \param[in] countsPerIndex : the number of counts between two indexes (one revolution, ignored if 0)
+    //! \param[in] tolerance : the error (counts) accepted between two indexes
+    void setCountsPerIndex(uint16_t countsPerIndex, uint8_t tolerance);
+
+    //! \brief onIndex Check the position of an index
+    //!
+    //! \param[in] count : the counter value latched by the index
+    void onIndex(int32_t count);
+
+    //! \brief onLostIndex An index has been seen, but its latched value is lost
+    //!
+    //! The index is counted, not checked, and the tracking restarts from the next index
+    void onLostIndex();
+
+    //! \brief isReferenced Check if an index has been seen (the angle is known)
+    //! \return true if an index has been seen
+    inline bool isReferenced() { return _referenced; }
+
+    //! \brief getAngle Get the shaft angle
+    //!
+    //! \param[in] count : the current counter value
+    //! \return the angle from the last index (0 to counts per index - 1)
+    uint16_t getAngle(int32_t count);
+
+    //! \brief getNbIndexes Get the number of indexes seen (wrapping)
+    inline uint16_t getNbIndexes() { return _nbIndexes; }
+
+    //! \brief getNbErrors Get the number of indexes out of the tolerance (saturated)
+    inline uint8_t getNbErrors() { return _nbErrors; }
+
+    //! \brief getLastError Get the error of the last index out of the tolerance
+    //! \return the error (counts, negative for missing counts, positive for extra counts)
+    inline int16_t getLastError() { return _lastError; }
+
+private:
+    int32_t  _lastIndex;      //!< The counter value of the last index
+    uint16_t _countsPerIndex; //!< The number of counts between two indexes
+    uint8_t  _tolerance;      //!< The error accepted between two indexes
+    bool     _referenced;     //!< true if an index has been seen
+    uint16_t _nbIndexes;      //!< The number of indexes seen
+    uint8_t  _nbErrors;       //!< The number of indexes out of the tolerance
+    int16_t  _lastError;      //!< The error of the last index out of the tolerance
+};
+
+#endif // ENCODER_INDEX_H
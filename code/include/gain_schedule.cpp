@@ -0,0 +1,80 @@
+#include "gain_schedule.h"
+
+GainSchedule::GainSchedule(){
+    clear();
+}
+
+bool GainSchedule::setPoint(uint8_t direction, uint8_t index, uint16_t speed, uint16_t kp, uint16_t ki, uint16_t kd){
+    if (direction > GAIN_SCHEDULE_BACKWARD || index >= GAIN_SCHEDULE_MAX_POINTS) return false;
+    // the breakpoints must be given in order, by increasing speed
+    if (index > _nbPoints[direction]) return false;
+    if (index > 0 && _speed[direction][index-1] >= speed) return false;
+    if (index+1 < _nbPoints[direction] && _speed[direction][index+1] <= speed) return false;
+
+    _speed[direction][index] = speed;
+    _k[direction][index][0] = kp;
+    _k[direction][index][1] = ki;
+    _k[direction][index][2] = kd;
+    if (index >= _nbPoints[direction]) _nbPoints[direction] = index+1;
+
+    computeSlopes(direction);
+    return true;
+}
+
+void GainSchedule::clear(){
+    _nbPoints[GAIN_SCHEDULE_FORWARD] = 0;
+    _nbPoints[GAIN_SCHEDULE_BACKWARD] = 0;
+    _enabled = false;
+    _directional = false;
+}
+
+void GainSchedule::setEnabled(bool enabled, bool directional){
+    _enabled = enabled;
+    _directional = directional;
+}
+
+// The divisions are done here, not at each tick
+void GainSchedule::computeSlopes(uint8_t direction){
+    for (uint8_t i=0; i+1 < _nbPoints[direction]; i++) {
+        int32_t ds = _speed[direction][i+1] - _speed[direction][i];
+        for (uint8_t g=0; g<3; g++) {
+            int32_t dk = (int32_t)_k[direction][i+1][g] - _k[direction][i][g];
+            _slope[direction][i][g] = (dk << 8) / ds;
+        }
+    }
+}
+
+void GainSchedule::apply(Pid* pid, int16_t target, int16_t speed){
+    uint8_t direction = GAIN_SCHEDULE_FORWARD;
+    if (_directional && target < 0 && _nbPoints[GAIN_SCHEDULE_BACKWARD] != 0) {
+        direction = GAIN_SCHEDULE_BACKWARD;
+    }
+    uint8_t n = _nbPoints[direction];
+    if (n == 0) return;
+
+    uint16_t s = (speed < 0) ? -speed : speed;
+    const uint16_t* k;
+    int32_t gains[3];
+
+    if (s <= _speed[direction][0]) {
+        // below the first breakpoint
+        k = _k[direction][0];
+        gains[0] = k[0]; gains[1] = k[1]; gains[2] = k[2];
+    } else {
+        // find the segment
+        uint8_t i = 0;
+        while (i+1 < n && s >= _speed[direction][i+1]) i++;
+        k = _k[direction][i];
+        if (i+1 >= n) {
+            // above the last breakpoint
+            gains[0] = k[0]; gains[1] = k[1]; gains[2] = k[2];
+        } else {
+            int32_t ds = s - _speed[direction][i];
+            const int32_t* slope = _slope[direction][i];
+            gains[0] = k[0] + ((slope[0] * ds) >> 8);
+            gains[1] = k[1] + ((slope[1] * ds) >> 8);
+            gains[2] = k[2] + ((slope[2] * ds) >> 8);
+        }
+    }
+    pid->setGains(gains[0], gains[1], gains[2]);
+}
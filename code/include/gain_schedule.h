@@ -0,0 +1,80 @@
+#ifndef GAIN_SCHEDULE_H
+#define GAIN_SCHEDULE_H
+
+//! \file gain_schedule.h
+//! \brief GainSchedule class
+//! \date 2026 10 18
+
+#include <stdint.h>
+#include "pid.h"
+
+#define GAIN_SCHEDULE_MAX_POINTS    4   //!< Maximum number of breakpoints per direction
+
+#define GAIN_SCHEDULE_FORWARD       0   //!< Table used for positive targets
+#define GAIN_SCHEDULE_BACKWARD      1   //!< Table used for negative targets (if directional)
+
+//! \class GainSchedule
+//! \brief GainSchedule class.
+//!
+//! Speed dependent gains for the PID. The gains are given at breakpoints of
+//! measured speed (absolute counter value per tick), and linearly interpolated
+//! between them (constant below the first and above the last breakpoint).
+//! The slopes of each segment are computed when the table is changed, so
+//! that apply() only needs integer multiplications.
+//! The table can be shared by the two directions, or one table per direction.
+//! To save RAM, the scheduled gains are stored on 16 bits (Q16, below 1.0).
+class GainSchedule
+{
+public:
+
+    //! \brief GainSchedule constructor (empty table, disabled)
+    GainSchedule();
+
+    //! \brief setPoint Set a breakpoint of the table
+    //!
+    //! The breakpoints of a table must be given by increasing speed, the table
+    //! size is the highest index set + 1.
+    //!
+    //! \param[in] direction : GAIN_SCHEDULE_FORWARD or GAIN_SCHEDULE_BACKWARD
+    //! \param[in] index : index of the breakpoint (0 to GAIN_SCHEDULE_MAX_POINTS-1)
+    //! \param[in] speed : the measured speed of the breakpoint (counter value, absolute)
+    //! \param[in] kp : the P coefficient (Q16, see Pid)
+    //! \param[in] ki : the I coefficient (Q16)
+    //! \param[in] kd : the D coefficient (Q16)
+    //! \return false if the parameters are not valid (index, speed not increasing)
+    bool setPoint(uint8_t direction, uint8_t index, uint16_t speed, uint16_t kp, uint16_t ki, uint16_t kd);
+
+    //! \brief clear Remove all the breakpoints and disable the schedule
+    void clear();
+
+    //! \brief setEnabled Enable or disable the schedule
+    //!
+    //! \param[in] enabled : true to update the PID gains at each tick
+    //! \param[in] directional : true to use the backward table for negative targets
+    void setEnabled(bool enabled, bool directional=false);
+
+    //! \brief isEnabled Check if the schedule is enabled
+    //! \return true if enabled (and the forward table is not empty)
+    inline bool isEnabled() { return _enabled && _nbPoints[GAIN_SCHEDULE_FORWARD] != 0; }
+
+    //! \brief apply Set the PID gains for the current speed
+    //!
+    //! \param pid : pointer over the PID
+    //! \param[in] target : the target (its sign selects the table)
+    //! \param[in] speed : the measured speed (counter value)
+    void apply(Pid* pid, int16_t target, int16_t speed);
+
+private:
+    //! \brief computeSlopes Compute the slopes of the segments of a table
+    //! \param[in] direction : the table
+    void computeSlopes(uint8_t direction);
+
+    uint16_t _speed[2][GAIN_SCHEDULE_MAX_POINTS];  //!< The breakpoints speeds
+    uint16_t _k[2][GAIN_SCHEDULE_MAX_POINTS][3];   //!< The gains at the breakpoints (kp, ki, kd, Q16)
+    int32_t  _slope[2][GAIN_SCHEDULE_MAX_POINTS][3]; //!< The slopes to the next breakpoint (Q8 per counter unit)
+    uint8_t  _nbPoints[2];                         //!< The number of breakpoints of each table
+    bool     _enabled;                             //!< true if the schedule is enabled
+    bool     _directional;                         //!< true to use the backward table for negative targets
+};
+
+#endif // GAIN_SCHEDULE_H
@@ -6,52 +6,59 @@
 //! \author Remy Guyonneau, Philippe Lucidarme
 //! \date 2017 04 24
 
-#include <output.h>
+#include <util/delay.h>
+#include "output.h"
 
 //! \class Led
 //! \brief Led class. 
 //!
 //! LED class. This class inherit from Output and implements behavior of an LED.
-class Led : public Output
+//!
+//! \tparam PORT_ADDR : address of the PORTx register of the led pin (GPIO_PORTB...)
+//! \tparam PIN : The pin id of the led.
+//! \tparam POLARITY : The polarity of the led (1=on with high state)
+template<uint8_t PORT_ADDR, uint8_t PIN, uint8_t POLARITY>
+class Led : public Output<PORT_ADDR, PIN>
 {
 public:
     //! \brief Led constructor
     //!
-    //! LED constructor
-    //!
-    //! \param pport : pointer to a volatile int corresponding to the port of the led pin.
-    //! \param[in] pinmask : The pinmask for the led pin.
-    //! \param[in] polarity : The polarity of the led (1=on with high state)
-
-    Led(volatile uint8_t* pport, uint8_t pinmask, uint8_t polarity);
+    //! LED constructor (the LED is switched off)
+    Led() { Output<PORT_ADDR, PIN>::init(!POLARITY); }
 
     //! \brief Switch on the LED
     //!
     //! Switch on the LED
-    void on();
+    static inline void on() { setState(1); }
 
     //! \brief Switch off the LED
     //!
     //! Switch off the LED
-    void off();
+    static inline void off() { setState(0); }
 
     //! \brief Blink the LED
     //!
-    //! Blink the LED
+    //! Blink the LED (blocking, see LedPattern for the non blocking patterns)
     //!
     //! \param[in] delay The on/off delay (ms) for blinking
-    void blink(uint16_t delay=50);
+    static void blink(uint16_t delay=50) {
+        off();
+        for(uint16_t i=0; i<delay; i++)
+            _delay_ms(1);
+        on();
+        for(uint16_t i=0; i<delay; i++)
+            _delay_ms(1);
+        off();
+    }
 
     //! \brief Set LED State
     //!
     //! Set LED State (1: on, 0:off)
     //!
     //! \param[in] state : State to set (1: on, 0:off)
-    void setState(uint8_t state);
-
-private:
-
-    uint8_t _polarity; //!< Polarity of the LED. If polarity=1, the LED is ON on a high state
+    static inline void setState(uint8_t state) {
+        ((state != 0) == (POLARITY != 0)) ? Output<PORT_ADDR, PIN>::setHigh() : Output<PORT_ADDR, PIN>::setLow();
+    }
 };
 
 #endif // LED_H
@@ -0,0 +1,42 @@
+#include "led_pattern.h"
+
+LedPattern::LedPattern() :
+    _pattern(LED_PATTERN_OFF),
+    _current(LED_PATTERN_OFF),
+    _step(0),
+    _flash(0)
+{}
+
+void LedPattern::set(uint32_t pattern)
+{
+    if (pattern == _pattern) return;
+    _pattern = pattern;
+    _current = pattern;
+    _step = 0;
+}
+
+// The pattern is shifted instead of indexed (no variable 32 bits shift)
+uint8_t LedPattern::tick()
+{
+    uint8_t state = _current & 0x01;
+    _current >>= 1;
+    if (++_step >= 32) {
+        _step = 0;
+        _current = _pattern;
+    }
+    if (_flash) {
+        _flash--;
+        state = 1;
+    }
+    return state;
+}
+
+uint32_t LedPattern::blinkCode(uint8_t code)
+{
+    if (code > LED_PATTERN_CODE_MAX) code = LED_PATTERN_CODE_MAX;
+    uint32_t pattern = 0;
+    for (uint8_t i=0; i<code; i++) {
+        pattern = (pattern << 4) | 0x03;
+    }
+    return pattern;
+}
@@ -0,0 +1,59 @@
+#ifndef LED_PATTERN_H
+#define LED_PATTERN_H
+
+//! \file led_pattern.h
+//! \brief LedPattern class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+// Patterns of 32 steps, one step per tick (bit 0 first, 1: LED on)
+// with the 25ms timer tick (25.024ms), a pattern lasts 0.8s
+#define LED_PATTERN_OFF         0x00000000UL    //!< Always off
+#define LED_PATTERN_ON          0xFFFFFFFFUL    //!< Always on
+#define LED_PATTERN_HEARTBEAT   0x00000005UL    //!< Two short flashes, then a pause (alive)
+#define LED_PATTERN_CALIBRATION 0x33333333UL    //!< Fast regular blinking (calibration in progress)
+
+#define LED_PATTERN_CODE_MAX    6               //!< Maximum number of flashes of a blink code
+
+//! \class LedPattern
+//! \brief LedPattern class.
+//!
+//! Non blocking LED sequencer: a pattern is a 32 steps bit sequence, advanced by
+//! tick() from the periodic timer interruption, which returns the LED state to apply.
+//! A short flash (CAN activity...) can be overlaid on the pattern.
+class LedPattern
+{
+public:
+
+    //! \brief LedPattern constructor (LED_PATTERN_OFF)
+    LedPattern();
+
+    //! \brief set Set the pattern, restarted from its first step if it changed
+    //!
+    //! \param[in] pattern : the pattern (LED_PATTERN_XXX or blinkCode())
+    void set(uint32_t pattern);
+
+    //! \brief flash Switch the LED on for the next ticks, whatever the pattern
+    //!
+    //! \param[in] nbTicks : duration of the flash (ticks)
+    inline void flash(uint8_t nbTicks=1) { _flash = nbTicks; }
+
+    //! \brief tick Advance the pattern by one step
+    //! \return the LED state (1: on, 0: off)
+    uint8_t tick();
+
+    //! \brief blinkCode Build the pattern of a blink code (to count the flashes)
+    //!
+    //! \param[in] code : the number of flashes (bounded to LED_PATTERN_CODE_MAX, 0: off)
+    //! \return the pattern: the flashes (2 steps on, 2 steps off), then a pause
+    static uint32_t blinkCode(uint8_t code);
+
+private:
+    uint32_t _pattern;  //!< The pattern
+    uint32_t _current;  //!< The remaining steps of the pattern (shifted at each tick)
+    uint8_t  _step;     //!< The current step
+    uint8_t  _flash;    //!< The remaining ticks of the flash
+};
+
+#endif // LED_PATTERN_H
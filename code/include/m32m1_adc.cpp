@@ -0,0 +1,57 @@
+#include "m32m1_adc.h"
+
+// Constructor, do nothing
+M32m1_adc::M32m1_adc() :
+    _nbChannels(0),
+    _current(0)
+{}
+
+// Initialize the ADC
+void M32m1_adc::init(uint8_t prescaler)
+{
+    // AVcc as reference (the AREF pin is wired to VCC), right adjusted result
+    ADMUX  = (1<<REFS0);
+    // No auto trigger
+    ADCSRB = 0;
+    // Enable the ADC and the conversion complete interruption
+    ADCSRA = (1<<ADEN) | (1<<ADIE) | (prescaler & 0x07);
+}
+
+// Add a channel to the list of converted channels
+uint8_t M32m1_adc::addChannel(uint8_t mux)
+{
+    if (_nbChannels >= ADC_MAX_CHANNELS) return ADC_MAX_CHANNELS;
+    _channels[_nbChannels] = mux;
+    _values[_nbChannels] = 0;
+    _nbChannels++;
+    // no scan in progress
+    _current = _nbChannels;
+    return _nbChannels-1;
+}
+
+// Start the conversion of all the registered channels
+void M32m1_adc::startScan()
+{
+    if (isScanning() || _nbChannels == 0) return;
+    select(0);
+}
+
+// Store the last conversion and start the next one
+void M32m1_adc::onConversionComplete()
+{
+    _values[_current] = ADC;
+    if (_current+1 < _nbChannels) {
+        select(_current+1);
+    } else {
+        // end of the scan
+        _current = _nbChannels;
+    }
+}
+
+// Select the ADC input and start the conversion
+void M32m1_adc::select(uint8_t index)
+{
+    _current = index;
+    ADMUX  = (ADMUX & 0xE0) | (_channels[index] & 0x1F);
+    ADCSRA |= (1<<ADSC);
+}
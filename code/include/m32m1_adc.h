@@ -0,0 +1,83 @@
+#ifndef ADC_H
+#define ADC_H
+
+//! \file m32m1_adc.h
+//! \brief M32m1_adc class
+//! \date 2026 10 18
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <util/atomic.h>
+
+// Prescaler settings (ADC clock = CPU clock / prescaler, must be 50-200kHz for 10 bits)
+#define ADC_PRESCALER_32    0b101   //!< ADC clock = CPU clock / 32
+#define ADC_PRESCALER_64    0b110   //!< ADC clock = CPU clock / 64
+#define ADC_PRESCALER_128   0b111   //!< ADC clock = CPU clock / 128 (125kHz at 16MHz)
+
+// Maximum number of channels converted during a scan
+#define ADC_MAX_CHANNELS    4       //!< Size of the channel list
+
+//! \class M32m1_adc
+//! \brief M32m1_adc class.
+//!
+//! M32m1_adc class. To handle the ADC of the ATMega. The registered channels are
+//! converted one after the other (interrupt driven) each time a scan is started,
+//! so that the control loop never waits for a conversion: it reads the values of
+//! the previous scan.
+class M32m1_adc
+{
+public:
+
+    //!
+    //! \brief M32m1_adc Constructor, do nothing
+    //!
+    M32m1_adc();
+
+    //! \brief init Initialize the ADC (AVcc reference, right adjusted result,
+    //!             conversion complete interruption enabled)
+    //!
+    //! \param prescaler : Value for setting the ADC clock prescaler:
+    //!                         ADC_PRESCALER_32, ADC_PRESCALER_64 or ADC_PRESCALER_128
+    void init(uint8_t prescaler=ADC_PRESCALER_128);
+
+    //! \brief addChannel Add a channel to the list of converted channels
+    //!
+    //! \param[in] mux : The ADC input (0 to 10 for ADC0 to ADC10)
+    //! \return The index of the channel, to use with value(), or ADC_MAX_CHANNELS if the list is full
+    uint8_t addChannel(uint8_t mux);
+
+    //! \brief startScan Start the conversion of all the registered channels
+    //!                  Does nothing if the previous scan is not over
+    void startScan();
+
+    //! \brief onConversionComplete Store the last conversion and start the next one
+    //!                             Must be called from ISR(ADC_vect)
+    void onConversionComplete();
+
+    //! \brief value Get the last converted value of a channel
+    //!
+    //! \param[in] index : The index of the channel (returned by addChannel)
+    //! \return The last converted value (0 to 1023)
+    inline uint16_t value(uint8_t index) {
+        uint16_t value;
+        // not interrupted by the end of a conversion (nested interruptions)
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { value = _values[index]; }
+        return value;
+    }
+
+    //! \brief isScanning Check if a scan is in progress
+    //! \return true if a scan is in progress
+    inline bool isScanning() { return _current < _nbChannels; }
+
+private:
+    //! \brief select Select the ADC input and start the conversion
+    //! \param[in] index : The index of the channel to convert
+    void select(uint8_t index);
+
+    uint8_t           _channels[ADC_MAX_CHANNELS]; //!< The ADC inputs to convert
+    volatile uint16_t _values[ADC_MAX_CHANNELS];   //!< The last converted values
+    uint8_t           _nbChannels;                 //!< Number of registered channels
+    volatile uint8_t  _current;                    //!< Index of the channel being converted
+};
+
+#endif // ADC_H
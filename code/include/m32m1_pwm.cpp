@@ -1,8 +1,15 @@
+#include <util/atomic.h>
 #include "m32m1_pwm.h"
 
 
 // Constructor, do nothing
-M32m1_pwm::M32m1_pwm()
+M32m1_pwm::M32m1_pwm() :
+    _offsetNs(0),
+    _minPulseNs(0),
+    _offsetNbCycles(0),
+    _minPulseNbCycles(0),
+    _dutyError(0),
+    _clockPending(false)
 {}
 
 
@@ -22,26 +29,33 @@ void M32m1_pwm::init(uint8_t    prescaler,
     PMIC2 &= ~(1<<POVEN2);
 
     // Set the requested prescaler
+    _prescaler=prescaler;
     this->setPrescaler(prescaler);
     // Set the requested sourceClock
+    _sourceClock=sourceClock;
     this->setSourceClock(sourceClock);
 
     // Store the number of dead cycles
     _deadTimeNbCycles=deadTimeNumberCycles;
     // Set the counter maximum value
     this->setCounterMax(counterMaximum);
+    // Known state of the duty-cycle registers (see updateOutputs)
+    this->setDutyCycle0(0);
+    this->setDutyCycle1(0);
+    this->setDutyCycle2(0);
 
     // For ADC synchronisation
     POCR0RA=1;
 
     // Configure PSC (lock, center aligned mode, outputs active high
     PCNF = (1<<PULOCK) | (1<<PMODE) | (1<<POPB) | (1<<POPA);
+    _polarityBInverted=false;
 
     // reste the PSC Complete Cycle bit
     PCTL &= ~(1<<PCCYC);
 
-    // Start the PSC
-    PCTL |= (1<<PRUN);
+    // Start the PSC (now, or when the PLL is locked, see poll)
+    this->poll();
 }
 
 
@@ -64,25 +78,46 @@ void M32m1_pwm::setSourceClock(uint8_t sourceClock)
     case PWM_SOURCE_CLK_CPU_CLK :
         _pll.stop();
         PCTL &= ~(1<<PCLKSEL);
+        _clockPending = false;
         break;
 
     case PWM_SOURCE_CLK_PLL_32MHZ :
         _pll.setFrequency(PLL_FREQUENCY_32MHZ);
         _pll.start();
-        while (!_pll.isReady());
-        PCTL |= (1<<PCLKSEL);
+        // the PLL clock is selected by poll once locked
+        _clockPending = true;
         break;
 
     case PWM_SOURCE_CLK_PLL_64MHZ :
         _pll.setFrequency(PLL_FREQUENCY_64MHZ);
         _pll.start();
-        while (!_pll.isReady());
-        PCTL |= (1<<PCLKSEL);
+        // the PLL clock is selected by poll once locked
+        _clockPending = true;
         break;
     }
 }
 
 
+// Select the PLL clock when locked, and start the PSC
+bool M32m1_pwm::poll()
+{
+    // PCTL is also written by setFrequency (from an interruption)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (_clockPending) {
+            if (!_pll.isReady()) return false;
+            PCTL |= (1<<PCLKSEL);
+            _clockPending = false;
+        }
+        if (!isRunning()) {
+            PCTL |= (1<<PRUN);
+            // the outputs are driven again once the PSC runs (see setFrequency)
+            POC = _config;
+        }
+    }
+    return true;
+}
+
+
 // Set the maximum value for the counter (output compare match)
 void M32m1_pwm::setCounterMax(uint16_t counterMaximum)
 {
@@ -93,10 +128,154 @@ void M32m1_pwm::setCounterMax(uint16_t counterMaximum)
 }
 
 
+// PSC clock frequency (source clock divided by the prescaler)
+uint32_t M32m1_pwm::clockFrequency(uint8_t prescaler, uint8_t sourceClock)
+{
+    uint32_t clock;
+    switch (sourceClock)
+    {
+    case PWM_SOURCE_CLK_PLL_64MHZ : clock = 64000000UL; break;
+    case PWM_SOURCE_CLK_PLL_32MHZ : clock = 32000000UL; break;
+    default :                       clock = F_CPU;      break;
+    }
+    switch (prescaler)
+    {
+    case PWM_PRESCALER_4 :   return clock/4;
+    case PWM_PRESCALER_32 :  return clock/32;
+    case PWM_PRESCALER_256 : return clock/256;
+    default :                return clock;
+    }
+}
+
+
+// Find the PSC settings giving the best resolution for a PWM frequency
+bool M32m1_pwm::computeSettings(uint32_t frequency, uint16_t deadTimeNs, M32m1_pwm_settings* settings)
+{
+    static const uint8_t sources[3]    = {PWM_SOURCE_CLK_PLL_64MHZ, PWM_SOURCE_CLK_PLL_32MHZ, PWM_SOURCE_CLK_CPU_CLK};
+    static const uint8_t prescalers[4] = {PWM_PRESCALER_NONE, PWM_PRESCALER_4, PWM_PRESCALER_32, PWM_PRESCALER_256};
+    bool found = false;
+
+    if (frequency == 0) return false;
+
+    for (uint8_t s=0; s<3; s++) {
+        for (uint8_t p=0; p<4; p++) {
+            uint32_t clock = clockFrequency(prescalers[p], sources[s]);
+            // dead-time cycles, rounded up (deadTimeNs * clock / 10^9 without overflow)
+            uint32_t deadTime = ((uint32_t)deadTimeNs * (clock/1000UL) + 999999UL) / 1000000UL;
+            if (deadTime == 0) deadTime = 1;
+            // center aligned mode: one PWM period is 2 * (counter max + dead-time) cycles
+            uint32_t period = clock / (2*frequency);
+            if (period > PWM_COUNTER_LIMIT+1 || period < PWM_COUNTER_MAX_MIN + deadTime) continue;
+            uint16_t counterMax = period - deadTime;
+            if (!found || counterMax > settings->counterMax) {
+                settings->prescaler = prescalers[p];
+                settings->sourceClock = sources[s];
+                settings->deadTimeNbCycles = deadTime;
+                settings->counterMax = counterMax;
+                settings->frequency = clock / (2*period);
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+
+// Set the PWM frequency, keeping the dead-time duration
+uint16_t M32m1_pwm::setFrequency(uint32_t frequency)
+{
+    // Current dead-time duration (ns)
+    uint32_t clock = clockFrequency(_prescaler, _sourceClock);
+    uint16_t deadTimeNs = ((uint32_t)_deadTimeNbCycles * 1000000UL) / (clock/1000UL);
+
+    M32m1_pwm_settings settings;
+    if (!computeSettings(frequency, deadTimeNs, &settings)) return 0;
+
+    // Outputs inactive (the configuration is kept in _config): a stopped PSC
+    // holds its outputs, a high side could stay on until the PLL is locked
+    POC = PWM_CONFIG_DISABLE_ALL;
+    // Lock the updates and stop the PSC during the change
+    this->lock();
+    PCTL &= ~(1<<PRUN);
+
+    _prescaler=settings.prescaler;
+    this->setPrescaler(_prescaler);
+    if (settings.sourceClock != _sourceClock) {
+        _sourceClock=settings.sourceClock;
+        this->setSourceClock(_sourceClock);
+    }
+    _deadTimeNbCycles=settings.deadTimeNbCycles;
+    this->setCounterMax(settings.counterMax);
+    // The compensation durations are converted with the new clock
+    this->setDutyCompensation(_offsetNs, _minPulseNs);
+    // The duty-cycles are no more valid, outputs to 0 until the next update
+    this->setDutyCycle0(0);
+    this->setDutyCycle1(0);
+    this->setDutyCycle2(0);
+
+    // Restart the PSC (now, or when the PLL is locked, see poll)
+    this->poll();
+    this->unlock();
+    return _counterMax;
+}
+
+
+// Get the PWM frequency
+uint32_t M32m1_pwm::getFrequency()
+{
+    return clockFrequency(_prescaler, _sourceClock) / (2UL*(_counterMax+_deadTimeNbCycles));
+}
+
+
+// Convert a duration to a number of PSC cycles
+uint16_t M32m1_pwm::nsToCycles(uint16_t ns)
+{
+    uint32_t clock = clockFrequency(_prescaler, _sourceClock);
+    return ((uint32_t)ns * (clock/1000UL) + 500000UL) / 1000000UL;
+}
+
+
+// Set the low-duty linearization
+void M32m1_pwm::setDutyCompensation(uint16_t offsetNs, uint16_t minPulseNs)
+{
+    _offsetNs=offsetNs;
+    _minPulseNs=minPulseNs;
+    _offsetNbCycles=nsToCycles(offsetNs);
+    _minPulseNbCycles=nsToCycles(minPulseNs);
+    _dutyError=0;
+}
+
+
+// Apply the low-duty linearization to a duty-cycle
+uint16_t M32m1_pwm::compensate(uint16_t dutyCycle)
+{
+    if (dutyCycle == 0) {
+        _dutyError = 0;
+        return 0;
+    }
+    // Pulses shorter than the minimum width are skipped: a minimum pulse gives
+    // _minPulseNbCycles - _offsetNbCycles of effective duty-cycle, set once the skipped
+    // updates have requested as much (then the average is the requested duty-cycle)
+    if (dutyCycle + _offsetNbCycles < _minPulseNbCycles) {
+        uint16_t pulse = _minPulseNbCycles - _offsetNbCycles;
+        _dutyError += dutyCycle;
+        if (_dutyError < pulse) return 0;
+        _dutyError -= pulse;
+        return _minPulseNbCycles;
+    }
+    _dutyError = 0;
+    // Compensation of the voltage lost at each switching
+    dutyCycle += _offsetNbCycles;
+    if (dutyCycle > _counterMax) dutyCycle = _counterMax;
+    return dutyCycle;
+}
+
+
 // Set new duty-cycle for PWM 0
 void M32m1_pwm::setDutyCycle0(uint16_t dutyCycle)
 {    
     if (dutyCycle>_counterMax) dutyCycle=_counterMax;
+    _dutyCycle[0]=dutyCycle;
     POCR0SA=dutyCycle;
     POCR0SB=dutyCycle+_deadTimeNbCycles;    
 }
@@ -105,6 +284,7 @@ void M32m1_pwm::setDutyCycle0(uint16_t dutyCycle)
 void M32m1_pwm::setDutyCycle1(uint16_t dutyCycle)
 {
     if (dutyCycle>_counterMax) dutyCycle=_counterMax;
+    _dutyCycle[1]=dutyCycle;
     POCR1SA=dutyCycle;
     POCR1SB=dutyCycle+_deadTimeNbCycles;
 }
@@ -113,10 +293,49 @@ void M32m1_pwm::setDutyCycle1(uint16_t dutyCycle)
 void M32m1_pwm::setDutyCycle2(uint16_t dutyCycle)
 {
     if (dutyCycle>_counterMax) dutyCycle=_counterMax;
+    _dutyCycle[2]=dutyCycle;
     POCR2SA=dutyCycle;
     POCR2SB=dutyCycle+_deadTimeNbCycles;
 }
 
+// Select the polarity of the B outputs
+void M32m1_pwm::setOutputPolarityB(bool inverted)
+{
+    if (inverted == _polarityBInverted) return;
+    // No cross conduction with the previous configuration: outputs inactive first
+    this->setOutputConfiguration(PWM_CONFIG_DISABLE_ALL);
+    _polarityBInverted=inverted;
+    if (inverted) PCNF &= ~(1<<POPB);
+    else          PCNF |=  (1<<POPB);
+}
+
+// Set the output configuration and the duty-cycles of PWM 0 and 1 (only the changes)
+void M32m1_pwm::updateOutputs(uint8_t config, uint16_t dutyCycle0, uint16_t dutyCycle1)
+{
+    if (dutyCycle0>_counterMax) dutyCycle0=_counterMax;
+    if (dutyCycle1>_counterMax) dutyCycle1=_counterMax;
+
+    // Nothing changed, nothing to write
+    if (config==_config && dutyCycle0==_dutyCycle[0] && dutyCycle1==_dutyCycle[1]) return;
+
+    // Lock PWM, all the updated parameters are set simultaneously when unlocking
+    this->lock();
+    if (config!=_config) {
+        this->setOutputConfiguration(config);
+    }
+    if (dutyCycle0!=_dutyCycle[0]) {
+        _dutyCycle[0]=dutyCycle0;
+        POCR0SA=dutyCycle0;
+        POCR0SB=dutyCycle0+_deadTimeNbCycles;
+    }
+    if (dutyCycle1!=_dutyCycle[1]) {
+        _dutyCycle[1]=dutyCycle1;
+        POCR1SA=dutyCycle1;
+        POCR1SB=dutyCycle1+_deadTimeNbCycles;
+    }
+    this->unlock();
+}
+
 
 
 
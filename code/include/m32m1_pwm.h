@@ -9,20 +9,21 @@
 #include <avr/io.h>
 #include <stdint.h>
 #include "m32m1_pll.h"
+#include "pin.h"
 
-#define PSCOUT0A_PORT   PORTD   //!< TODO
+#define PSCOUT0A_PORT   GPIO_PORTD   //!< TODO
 #define PSCOUT0A_PIN    0       //!< TODO
-#define PSCOUT0B_PORT   PORTB   //!< TODO
+#define PSCOUT0B_PORT   GPIO_PORTB   //!< TODO
 #define PSCOUT0B_PIN    7       //!< TODO
 
-#define PSCOUT1A_PORT   PORTC   //!< TODO
+#define PSCOUT1A_PORT   GPIO_PORTC   //!< TODO
 #define PSCOUT1A_PIN    0       //!< TODO
-#define PSCOUT1B_PORT   PORTB   //!< TODO
+#define PSCOUT1B_PORT   GPIO_PORTB   //!< TODO
 #define PSCOUT1B_PIN    6       //!< TODO
 
-#define PSCOUT2A_PORT   PORTB   //!< TODO
+#define PSCOUT2A_PORT   GPIO_PORTB   //!< TODO
 #define PSCOUT2A_PIN    0       //!< TODO
-#define PSCOUT2B_PORT   PORTB   //!< TODO
+#define PSCOUT2B_PORT   GPIO_PORTB   //!< TODO
 #define PSCOUT2B_PIN    1       //!< TODO
 
 
@@ -47,6 +48,14 @@
 #define PWM_COUNTER_MAX_DEFAULT 2048        //!< TODO
 
 
+// Minimum value for the PSC counter maximum accepted by setFrequency (duty resolution)
+#define PWM_COUNTER_MAX_MIN     64          //!< Minimum counter maximum (6 bits of resolution)
+
+
+// Maximum value of the PSC output compare registers (12 bits)
+#define PWM_COUNTER_LIMIT       4095        //!< POCR_RB maximum value
+
+
 // When the function pwm_setOutputConfiguration is called with this parameter,
 // all the PWM are disable.
 #define PWM_CONFIG_DISABLE_ALL  0b000000    //!< TODO
@@ -54,6 +63,18 @@
 
 
 
+//! \struct M32m1_pwm_settings
+//! \brief PSC settings for a PWM frequency (see M32m1_pwm::computeSettings)
+struct M32m1_pwm_settings
+{
+    uint8_t  prescaler;        //!< PWM_PRESCALER_NONE, PWM_PRESCALER_4, PWM_PRESCALER_32 or PWM_PRESCALER_256
+    uint8_t  sourceClock;      //!< PWM_SOURCE_CLK_CPU_CLK, PWM_SOURCE_CLK_PLL_32MHZ or PWM_SOURCE_CLK_PLL_64MHZ
+    uint8_t  deadTimeNbCycles; //!< Number of cycles for the dead-time
+    uint16_t counterMax;       //!< Counter maximum, this is the duty-cycle resolution
+    uint32_t frequency;        //!< Achieved PWM frequency (Hz)
+};
+
+
 //! \class M32m1_pwm
 //! \brief M32m1_pwm class. 
 //!
@@ -110,9 +131,24 @@ public:
     //!                         PWM_SOURCE_CLK_CPU_CLK      => select the slow clock input (CLKIO).
     //!                         PWM_SOURCE_CLK_PLL_32MHZ    => select the fast clock input (CLKPLL) at 32MHz.
     //!                         PWM_SOURCE_CLK_PLL_64MHZ    => select the fast clock input (CLKPLL) at 64MHz.
+    //!                         The PLL is started but not waited for: the fast clock is
+    //!                         selected (and the PSC started) by poll() once it is locked
     void setSourceClock(uint8_t sourceClock);
 
 
+    //!
+    //! \brief poll             Finish the source clock selection when the PLL is locked
+    //!                         (select the PLL clock and start the PSC), to be called
+    //!                         until it returns true after init, setSourceClock or setFrequency
+    //! \return                 true if the PSC is running with the requested source clock
+    bool poll();
+
+    //!
+    //! \brief isRunning        Check if the PSC is running (nothing to poll)
+    //! \return                 true if the PSC is running with the requested source clock
+    inline bool isRunning() { return PCTL & (1<<PRUN); }
+
+
     //!
     //! \brief setCounterMax        Set the maximum value fo the PWM counter (output compare match)
     //! \param counterMaximum       Maximum value, this is also equal to the duty-cycle maximum
@@ -120,13 +156,104 @@ public:
     void setCounterMax(uint16_t counterMaximum);
 
 
+    //!
+    //! \brief computeSettings  Find the PSC settings for a PWM frequency
+    //!                         The combination of source clock and prescaler giving
+    //!                         the highest counter maximum (duty resolution) is selected
+    //! \param frequency        Requested PWM frequency (Hz)
+    //! \param deadTimeNs       Dead-time duration (ns), converted to a number of cycles
+    //! \param settings         Computed settings (not modified if no combination is possible)
+    //! \return                 true if a combination gives at least PWM_COUNTER_MAX_MIN
+    static bool computeSettings(uint32_t frequency, uint16_t deadTimeNs, M32m1_pwm_settings* settings);
+
+
+    //!
+    //! \brief setFrequency     Set the PWM frequency, keeping the dead-time duration
+    //!                         The PSC is stopped during the change, with its outputs
+    //!                         inactive until poll restarts it, the duty-cycles
+    //!                         must be set again afterwards (see Motor_dc::setPwmFrequency)
+    //! \param frequency        Requested PWM frequency (Hz)
+    //! \return                 The new counter maximum (duty resolution), 0 if the frequency
+    //!                         is not possible (nothing is changed)
+    uint16_t setFrequency(uint32_t frequency);
+
+
+    //!
+    //! \brief getFrequency     Get the PWM frequency
+    //! \return                 The PWM frequency (Hz)
+    uint32_t getFrequency();
+
+
+    //!
+    //! \brief setDutyCompensation  Set the low-duty linearization (disabled with 0, 0)
+    //!                             The output voltage is reduced by the switching delays
+    //!                             of the drivers and MOSFETs, and the pulses shorter than
+    //!                             the minimum width are lost: without compensation the
+    //!                             output is not linear around a zero duty-cycle
+    //! \param offsetNs             Calibrated duration (ns) added to any non-zero duty-cycle
+    //! \param minPulseNs           Minimum pulse width (ns), shorter pulses are skipped:
+    //!                             the minimum pulse is set at some updates only, 0 at
+    //!                             the others, so that the average duty-cycle over the
+    //!                             updates is the requested one (see compensate)
+    void setDutyCompensation(uint16_t offsetNs, uint16_t minPulseNs);
+
+
+    //!
+    //! \brief compensate       Apply the low-duty linearization to a duty-cycle
+    //!                         Called once per update of the outputs: a duty-cycle under
+    //!                         the minimum pulse is dithered over the updates (first order
+    //!                         sigma-delta, the error is carried to the next update). At
+    //!                         one update per tick the dithering period is a few ticks,
+    //!                         filtered by the motor (the minimum pulse is a small part
+    //!                         of the PWM period)
+    //! \param dutyCycle        Requested duty-cycle (0 to counter maximum)
+    //! \return                 The duty-cycle to set (0 stays 0)
+    uint16_t compensate(uint16_t dutyCycle);
+
+
+    //!
+    //! \brief getCounterMax    Get the maximum value of the PWM counter
+    //! \return                 The counter maximum, this is also the duty-cycle maximum (100%)
+    inline uint16_t getCounterMax() { return _counterMax; }
+
+
     //!
     //! \brief setOutputConfiguration   Enable or disable each PWM channel
+    //!                                 While the PSC is stopped, the channels are only enabled
+    //!                                 when it is started again (see poll)
     //! \param Config                   This variable is composed of 6 bits :
     //!                                 | 0 | 0 | 2B | 2A | 1B | 1A | 0B | 0A |
     //!                                 For exemple, 0b00001010 enable channel 0B and 1B
     //!                                 all the other channels are desactivated.
-    inline void setOutputConfiguration(uint8_t Config) { POC=Config; }
+    inline void setOutputConfiguration(uint8_t Config) {
+        _config=Config;
+        if (Config==PWM_CONFIG_DISABLE_ALL || isRunning()) POC=Config;
+    }
+
+
+    //!
+    //! \brief setOutputPolarityB   Select the polarity of the B outputs
+    //!                             Not inverted (default): the B output of a channel is the complement
+    //!                             of its A output, with the dead-times. Inverted: the B output is
+    //!                             active while the counter is under POCRnSB, in the window of the A
+    //!                             output (plus the dead-time), to drive the opposite low side with a
+    //!                             high side. Both outputs of a channel must never be enabled while
+    //!                             inverted (cross conduction). The outputs are disabled on a change
+    //!                             (enabled again by the next updateOutputs), nothing is done otherwise
+    //! \param inverted             true to invert the B outputs
+    void setOutputPolarityB(bool inverted);
+
+
+    //!
+    //! \brief updateOutputs    Set the output configuration and the duty-cycles of PWM 0 and 1
+    //!                         Only the registers that changed are written, in one lock/unlock
+    //!                         window (nothing is done if nothing changed). Its AVR cycles, and
+    //!                         those of Motor_dc::setSpeed, are update_outputs and set_speed of
+    //!                         make cycles (tools/cycles), to compare with set_speed before it
+    //! \param config           Output configuration (see setOutputConfiguration)
+    //! \param dutyCycle0       Duty-cycle value for PWM 0 (bounded to the counter maximum)
+    //! \param dutyCycle1       Duty-cycle value for PWM 1 (bounded to the counter maximum)
+    void updateOutputs(uint8_t config, uint16_t dutyCycle0, uint16_t dutyCycle1);
 
 
     //!
@@ -184,13 +311,35 @@ public:
     //!                                      For exemple, 0b00001010 enable channel 0B and 1B
     //!                                      all the other channels are desactivated.
     //!
-    inline void pwm_setOutputConfiguration(unsigned char Config) { POC=Config; }
+    inline void pwm_setOutputConfiguration(unsigned char Config) { setOutputConfiguration(Config); }
 
 
 private:
+    //! \brief clockFrequency   Get the PSC clock frequency (after the prescaler)
+    //! \param prescaler        The prescaler setting
+    //! \param sourceClock      The source clock setting
+    //! \return                 The PSC clock frequency (Hz)
+    static uint32_t clockFrequency(uint8_t prescaler, uint8_t sourceClock);
+
+    //! \brief nsToCycles       Convert a duration to a number of PSC cycles (rounded)
+    //! \param ns               The duration (ns)
+    //! \return                 The number of cycles with the current settings
+    uint16_t nsToCycles(uint16_t ns);
+
     M32m1_pll _pll; //!< Internal PLL, can be used as source clock
     volatile uint8_t _deadTimeNbCycles; //!< Current dead-time
     uint16_t _counterMax; //!< Current counter max (PSC Output Compare Registers)
+    uint8_t _prescaler; //!< Current prescaler setting
+    uint8_t _sourceClock; //!< Current source clock setting
+    uint8_t _config; //!< Shadow of the output configuration register (POC)
+    bool _polarityBInverted; //!< The B outputs are inverted (POPB cleared, see setOutputPolarityB)
+    uint16_t _dutyCycle[3]; //!< Shadow of the duty-cycles (POCRnSA, POCRnSB is POCRnSA + dead-time)
+    uint16_t _offsetNs; //!< Duty-cycle compensation offset (ns)
+    uint16_t _minPulseNs; //!< Minimum pulse width (ns)
+    uint16_t _offsetNbCycles; //!< Duty-cycle compensation offset (cycles)
+    uint16_t _minPulseNbCycles; //!< Minimum pulse width (cycles)
+    uint16_t _dutyError; //!< Duty-cycle requested but not set yet by the skipped pulses (cycles)
+    volatile bool _clockPending; //!< true while waiting for the PLL lock (PSC not started)
 
 };
 
@@ -1,3 +1,4 @@
+#include <util/atomic.h>
 #include "motor_dc.h"
 #include "output.h"
 
@@ -8,15 +9,18 @@ Motor_dc::Motor_dc(M32m1_pwm* ppwm,
                    unsigned char deadTimeNumberCycles){
     _ppwm = ppwm;
     _duty_cycle = 0;
+    _duty_limit = MOTOR_SPEED_MAX;
     _rotationCW = 0x00;
     _defaultRotation = defaultRotation;
+    _enabled = false;
+    _driveMode = DRIVE_MODE_SLOW_DECAY;
     
     // Configure ports as output and set low for MOSFET Drivers
     // (disactivate all transistors)
-    Output pscout0A (&PSCOUT0A_PORT,PSCOUT0A_PIN); pscout0A.setLow();
-    Output pscout0B (&PSCOUT0B_PORT,PSCOUT0B_PIN); pscout0B.setLow();
-    Output pscout1A (&PSCOUT1A_PORT,PSCOUT1A_PIN); pscout1A.setLow();
-    Output pscout1B (&PSCOUT1B_PORT,PSCOUT1B_PIN); pscout1B.setLow();
+    Output<PSCOUT0A_PORT,PSCOUT0A_PIN>::init(false);
+    Output<PSCOUT0B_PORT,PSCOUT0B_PIN>::init(false);
+    Output<PSCOUT1A_PORT,PSCOUT1A_PIN>::init(false);
+    Output<PSCOUT1B_PORT,PSCOUT1B_PIN>::init(false);
 
     _ppwm->init(prescaler,sourceClock,deadTimeNumberCycles);
 }
@@ -32,12 +36,16 @@ void Motor_dc::enableMotor()
     //timer1_attachInterrupt(onInterruptTimer1);
     // unlock PSC module
     _ppwm->unlock();
+    // allow the commutation
+    _enabled = true;
 }
 
 
 // Disable the motor (phase are disconnected)
 void Motor_dc::disableMotor()
 {
+    // Stop the commutation (setSpeed will not re-enable the PWM outputs)
+    _enabled = false;
     // Lock PSC module
     _ppwm->lock();
     // Open the bottom transistors in the H-Bridge
@@ -51,6 +59,8 @@ void Motor_dc::disableMotor()
 // Brakes the motor, each phase is connected to the ground
 void Motor_dc::brakeMotor()
 {
+    // Stop the commutation (setSpeed will not re-enable the PWM outputs)
+    _enabled = false;
     // Lock PSC module
     _ppwm->lock();
     // Disable PWM from pins (outputs are standard ports)
@@ -76,29 +86,99 @@ void Motor_dc::setSpeed(int speed)
     }else{
         _duty_cycle = speed;
     }
+    if(_duty_cycle > _duty_limit) _duty_cycle = _duty_limit;
 
     this->commutation();
 }
 
+// Change the PWM frequency
+uint16_t Motor_dc::setPwmFrequency(uint32_t frequency)
+{
+    uint16_t counterMax = _ppwm->setFrequency(frequency);
+    if (counterMax != 0) {
+        // the duty cycle registers have been reset
+        this->commutation();
+    }
+    return counterMax;
+}
+
+// Set the low-duty linearization of the PWM
+void Motor_dc::setDutyCompensation(uint16_t offsetNs, uint16_t minPulseNs)
+{
+    _ppwm->setDutyCompensation(offsetNs, minPulseNs);
+    this->commutation();
+}
+
+// Select the drive mode
+void Motor_dc::setDriveMode(uint8_t mode)
+{
+    if (mode > DRIVE_MODE_FAST_DECAY) return;
+    _driveMode = mode;
+    // Only the fast decay drives the B outputs with the A outputs (never both outputs of a channel),
+    // the outputs are disabled by a change of polarity and enabled again by the commutation
+    _ppwm->setOutputPolarityB(mode == DRIVE_MODE_FAST_DECAY);
+    this->commutation();
+}
+
 // This function manage phase commutation
 void Motor_dc::commutation()
 {
-    // Lock PWM to avoid transtory unexpected changes
-    _ppwm->lock();
-    _ppwm->setOutputConfiguration(0b001111);
-    // Commute according to the requested rotation direction,
-    if (_rotationCW)
+    uint16_t counterMax = _ppwm->getCounterMax();
+    uint16_t duty0, duty1;
+    uint8_t  config;
+
+    if (_driveMode == DRIVE_MODE_LOCKED_ANTIPHASE)
     {
-        // ClockWise
-        _ppwm->setDutyCycle0(_duty_cycle);
-        _ppwm->setDutyCycle1(0);
+        // Both half-bridges switch in opposition around 50%,
+        // the difference of the duty cycles gives the motor voltage
+        uint16_t half = ((uint32_t)_duty_cycle * counterMax) >> (MOTOR_SPEED_SHIFT+1);
+        uint16_t middle = counterMax >> 1;
+        duty0 = _rotationCW ? middle + half : middle - half;
+        duty1 = _rotationCW ? middle - half : middle + half;
+        config = 0b001111;
     }
     else
     {
-        // Counter ClockWise
-        _ppwm->setDutyCycle0(0);
-        _ppwm->setDutyCycle1(_duty_cycle);
+        // Sign-magnitude: one half-bridge is switched, the other one has its low side closed
+        // Duty cycle scaled to the counter maximum of the PWM
+        uint16_t dutyCycle = ((uint32_t)_duty_cycle * counterMax) >> MOTOR_SPEED_SHIFT;
+        // Linearization around 0, on the driven half-bridge (the sign of the current follows the command)
+        dutyCycle = _ppwm->compensate(dutyCycle);
+        // Commute according to the requested rotation direction,
+        duty0 = _rotationCW ? dutyCycle : 0;
+        duty1 = _rotationCW ? 0 : dutyCycle;
+
+        if (_driveMode == DRIVE_MODE_FAST_DECAY)
+        {
+            // High side of the switched half-bridge and low side of the other one (inverted B output)
+            // closed together, all the transistors open at 0 (the motor coasts)
+            duty0 = dutyCycle;
+            duty1 = dutyCycle;
+            if (dutyCycle == 0)       config = PWM_CONFIG_DISABLE_ALL;
+            else if (_rotationCW)     config = 0b001001; // 0A and 1B
+            else                      config = 0b000110; // 1A and 0B
+        }
+        else if (_driveMode == DRIVE_MODE_ASYNC_DECAY)
+        {
+            // Low side of the switched half-bridge not driven (freewheeling through its diode
+            // and the closed low side of the other one), all the transistors open at 0 (the motor coasts)
+            if (dutyCycle == 0)       config = PWM_CONFIG_DISABLE_ALL;
+            else if (_rotationCW)     config = 0b001001; // 0A and 1B
+            else                      config = 0b000110; // 1A and 0B
+        }
+        else
+        {
+            // Complementary switching of the driven half-bridge,
+            // both low sides closed at 0 (the motor brakes)
+            config = 0b001111;
+        }
+    }
+
+    // Only the changed registers are written, in one lock/unlock window
+    // (the PWM is locked to avoid transtory unexpected changes)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        // The motor has been disabled or braked (possibly by the overcurrent trip
+        // interruption), the outputs must stay as they are
+        if (_enabled) _ppwm->updateOutputs(config, duty0, duty1);
     }
-    // Unlock PWM all the updated parameters are set simultaneously
-    _ppwm->unlock();
 }
@@ -8,6 +8,15 @@
 
 #include "m32m1_pwm.h"
 
+#define MOTOR_SPEED_MAX 2048    //!< Speed giving 100% of duty-cycle, whatever the PWM counter maximum (power of 2)
+#define MOTOR_SPEED_SHIFT 11    //!< log2(MOTOR_SPEED_MAX)
+
+// Drive modes of the H-Bridge
+#define DRIVE_MODE_SLOW_DECAY       0   //!< Sign-magnitude, complementary switching, brakes at 0 (default)
+#define DRIVE_MODE_ASYNC_DECAY      1   //!< Sign-magnitude, only the high side is switched (asynchronous slow decay), coasts at 0
+#define DRIVE_MODE_LOCKED_ANTIPHASE 2   //!< Both half-bridges switched around 50%, 50% at 0 (slow decay at twice the PWM frequency)
+#define DRIVE_MODE_FAST_DECAY       3   //!< Sign-magnitude, the high side and the opposite low side switched together (fast decay), coasts at 0
+
 //! \class Motor_dc
 //! \brief Motor_dc class. 
 //!
@@ -64,22 +73,100 @@ public:
     //!
     //! \briefsetSpeed Set the speed of the motor
     //! \param speed         Speed of the motor (PWM duty cycle)
-    //!                      speed is included between -PWM_COUNTER_MAX and +PWM_COUNTER_MAX
-    //!                      Values outside of this range are bounded
+    //!                      speed is included between -MOTOR_SPEED_MAX and +MOTOR_SPEED_MAX,
+    //!                      it is scaled to the counter maximum of the PWM (see setPwmFrequency)
+    //!                      Values outside of this range are bounded (see setDutyLimit)
     void setSpeed(int speed);
 
+    //!
+    //! \brief setDutyLimit  Set the maximum duty cycle (derating), applied from the next setSpeed
+    //! \param limit         The maximum duty cycle, between 0 and MOTOR_SPEED_MAX
+    inline void setDutyLimit(int limit) { _duty_limit = (limit > MOTOR_SPEED_MAX) ? MOTOR_SPEED_MAX : limit; }
+
+    //!
+    //! \brief getDutyLimit  Get the maximum duty cycle
+    //! \return              The maximum duty cycle, between 0 and MOTOR_SPEED_MAX
+    inline int getDutyLimit() { return _duty_limit; }
+
+    //!
+    //! \brief setPwmFrequency Change the PWM frequency (and the duty-cycle resolution)
+    //!                        The current speed is applied again with the new resolution
+    //! \param frequency       Requested PWM frequency (Hz)
+    //! \return                The new PWM counter maximum (duty resolution), 0 if the
+    //!                        frequency is not possible (nothing is changed)
+    uint16_t setPwmFrequency(uint32_t frequency);
+
+    //!
+    //! \brief setDutyCompensation Set the low-duty linearization of the PWM
+    //!                            (see M32m1_pwm::setDutyCompensation, disabled with 0, 0)
+    //! \param offsetNs            Calibrated duration (ns) added to any non-zero duty-cycle
+    //! \param minPulseNs          Minimum pulse width (ns)
+    void setDutyCompensation(uint16_t offsetNs, uint16_t minPulseNs);
+
+
+    //!
+    //! \brief setDriveMode  Select the drive mode of the H-Bridge
+    //! \param mode          The drive mode:
+    //!                      DRIVE_MODE_SLOW_DECAY  => one half-bridge switched (complementary), the low side
+    //!                                                of the other one closed: the current decays through
+    //!                                                the low sides (brake), both low sides closed at 0
+    //!                      DRIVE_MODE_ASYNC_DECAY => only the high side of the switched half-bridge is driven:
+    //!                                                the current decays through its low side diode and the
+    //!                                                closed low side of the other half-bridge (asynchronous
+    //!                                                slow decay, more losses than DRIVE_MODE_SLOW_DECAY), all
+    //!                                                the transistors are open at 0 (coast).
+    //!                      DRIVE_MODE_LOCKED_ANTIPHASE => both half-bridges switched around 50%, the difference
+    //!                                                of the duty cycles gives the motor voltage. The A outputs
+    //!                                                of both channels are centered on the same point of the
+    //!                                                period: the motor gets two 0/+V pulses per period and never
+    //!                                                a reversed voltage, this is a slow decay at twice the PWM
+    //!                                                frequency (half the current ripple, no ripple at 0, the
+    //!                                                same braking as DRIVE_MODE_SLOW_DECAY, four transistors
+    //!                                                switched).
+    //!                      DRIVE_MODE_FAST_DECAY  => the high side of the switched half-bridge and the low side
+    //!                                                of the other one are switched together (one diagonal),
+    //!                                                the current decays through the diodes of the opposite
+    //!                                                diagonal, against the supply (asynchronous fast decay: the
+    //!                                                transistors of the opposite diagonal are not closed, the B
+    //!                                                output of a channel is the complement of its A output and
+    //!                                                cannot follow the A output of the other channel). The B
+    //!                                                outputs are inverted (M32m1_pwm::setOutputPolarityB) to be
+    //!                                                active in the window of the A outputs, all the transistors
+    //!                                                are open at 0 (coast). In continuous conduction the motor
+    //!                                                gets (2*duty-1)*Vbus: a large dead band at low speed, the
+    //!                                                shortest stop (regenerative braking).
+    //!                      The modes are compared on a motor model by tools/motor_model.
+    void setDriveMode(uint8_t mode);
+
+    //!
+    //! \brief getDriveMode  Get the drive mode of the H-Bridge
+    //! \return              The drive mode (DRIVE_MODE_XXX)
+    inline uint8_t getDriveMode() { return _driveMode; }
 
     //!
     //! \brief cmdc_commutation  This function performs the righ commutation
     //!
     void commutation();
 
+    //!
+    //! \brief getDutyCycle  Get the last requested duty cycle (absolute value)
+    //! \return              The duty cycle, between 0 and MOTOR_SPEED_MAX
+    inline int getDutyCycle() { return _duty_cycle; }
+
+    //!
+    //! \brief isEnabled     Check if the commutation is enabled
+    //! \return              false after disableMotor() or brakeMotor(), until enableMotor()
+    inline bool isEnabled() { return _enabled; }
+
 private:
 
     M32m1_pwm* _ppwm;            //!< Pointer over the PWM
     int        _duty_cycle;      //!< The PWM duty cycle (speed of the motor)
+    int        _duty_limit;      //!< The maximum duty cycle (derating)
     uint8_t    _rotationCW;      //!< rotation clock wise
     uint8_t    _defaultRotation; //!< To differentiate left wheels and right wheels
+    volatile bool _enabled;      //!< false when the motor is disabled or braked (no commutation)
+    uint8_t    _driveMode;       //!< The drive mode of the H-Bridge
 };
 
 #endif // MOTOR_DC_H
@@ -12,32 +12,80 @@
 //! \brief Output class. 
 //!
 //! Output class. This class described the behavior for an output. It inherits from the IPin interface.
-class Output : public Pin
+//! The methods are static, they can be used without an object (Output<GPIO_PORTC, 1>::setLow()).
+//!
+//! \tparam PORT_ADDR : address of the PORTx register of the pin (GPIO_PORTB, GPIO_PORTC...)
+//! \tparam PIN : The pin id
+template<uint8_t PORT_ADDR, uint8_t PIN>
+class Output : public Pin<PORT_ADDR, PIN>
 {
 public:
 
     //! \brief Constructor for an output
     //!
-    //! Constructor for an output
+    //! Constructor for an output (set as output, high state)
+    Output() { init(); }
+
+    //! \brief Set the pin as output, with the given state
     //!
-    //! \param pport : Pointer to a volatile int corresponding to the port of the pin
-    //! \param[in] pinmask : The pin id
-    Output(volatile uint8_t * pport, uint8_t pinmask);
+    //! \param[in] high : the initial state
+    static inline void init(bool high=true) {
+        high ? setHigh() : setLow();
+        Pin<PORT_ADDR, PIN>::ddr() |= (1 << PIN);
+    }
 
     //! \brief Switch pin to high state
     //!
     //! Switch pin to high state
-    void setHigh();
+    static inline void setHigh() { Pin<PORT_ADDR, PIN>::port() |= (1 << PIN); }
 
     //! \brief Switch pin to low state
     //!
     //! Switch pin to low state
-    void setLow();
+    static inline void setLow() { Pin<PORT_ADDR, PIN>::port() &= ~(1 << PIN); }
 
     //! \brief Toggle pin state
     //!
-    //! Toggle pin state
-    void toggle();
+    //! Toggle pin state (writing a one to the PINx bit toggles the PORTx bit)
+    static inline void toggle() { Pin<PORT_ADDR, PIN>::pin() = (1 << PIN); }
+};
+
+//! \class OutputGroup
+//! \brief OutputGroup class.
+//!
+//! Several outputs driven together, with the static interface of an Output (init, setHigh,
+//! setLow). It is used by SpiBus to select several devices of the same bus at once
+//! (SPI_BUS_ALL: the commands without answer only, the devices would all drive MISO).
+//!
+//! \tparam OUTPUTS : the Output types
+template<class... OUTPUTS>
+class OutputGroup;
+
+//! \brief OutputGroup without output (end of the recursion)
+template<>
+class OutputGroup<>
+{
+public:
+    static inline void init(bool = true) {}
+    static inline void setHigh() {}
+    static inline void setLow() {}
+};
+
+//! \brief OutputGroup of a first output and the others
+template<class FIRST, class... OTHERS>
+class OutputGroup<FIRST, OTHERS...>
+{
+public:
+    //! \brief Set the pins as outputs, with the given state
+    //!
+    //! \param[in] high : the initial state
+    static inline void init(bool high=true) { FIRST::init(high); OutputGroup<OTHERS...>::init(high); }
+
+    //! \brief Switch the pins to high state
+    static inline void setHigh() { FIRST::setHigh(); OutputGroup<OTHERS...>::setHigh(); }
+
+    //! \brief Switch the pins to low state
+    static inline void setLow() { FIRST::setLow(); OutputGroup<OTHERS...>::setLow(); }
 };
 
 #endif // OUPUT_H
@@ -1,37 +1,121 @@
 #include "pid.h"
 
+#define PID_TERM_MAX ((int32_t)PID_OUTPUT_MAX << PID_FRAC_BITS) //!< Bound of each term (Q16), their sum cannot overflow
+
+// Bound a value
+static inline int32_t bound(int32_t value, int32_t min, int32_t max){
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
 Pid::Pid(float kp, float ki, float kd){
-    _kp = kp;
-    _ki = ki;
-    _kd = kd;
-    _sum_errors = 0;
-    _previous_error = 0;
-    _correction = 0;
+    _kp = toFixed(kp);
+    _ki = toFixed(ki);
+    _kd = toFixed(kd);
+    _b = PID_ONE;
+    _dFilterShift = 0;
+    _min = -PID_TERM_MAX;
+    _max =  PID_TERM_MAX;
+    reset();
+}
+
+int32_t Pid::toFixed(float gain){
+    if (gain < 0) gain = 0;
+    if (gain > PID_GAIN_MAX) gain = PID_GAIN_MAX;
+    return (int32_t)(gain * PID_ONE + 0.5f);
 }
 
 void Pid::setKp(float kp){
-    _kp = kp;
+    _kp = toFixed(kp);
 }
 
 void Pid::setKi(float ki){
-    _ki = ki;
+    _ki = toFixed(ki);
 }
 
 void Pid::setKd(float kd){
-    _kd = kd;
+    _kd = toFixed(kd);
 }
 
+void Pid::setGains(int32_t kp, int32_t ki, int32_t kd){
+    const int32_t max = (int32_t)(PID_GAIN_MAX * PID_ONE);
+    _kp = bound(kp, 0, max);
+    _ki = bound(ki, 0, max);
+    _kd = bound(kd, 0, max);
+}
+
+void Pid::setOutputLimits(int16_t min, int16_t max){
+    if (min < -PID_OUTPUT_MAX) min = -PID_OUTPUT_MAX;
+    if (max >  PID_OUTPUT_MAX) max =  PID_OUTPUT_MAX;
+    if (min > max) min = max;
+    _min = (int32_t)min << PID_FRAC_BITS;
+    _max = (int32_t)max << PID_FRAC_BITS;
+    // the integral term alone never exceeds the limits
+    _integral = bound(_integral, _min, _max);
+}
+
+void Pid::setSetpointWeight(float b){
+    if (b < 0) b = 0;
+    if (b > 1) b = 1;
+    _b = (int32_t)(b * PID_ONE + 0.5f);
+}
+
+void Pid::setDerivativeFilter(uint8_t shift){
+    _dFilterShift = (shift > 7) ? 7 : shift;
+}
+
+int32_t Pid::proportional(int16_t target, int16_t state){
+    int32_t weighted = (int32_t)(((int32_t)target * _b) >> PID_FRAC_BITS) - state;
+    weighted = bound(weighted, -PID_ERROR_MAX, PID_ERROR_MAX);
+    return bound(_kp * weighted, -PID_TERM_MAX, PID_TERM_MAX);
+}
 
 int16_t Pid::update(int16_t target, int16_t state){
-    float error = target - state ;
-    _sum_errors += error;
-    _correction += _kp * error + _ki * _sum_errors + _kd * (error - _previous_error);
-    _previous_error = error;
-    return (int16_t) _correction;
+    if (!_initialized) {
+        // no derivative kick on the first update
+        _previous_state = state;
+        _initialized = true;
+    }
+
+    int32_t error = bound((int32_t)target - state, -PID_ERROR_MAX, PID_ERROR_MAX);
+
+    // proportional term (setpoint weighting)
+    int32_t p = proportional(target, state);
+    _proportional = p;
+
+    // derivative term on the measurement, first-order filtered
+    int32_t delta = bound((int32_t)state - _previous_state, -PID_ERROR_MAX, PID_ERROR_MAX);
+    _previous_state = state;
+    int32_t d = bound(-_kd * delta, -PID_TERM_MAX, PID_TERM_MAX);
+    _derivative += (d - _derivative) >> _dFilterShift;
+
+    // integral term, conditional integration (anti-windup):
+    // not integrated if it would push further an already saturated output
+    int32_t i = bound(_ki * error, -PID_TERM_MAX, PID_TERM_MAX);
+    int32_t output = p + _integral + i + _derivative;
+    if (!((output > _max && error > 0) || (output < _min && error < 0))) {
+        _integral = bound(_integral + i, _min, _max);
+    }
+
+    output = bound(p + _integral + _derivative, _min, _max);
+    // rounding to the nearest integer
+    return toInteger(output);
 }
 
 void Pid::reset(){
-    _sum_errors = 0;
-    _previous_error = 0;
-    _correction = 0;
+    _proportional = 0;
+    _integral = 0;
+    _derivative = 0;
+    _previous_state = 0;
+    _initialized = false;
+}
+
+void Pid::initialize(int16_t output, int16_t target, int16_t state){
+    _derivative = 0;
+    _previous_state = state;
+    _initialized = true;
+    // the integral term takes the part of the output not given by the proportional term
+    _proportional = proportional(target, state);
+    _integral = bound(((int32_t)output << PID_FRAC_BITS) - _proportional, _min, _max);
 }
@@ -8,10 +8,22 @@
 
 #include <stdint.h>
 
+#define PID_FRAC_BITS   16                      //!< Number of fractional bits of the gains and of the internal terms
+#define PID_ONE         (1L << PID_FRAC_BITS)   //!< 1.0 in the internal fixed point format
+#define PID_GAIN_MAX    16.0                    //!< Maximum value of a gain
+#define PID_ERROR_MAX   1024                    //!< Errors and measurement variations are bounded to +/- this value
+#define PID_OUTPUT_MAX  8191                    //!< Maximum absolute value of the output limits
+
 //! \class Pid
-//! \brief Pid class. 
+//! \brief Pid class.
 //!
-//! PID class
+//! PID class, computed in fixed point (Q16) to be cheap enough for the timer interruption:
+//!     - proportional term with setpoint weighting: Kp * (b * target - state)
+//!     - integral term accumulated as Ki * error, so that changing Ki does not bump the output
+//!     - derivative term on the measurement (no kick on target changes), with a first-order filter
+//!     - output clamping, with conditional integration as anti-windup
+//!       (the integral is frozen while the output is saturated in the direction of the error)
+//!     - bumpless reset/enable with initialize()
 class Pid
 {
 public:
@@ -27,36 +39,101 @@ public:
 
     //! \brief setKp : Set P coeffcient
     //!
-    //! \param[in] kp : the P coefficient
+    //! \param[in] kp : the P coefficient (0 to PID_GAIN_MAX)
     void setKp(float kp);
 
     //! \brief setKi : Set I coeffcient
     //!
-    //! \param[in] ki : the I coefficient
+    //! \param[in] ki : the I coefficient (0 to PID_GAIN_MAX)
     void setKi(float ki);
 
     //! \brief setKd : Set D coeffcient
     //!
-    //! \param[in] kd : the D coefficient
+    //! \param[in] kd : the D coefficient (0 to PID_GAIN_MAX)
     void setKd(float kd);
 
-    //! \brief setKd : update the PID value (error and correction)
+    //! \brief setGains : Set the three coefficients in the internal fixed point format
+    //!                    (cheap enough to be called at each update, see GainSchedule)
+    //!
+    //! \param[in] kp : the P coefficient (Q16)
+    //! \param[in] ki : the I coefficient (Q16)
+    //! \param[in] kd : the D coefficient (Q16)
+    void setGains(int32_t kp, int32_t ki, int32_t kd);
+
+    //! \brief setOutputLimits : Set the output limits
+    //!
+    //! \param[in] min : the minimum output (>= -PID_OUTPUT_MAX)
+    //! \param[in] max : the maximum output (<= PID_OUTPUT_MAX)
+    void setOutputLimits(int16_t min, int16_t max);
+
+    //! \brief setSetpointWeight : Set the setpoint weight of the proportional term
+    //!
+    //! \param[in] b : the weight (0 to 1). 1: error feedback, 0: proportional on the measurement only
+    void setSetpointWeight(float b);
+
+    //! \brief setDerivativeFilter : Set the time constant of the derivative filter
+    //!
+    //! \param[in] shift : the filter time constant is 2^shift update periods (0: no filter, max 7)
+    void setDerivativeFilter(uint8_t shift);
+
+    //! \brief update : update the PID value (error and correction)
     //!
     //! \param[in] target : the target state
     //! \param[in] state : the measured state
-    //! \return : the new correction value to apply to the command
+    //! \return : the new correction value to apply to the command, within the output limits
     int16_t update(int16_t target, int16_t state);
 
     //! \brief reset : reset the PID value (error and correction)
     void reset();
 
+    //! \brief initialize : bumpless start, the next update continues from the given output
+    //!
+    //! \param[in] output : the output currently applied
+    //! \param[in] target : the current target state
+    //! \param[in] state : the current measured state
+    void initialize(int16_t output, int16_t target, int16_t state);
+
+    //! \brief getProportional : get the proportional term of the last update
+    //! \return : the term, rounded to an integer (as the output)
+    inline int16_t getProportional() { return toInteger(_proportional); }
+
+    //! \brief getIntegral : get the integral term of the last update
+    //! \return : the term, rounded to an integer (as the output)
+    inline int16_t getIntegral() { return toInteger(_integral); }
+
+    //! \brief getDerivative : get the filtered derivative term of the last update
+    //! \return : the term, rounded to an integer (as the output)
+    inline int16_t getDerivative() { return toInteger(_derivative); }
+
 private:
-    float _kp;              //!< The PID P coefficient
-    float _ki;              //!< The PID I coefficient
-    float _kd;              //!< The PID D coefficient
-    float _sum_errors;      //!< The PID error sum
-    float _previous_error;  //!< The previous error
-    float _correction;      //!< The correction value
+    //! \brief toInteger : round an internal value to the nearest integer
+    //! \param[in] value : the value (Q16)
+    //! \return the rounded value
+    static inline int16_t toInteger(int32_t value) { return (int16_t)((value + (PID_ONE >> 1)) >> PID_FRAC_BITS); }
+
+    //! \brief toFixed : convert a gain to the internal fixed point format
+    //! \param[in] gain : the gain (bounded to 0 - PID_GAIN_MAX)
+    //! \return the gain in Q16
+    static int32_t toFixed(float gain);
+
+    //! \brief proportional : compute the proportional term
+    //! \param[in] target : the target state
+    //! \param[in] state : the measured state
+    //! \return the proportional term (Q16), bounded to the output range
+    int32_t proportional(int16_t target, int16_t state);
+
+    int32_t _kp;            //!< The PID P coefficient (Q16)
+    int32_t _ki;            //!< The PID I coefficient (Q16)
+    int32_t _kd;            //!< The PID D coefficient (Q16)
+    int32_t _b;             //!< The setpoint weight (Q16)
+    uint8_t _dFilterShift;  //!< The derivative filter time constant (power of 2)
+    int32_t _min;           //!< The minimum output (Q16)
+    int32_t _max;           //!< The maximum output (Q16)
+    int32_t _proportional;  //!< The proportional term of the last update (Q16)
+    int32_t _integral;      //!< The integral term (Q16)
+    int32_t _derivative;    //!< The filtered derivative term (Q16)
+    int16_t _previous_state;//!< The previous measured state
+    bool    _initialized;   //!< false until the first update after a reset
 
 };
 
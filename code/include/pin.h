@@ -6,30 +6,45 @@
 //! \author Remy Guyonneau, Philippe Lucidarme
 //! \date 2017 04 24
 
+#include <avr/io.h>
 #include <stdint.h>
 
+// Data memory addresses of the PORTx registers, to be used as template parameters
+// (the DDRx register is at PORTx-1, the PINx register at PORTx-2)
+#define GPIO_PORTB  0x25    //!< Address of the PORTB register
+#define GPIO_PORTC  0x28    //!< Address of the PORTC register
+#define GPIO_PORTD  0x2B    //!< Address of the PORTD register
+#define GPIO_PORTE  0x2E    //!< Address of the PORTE register
+
 //! \class Pin
 //! \brief Pin class. 
 //!
 //! IPin class (interface). This class represents a Pin interface and shouldn't be instanciated, only inherited.
+//! The port and the pin are template parameters: the registers are known at compile time,
+//! so the accesses compile to single bit instructions (sbi/cbi/sbic) and the objects are empty.
+//!
+//! \tparam PORT_ADDR : address of the PORTx register of the pin (GPIO_PORTB, GPIO_PORTC...)
+//! \tparam PIN : Id of the pin to use on this port
+template<uint8_t PORT_ADDR, uint8_t PIN>
 class Pin
 {
-protected:
-    //! \brief Pin : Constructor to represent an Pin
-    //!
-    //! Constructor to represent an Pin
-    //!
-    //! \param pport : pointer to a volatile int corresponding to the SFR memspace for this port
-    //! \param pinmask : Id of the pin to use
-    Pin(volatile uint8_t* pport, uint8_t pinmask);
+public:
+    //! \brief port The PORTx register of the pin
+    static inline volatile uint8_t& port() { return _MMIO_BYTE(PORT_ADDR); }
 
-    volatile uint8_t * _pport; //!< Pointer to a volatile int corresponding to the PORTx register for this pin
+    //! \brief ddr The DDRx register of the pin
+    static inline volatile uint8_t& ddr() { return _MMIO_BYTE(PORT_ADDR-1); }
 
-    volatile uint8_t * _pddr; //!< Pointer to a volatile int corresponding to the DDRx register for this pin
+    //! \brief pin The PINx register of the pin
+    static inline volatile uint8_t& pin() { return _MMIO_BYTE(PORT_ADDR-2); }
 
-    volatile uint8_t * _ppin; //!< Pointer to a volatile int corresponding to the the PINx register for this pin
+    //! \brief read Read the pin state
+    //! \return true if the pin is high
+    static inline bool read() { return pin() & (1 << PIN); }
 
-    uint8_t _pinmask; //!< Id of the pin to use on this port
+protected:
+    //! \brief Pin : Constructor to represent an Pin
+    Pin() {}
 };
 
 #endif // PIN_H
@@ -0,0 +1,5 @@
+#include "profile.h"
+
+#ifdef PROFILE
+ProfileProbe profileProbes[PROFILE_NB_PROBES];
+#endif
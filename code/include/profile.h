@@ -0,0 +1,79 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+//! \file profile.h
+//! \brief Execution time probes (timer 1)
+//! \date 2026 10 18
+//!
+//! The probes measure the duration of the interruptions and of the driver calls
+//! on the target, with timer 1 (clk/8, the control period timer). They are only
+//! compiled with make PROFILE=1, otherwise PROFILE_BEGIN and PROFILE_END are empty.
+//! The resolution is 8 CPU cycles, the probe itself costs a few cycles. A measure
+//! must be shorter than the timer period (the counter is cleared on compare match).
+//! The results are read with the CONFIG_GET_PROFILE command (see main.cpp).
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#define PROFILE_TIMER_ISR       0   //!< Probe: the body of ISR(TIMER1_COMPA_vect)
+#define PROFILE_CAN_ISR         1   //!< Probe: the body of ISR(CAN_INT_vect)
+#define PROFILE_PID_UPDATE      2   //!< Probe: Pid::update
+#define PROFILE_READ_COUNTER    3   //!< Probe: Counter::read_counter (or the snapshot of the two counters)
+#define PROFILE_SET_SPEED       4   //!< Probe: Motor_dc::setSpeed
+#define PROFILE_NB_PROBES       5   //!< Number of probes
+
+#define PROFILE_CYCLES_PER_COUNT 8  //!< CPU cycles per timer 1 count (clk/8)
+
+#ifdef PROFILE
+
+//! \brief A probe (timer 1 counts)
+struct ProfileProbe {
+    uint16_t start; //!< Timer value at the beginning of the measure
+    uint16_t last;  //!< Duration of the last measure
+    uint16_t max;   //!< Longest measure
+};
+
+extern ProfileProbe profileProbes[PROFILE_NB_PROBES]; //!< The probes (profile.cpp)
+
+//! \brief profileBegin Start a measure
+//! \param[in] probe : PROFILE_XXX
+static inline void profileBegin(uint8_t probe) {
+    profileProbes[probe].start = TCNT1;
+}
+
+//! \brief profileEnd End a measure, update the last and the max durations
+//! \param[in] probe : PROFILE_XXX
+static inline void profileEnd(uint8_t probe) {
+    uint16_t now = TCNT1;
+    ProfileProbe* p = &profileProbes[probe];
+    // the counter is cleared after OCR1A
+    uint16_t duration = (now >= p->start) ? now - p->start : now + OCR1A + 1 - p->start;
+    p->last = duration;
+    if (duration > p->max) p->max = duration;
+}
+
+//! \brief profileLast Duration of the last measure
+//! \param[in] probe : PROFILE_XXX
+//! \return the duration (CPU cycles)
+static inline uint32_t profileLast(uint8_t probe) {
+    return (uint32_t)profileProbes[probe].last * PROFILE_CYCLES_PER_COUNT;
+}
+
+//! \brief profileMax Longest measure
+//! \param[in] probe : PROFILE_XXX
+//! \return the duration (CPU cycles)
+static inline uint32_t profileMax(uint8_t probe) {
+    return (uint32_t)profileProbes[probe].max * PROFILE_CYCLES_PER_COUNT;
+}
+
+#define PROFILE_BEGIN(probe)    profileBegin(probe) //!< Start a measure
+#define PROFILE_END(probe)      profileEnd(probe)   //!< End a measure
+
+#else
+
+#define PROFILE_BEGIN(probe)
+#define PROFILE_END(probe)
+
+#endif // PROFILE
+
+#endif // PROFILE_H
@@ -0,0 +1,135 @@
+#include <util/atomic.h>
+#include "protection.h"
+
+Protection::Protection(Motor_dc* pmotor) :
+    _pmotor(pmotor),
+    _fault(FAULT_NONE),
+    _reported(true),
+    _tripEnabled(false),
+    _currentLimit(0x3FF),
+    _currentNbTicks(1),
+    _currentCount(0),
+    _stallMinDuty(0xFFFF),
+    _stallMaxTics(0),
+    _stallNbTicks(1),
+    _stallCount(0)
+{}
+
+// Configure the DAC and the analog comparator 3 to trip over a current level
+void Protection::enableTrip(uint16_t level)
+{
+    // DAC enabled, right adjusted, not output on the D2A pin (PC7 drives the standby pins)
+    DACON = (1<<DAEN);
+    DAC   = level;
+
+    // Comparator 3: ACMP3 (current sensor) against the DAC,
+    // interruption on rising edge (current going over the level)
+    AC3CON = (1<<AC3EN) | (1<<AC3IS1) | (1<<AC3IS0) | (1<<AC3M2) | (1<<AC3M0);
+    ACSR   = (1<<AC3IF); // clear the flag before enabling the interruption
+    AC3CON |= (1<<AC3IE);
+    _tripEnabled = true;
+}
+
+// Disable the motor and latch the fault (from the comparator interruption)
+void Protection::onTrip()
+{
+    // first of all, open the H-Bridge
+    _pmotor->disableMotor();
+    // the comparator will re-trigger on the PWM edges, keep it quiet until clear()
+    AC3CON &= ~(1<<AC3IE);
+    if (_fault == FAULT_NONE) {
+        _fault = FAULT_OVERCURRENT_TRIP;
+        _reported = false;
+    }
+}
+
+void Protection::setCurrentLimit(uint16_t level, uint8_t nbTicks)
+{
+    _currentLimit = level;
+    _currentNbTicks = nbTicks;
+    _currentCount = 0;
+}
+
+void Protection::setStallDetection(uint16_t minDuty, uint8_t maxTics, uint8_t nbTicks)
+{
+    _stallMinDuty = minDuty;
+    _stallMaxTics = maxTics;
+    _stallNbTicks = nbTicks;
+    _stallCount = 0;
+}
+
+// Check the current and the stall conditions
+void Protection::check(uint16_t current, int16_t tics)
+{
+    if (_fault != FAULT_NONE) return;
+
+    // sustained overcurrent
+    if (current > _currentLimit) {
+        if (++_currentCount >= _currentNbTicks) {
+            trip(FAULT_OVERCURRENT);
+            return;
+        }
+    } else {
+        _currentCount = 0;
+    }
+
+    // stalled while commanded
+    if (tics < 0) tics = -tics;
+    if ((uint16_t)_pmotor->getDutyCycle() >= _stallMinDuty && tics <= _stallMaxTics) {
+        if (++_stallCount >= _stallNbTicks) {
+            trip(FAULT_STALL);
+        }
+    } else {
+        _stallCount = 0;
+    }
+}
+
+// Latch a fault and stop the motor
+void Protection::trip(uint8_t fault)
+{
+    // the hardware trip can interrupt the control loop
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (fault == FAULT_STALL) {
+            // the rotor is locked, keep it stopped
+            _pmotor->brakeMotor();
+        } else {
+            _pmotor->disableMotor();
+        }
+        if (_fault == FAULT_NONE) {
+            _fault = fault;
+            _reported = false;
+        }
+    }
+}
+
+// Clear the latched fault
+void Protection::clear()
+{
+    // a hardware trip during the clear must not be followed by enableMotor
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        _currentCount = 0;
+        _stallCount = 0;
+        _fault = FAULT_NONE;
+        _reported = true;
+        _pmotor->setSpeed(0);
+        _pmotor->enableMotor();
+
+        if (_tripEnabled) {
+            ACSR = (1<<AC3IF);
+            if (ACSR & (1<<AC3O)) {
+                // still over the trip level (no rising edge will come)
+                onTrip();
+            } else {
+                AC3CON |= (1<<AC3IE);
+            }
+        }
+    }
+}
+
+// Check if a new fault has to be reported
+bool Protection::takeReport()
+{
+    if (_reported) return false;
+    _reported = true;
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef PROTECTION_H
+#define PROTECTION_H
+
+//! \file protection.h
+//! \brief Protection class
+//! \date 2026 10 18
+
+#include <avr/io.h>
+#include <stdint.h>
+#include "motor_dc.h"
+
+// Fault codes (the first fault is latched until clear() is called)
+#define FAULT_NONE              0x00    //!< No fault
+#define FAULT_OVERCURRENT_TRIP  0x01    //!< The analog comparator detected a current over the trip level
+#define FAULT_OVERCURRENT       0x02    //!< The measured current stayed over the limit
+#define FAULT_STALL             0x03    //!< The motor did not turn while commanded
+#define FAULT_COUNTER           0x04    //!< The counter did not answer (mode registers read back at boot,
+                                        //!  and again before the fault is cleared, see main.cpp)
+                                        //!  or its SPI transactions overlapped (see spi_bus.h)
+
+//! \class Protection
+//! \brief Protection class.
+//!
+//! Protection class. Fast overcurrent and stall protection, independent of the control loop.
+//! Two levels are used:
+//!     - a hardware trip: the analog comparator 3 compares the current sensor output
+//!       (ACMP3) to a DAC level, its interruption disables the motor within a few
+//!       microseconds (less than one PWM cycle). The timer and CAN interruptions let it
+//!       nest, it is only delayed by the short critical sections and the ADC interruption.
+//!       The PSC fault inputs cannot be used: they take the comparators 0 to 2, the
+//!       current sensor is on ACMP3
+//!     - checks at each control tick: sustained current over a limit, and stall
+//!       (motor not turning while a high duty cycle is applied)
+//!
+//! The current values are raw ADC/DAC values (10 bits, AVcc reference).
+class Protection
+{
+public:
+
+    //! \brief Protection constructor
+    //!
+    //! \param pmotor : Pointer over the protected motor
+    Protection(Motor_dc* pmotor);
+
+    //! \brief enableTrip Configure the DAC and the analog comparator 3 to trip over a current level
+    //!
+    //! \param[in] level : The trip level (DAC value, 0 to 1023)
+    void enableTrip(uint16_t level);
+
+    //! \brief onTrip Disable the motor and latch the fault
+    //!               Must be called from ISR(ANACOMP3_vect)
+    void onTrip();
+
+    //! \brief setCurrentLimit Set the sustained current limit
+    //!
+    //! \param[in] level : The current limit (ADC value, 0 to 1023)
+    //! \param[in] nbTicks : Number of consecutive ticks over the limit before the fault
+    void setCurrentLimit(uint16_t level, uint8_t nbTicks);
+
+    //! \brief setStallDetection Set the stall detection parameters
+    //!
+    //! \param[in] minDuty : Minimum duty cycle (absolute value) considered as a command
+    //! \param[in] maxTics : Maximum counter value (absolute value) considered as not turning
+    //! \param[in] nbTicks : Number of consecutive stalled ticks before the fault
+    void setStallDetection(uint16_t minDuty, uint8_t maxTics, uint8_t nbTicks);
+
+    //! \brief check Check the current and the stall conditions, to call at each control tick
+    //!
+    //! \param[in] current : The measured current (ADC value)
+    //! \param[in] tics : The counter value of the tick
+    void check(uint16_t current, int16_t tics);
+
+    //! \brief trip Latch a fault and stop the motor (disabled for an overcurrent, braked for a stall)
+    //!
+    //! \param[in] fault : The fault code
+    void trip(uint8_t fault);
+
+    //! \brief clear Clear the latched fault, re-enable the motor and the hardware trip
+    void clear();
+
+    //! \brief isFaulted Check if a fault is latched
+    //! \return true if a fault is latched
+    inline bool isFaulted() { return _fault != FAULT_NONE; }
+
+    //! \brief getFault Get the latched fault
+    //! \return The fault code (FAULT_NONE if no fault)
+    inline uint8_t getFault() { return _fault; }
+
+    //! \brief takeReport Check if a new fault has to be reported
+    //! \return true only once for each latched fault
+    bool takeReport();
+
+private:
+    Motor_dc*        _pmotor;          //!< The protected motor
+    volatile uint8_t _fault;           //!< The latched fault
+    volatile bool    _reported;        //!< true when the latched fault has been reported
+    bool             _tripEnabled;     //!< true if the hardware trip is configured
+    uint16_t         _currentLimit;    //!< Sustained current limit (ADC value)
+    uint8_t          _currentNbTicks;  //!< Number of ticks over the limit before the fault
+    uint8_t          _currentCount;    //!< Number of consecutive ticks over the limit
+    uint16_t         _stallMinDuty;    //!< Minimum duty cycle for the stall detection
+    uint8_t          _stallMaxTics;    //!< Maximum counter value for the stall detection
+    uint8_t          _stallNbTicks;    //!< Number of stalled ticks before the fault
+    uint8_t          _stallCount;      //!< Number of consecutive stalled ticks
+};
+
+#endif // PROTECTION_H
@@ -0,0 +1,10 @@
+#include "speed_frame.h"
+
+bool decodeSpeedFrame(const uint8_t* data, uint8_t dlc, uint32_t mradsToTics, int16_t* target){
+    if(dlc != SPEED_FRAME_DLC) return false;
+    uint16_t mrads = ((uint16_t)data[1] << 8) | data[2];
+    // fixed point conversion (no floating point in the interruption)
+    int16_t tics = (int16_t)(((uint32_t)mrads * mradsToTics) >> 22);
+    *target = data[0] ? -tics : tics; // according to the rotation direction
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef SPEED_FRAME_H
+#define SPEED_FRAME_H
+
+//! \file speed_frame.h
+//! \brief Speed frame decoding
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define SPEED_FRAME_DLC         3   //!< Length of a speed frame: | rotationCW | speed(MSB) | speed(LSB) (mrad/s)
+
+//! \fn bool decodeSpeedFrame(const uint8_t* data, uint8_t dlc, uint32_t mradsToTics, int16_t* target)
+//! \brief Decode a speed frame: | rotationCW | speed(MSB) | speed(LSB) (mrad/s).
+//! This function has no side effect, the target is the counter value per 10ms (truncated).
+//! Any non-zero rotationCW byte gives a negative target.
+//! \param[in] data : the data of the frame
+//! \param[in] dlc : the length of the frame
+//! \param[in] mradsToTics : the mrad/s to counter value factor (Q22, up to 65536)
+//! \param[out] target : the target, not modified if the frame is not valid
+//! \return false if the frame is not valid
+bool decodeSpeedFrame(const uint8_t* data, uint8_t dlc, uint32_t mradsToTics, int16_t* target);
+
+#endif // SPEED_FRAME_H
@@ -55,20 +55,20 @@ void Spi::spi_init_slave (bool redirection)
 void Spi::spi_begin_transceive()
 {
     if (_spiOut == STD_DIRECTION) {
-        PORTD &= 0xF7;  //Set CS at 0
+        SPI_CS_STD::setLow();   //Set CS at 0
     }
     else {
-        PORTC &= 0xFD;  //Set CS at 0
+        SPI_CS_A::setLow();     //Set CS at 0
     }
 }
 
 void Spi::spi_stop_transceive()
 {
     if (_spiOut == STD_DIRECTION) {
-        PORTD |= 0x08;  //Set CS at 1
+        SPI_CS_STD::setHigh();  //Set CS at 1
     }
     else {
-        PORTC |= 0x02;  //Set CS at 1
+        SPI_CS_A::setHigh();    //Set CS at 1
     }
 }
  
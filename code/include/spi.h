@@ -6,7 +6,10 @@
 //! \author Franck Mercier, Remy Guyonneau 
 //! \date 2017 05 12
 
-#include "pin.h"
+#include "output.h"
+
+#define SPI_CS_STD  Output<GPIO_PORTD, 3>  //!< The chip select of the std SPI port (PD3)
+#define SPI_CS_A    Output<GPIO_PORTC, 1>  //!< The chip select of the _A SPI port (PC1)
 
 #define STD_DIRECTION 0 //!< TODO
 #define A_DIRECTION   1 //!< TODO
@@ -0,0 +1,120 @@
+#ifndef SPI_BUS_H
+#define SPI_BUS_H
+
+//! \file spi_bus.h
+//! \brief SpiBus class
+//! \date 2026 10 18
+
+#include <stdint.h>
+#include "spi.h"
+#include "output.h"
+
+#define SPI_BUS_ALL 0xFF    //!< Device index selecting all the devices of a bus at once
+
+//! \brief SpiBusNth The chip select of the device INDEX (type), out of range indexes do not compile
+template<uint8_t INDEX, class... CS>
+struct SpiBusNth;
+
+//! \brief SpiBusNth of the first device
+template<class FIRST, class... OTHERS>
+struct SpiBusNth<0, FIRST, OTHERS...> { typedef FIRST type; };
+
+//! \brief SpiBusNth of the next devices
+template<uint8_t INDEX, class FIRST, class... OTHERS>
+struct SpiBusNth<INDEX, FIRST, OTHERS...> { typedef typename SpiBusNth<INDEX-1, OTHERS...>::type type; };
+
+//! \brief SpiBusSelect The chip select(s) of a device index (type), all of them for SPI_BUS_ALL
+template<bool ALL, uint8_t INDEX, class... CS>
+struct SpiBusSelect { typedef typename SpiBusNth<INDEX, CS...>::type type; };
+
+//! \brief SpiBusSelect of SPI_BUS_ALL
+template<uint8_t INDEX, class... CS>
+struct SpiBusSelect<true, INDEX, CS...> { typedef OutputGroup<CS...> type; };
+
+//! \class SpiBus
+//! \brief SpiBus class.
+//!
+//! SPI bus manager: the SPI interface and the chip selects of the devices of the bus.
+//! The chip selects are template parameters (Output types), a device is given by its
+//! index in the list (a template parameter too), so that the selection compiles to single
+//! bit instructions. All the chip selects are set high by the constructor, before the
+//! first transaction: a device is never selected by a floating pin.
+//!
+//! SPI_BUS_ALL selects all the devices at once, to send the same command to all of
+//! them (LOAD_OTR: the counters are latched at the same time). Such a command is sent
+//! with send(), the byte received is ignored. Hardware assumption: the devices do not
+//! fight on MISO during a command without data (for the LS7366R, MISO only carries the
+//! data bytes of the read instructions). To check with a scope on a new device or
+//! board, a series resistor on each MISO output limits the current otherwise.
+//!
+//! The transactions are not protected (no interrupt masked by the bus). Contract of the
+//! users: a transaction, or a sequence of transactions that must not be split (a snapshot
+//! of the counters and their reads), is never interrupted by another user of the bus. In
+//! main.cpp, the bus is used by the timer and the CAN interruptions (and by main before
+//! sei): they mask each other while they run (beginNestable), the interruptions left
+//! unmasked (overcurrent trip, ADC) never use the bus. A full ATOMIC_BLOCK would delay the
+//! overcurrent trip by the SPI transfers (about 90us for the snapshot and the reads of two
+//! counters).
+//!
+//! The contract is checked: a device selected while another transaction of the bus is
+//! open is counted (overlaps()), and reported by the user (FAULT_COUNTER in main.cpp).
+//!
+//! \tparam CS : the Output types of the chip selects (device 0 first)
+template<class... CS>
+class SpiBus
+{
+public:
+    //! \brief SpiBus constructor (the chip selects are set as outputs, high)
+    //!
+    //! \param spi : pointer over the SPI interface (initialized by spi_init_master)
+    SpiBus(Spi* spi) : _spi(spi) { OutputGroup<CS...>::init(true); }
+
+    //! \brief select Select a device (chip select low)
+    //! \tparam DEVICE : the index of the device, or SPI_BUS_ALL
+    template<uint8_t DEVICE>
+    static inline void select()
+    {
+        if (_active && _overlaps != 0xFF) _overlaps++; // the contract of the users is broken
+        _active = true;
+        SpiBusSelect<DEVICE == SPI_BUS_ALL, DEVICE, CS...>::type::setLow();
+    }
+
+    //! \brief deselect End the transaction with a device (chip select high)
+    //! \tparam DEVICE : the index of the device, or SPI_BUS_ALL
+    template<uint8_t DEVICE>
+    static inline void deselect()
+    {
+        SpiBusSelect<DEVICE == SPI_BUS_ALL, DEVICE, CS...>::type::setHigh();
+        _active = false;
+    }
+
+    //! \brief overlaps Number of transactions started while another one was open (saturated at 255)
+    //! \return 0 while the users keep the contract
+    static inline uint8_t overlaps() { return _overlaps; }
+
+    //! \brief clearOverlaps Reset the number of overlapping transactions
+    static inline void clearOverlaps() { _overlaps = 0; }
+
+    //! \brief transfer Send a byte to the selected device, and receive its answer
+    //! \param[in] data : the byte to send
+    //! \return the byte received
+    inline uint8_t transfer(uint8_t data) { return _spi->spi_tranceiver(data); }
+
+    //! \brief send Send a byte, the byte received is ignored (several devices may be selected)
+    //! \param[in] data : the byte to send
+    inline void send(uint8_t data) { _spi->spi_tranceiver(data); }
+
+private:
+    Spi* _spi; //!< The SPI interface
+
+    static volatile bool _active;       //!< A transaction is open (between select and deselect)
+    static volatile uint8_t _overlaps;  //!< Transactions started while another one was open
+};
+
+template<class... CS>
+volatile bool SpiBus<CS...>::_active = false;
+
+template<class... CS>
+volatile uint8_t SpiBus<CS...>::_overlaps = 0;
+
+#endif // SPI_BUS_H
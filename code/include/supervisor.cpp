@@ -0,0 +1,52 @@
+#include "supervisor.h"
+
+Supervisor::Supervisor() :
+    _expired((1 << COMM_NB_TYPES) - 1),
+    _deceleration(0),
+    _lost(false)
+{
+    for (uint8_t i=0; i<COMM_NB_TYPES; i++) {
+        _timeout[i] = COMM_NO_TIMEOUT;
+        _stamp[i] = 0;
+        _age[i] = COMM_AGE_EXPIRED;
+    }
+}
+
+void Supervisor::setTimeout(uint8_t type, uint16_t timeout)
+{
+    if (type >= COMM_NB_TYPES) return;
+    if (timeout > COMM_AGE_MAX) timeout = COMM_AGE_MAX;
+    _timeout[type] = timeout;
+}
+
+// Called from the CAN interruption
+void Supervisor::onCommand(uint8_t type, uint16_t stamp)
+{
+    _stamp[type] = stamp;
+    _expired &= ~(1 << type);
+}
+
+// Called from the timer interruption
+bool Supervisor::tick(uint16_t now)
+{
+    _lost = false;
+    for (uint8_t i=0; i<COMM_NB_TYPES; i++) {
+        if (!(_expired & (1 << i))) {
+            uint16_t age = now - _stamp[i];
+            // expired before the CAN timer wraps
+            if (age > COMM_AGE_MAX) _expired |= (1 << i);
+            else _age[i] = age;
+        }
+        if (_expired & (1 << i)) _age[i] = COMM_AGE_EXPIRED;
+        if (_timeout[i] != COMM_NO_TIMEOUT && _age[i] > _timeout[i]) _lost = true;
+    }
+    return _lost;
+}
+
+int16_t Supervisor::ramp(int16_t target)
+{
+    if (_deceleration == 0) return 0;
+    if (target > _deceleration) return target - _deceleration;
+    if (target < -_deceleration) return target + _deceleration;
+    return 0;
+}
@@ -0,0 +1,86 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+//! \file supervisor.h
+//! \brief Supervisor class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define COMM_SPEED              0       //!< Command type: speed frames
+#define COMM_CONFIG             1       //!< Command type: configuration frames
+#define COMM_NB_TYPES           2       //!< Number of supervised command types
+
+#define COMM_NO_TIMEOUT         0       //!< Timeout of a command type that is not supervised
+#define COMM_AGE_MAX            0xF000  //!< Longest age measured (CAN timer counts), older commands are expired
+#define COMM_AGE_EXPIRED        0xFFFF  //!< Age of an expired command type (or never received)
+
+//! \class Supervisor
+//! \brief Supervisor class.
+//!
+//! Communication loss supervisor. The commands are tagged with the time stamp of
+//! their reception (CAN timer, CANSTM), and their age is computed at each control
+//! tick with the CAN timer (CANTIM). Each command type has its own timeout (CAN timer
+//! counts, or COMM_NO_TIMEOUT). When a supervised type is older than its timeout,
+//! the target is ramped down to 0 under the deceleration limit, instead of stopping
+//! the motor at once: a burst of lost frames does not cause a violent stop.
+//! The CAN timer wraps after 65536 counts, a command older than COMM_AGE_MAX is
+//! expired until the next command of its type (the ticks are much shorter).
+//! The methods are called from the interruptions (CAN and timer, not nested).
+class Supervisor
+{
+public:
+
+    //! \brief Supervisor constructor (no type supervised, no command received, no deceleration limit)
+    Supervisor();
+
+    //! \brief setTimeout Set the timeout of a command type
+    //!
+    //! \param[in] type : COMM_SPEED or COMM_CONFIG
+    //! \param[in] timeout : the timeout (CAN timer counts, up to COMM_AGE_MAX),
+    //!                      COMM_NO_TIMEOUT to stop the supervision
+    void setTimeout(uint8_t type, uint16_t timeout);
+
+    //! \brief setDeceleration Set the deceleration limit applied after a communication loss
+    //!
+    //! \param[in] deceleration : the maximum target change per tick (counter value), 0 to stop at once
+    inline void setDeceleration(uint8_t deceleration) { _deceleration = deceleration; }
+
+    //! \brief onCommand A command has been received (from the CAN interruption)
+    //!
+    //! \param[in] type : COMM_SPEED or COMM_CONFIG
+    //! \param[in] stamp : the reception time of the frame (CANSTM)
+    void onCommand(uint8_t type, uint16_t stamp);
+
+    //! \brief tick Update the ages of the command types, to call at each control tick
+    //!
+    //! \param[in] now : the CAN timer (CANTIM)
+    //! \return true if the communication is lost (a supervised type is too old)
+    bool tick(uint16_t now);
+
+    //! \brief isLost Check if the communication is lost (result of the last tick)
+    //! \return true if the communication is lost
+    inline bool isLost() { return _lost; }
+
+    //! \brief getAge Get the age of the last command of a type (at the last tick)
+    //!
+    //! \param[in] type : COMM_SPEED or COMM_CONFIG
+    //! \return the age (CAN timer counts), COMM_AGE_EXPIRED if expired or never received
+    inline uint16_t getAge(uint8_t type) { return _age[type]; }
+
+    //! \brief ramp Move a target towards 0 under the deceleration limit
+    //!
+    //! \param[in] target : the current target (counter value)
+    //! \return the new target
+    int16_t ramp(int16_t target);
+
+private:
+    uint16_t _timeout[COMM_NB_TYPES]; //!< The timeouts (CAN timer counts, COMM_NO_TIMEOUT if not supervised)
+    uint16_t _stamp[COMM_NB_TYPES];   //!< The reception time of the last command of each type
+    uint16_t _age[COMM_NB_TYPES];     //!< The age of the last command of each type (at the last tick)
+    uint8_t  _expired;                //!< The expired types (one bit per type)
+    uint8_t  _deceleration;           //!< The maximum target change per tick after a loss (0: no ramp)
+    bool     _lost;                   //!< true if the communication is lost
+};
+
+#endif // SUPERVISOR_H
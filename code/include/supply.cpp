@@ -0,0 +1,50 @@
+#include "supply.h"
+
+Supply::Supply(uint16_t nominal) :
+    _filtered((uint32_t)nominal << 8),
+    _nominal(nominal),
+    _undervoltage(0),
+    _overvoltage(0xFFFF),
+    _gain(SUPPLY_GAIN_ONE),
+    _flags(0),
+    _enabled(true)
+{}
+
+void Supply::setNominal(uint16_t nominal, uint16_t undervoltage, uint16_t overvoltage)
+{
+    if (nominal == 0) return;
+    _nominal = nominal;
+    _undervoltage = undervoltage;
+    _overvoltage = overvoltage;
+}
+
+// Called from the timer interruption
+void Supply::update(uint16_t voltage)
+{
+    int32_t delta = ((int32_t)voltage << 8) - (int32_t)_filtered;
+    _filtered += delta >> SUPPLY_FILTER_SHIFT;
+
+    uint16_t filtered = getVoltage();
+    _flags = 0;
+    if (filtered < _undervoltage) _flags |= SUPPLY_UNDERVOLTAGE;
+    if (filtered > _overvoltage) _flags |= SUPPLY_OVERVOLTAGE;
+
+    // the division is done here, once per tick
+    uint32_t gain = (filtered == 0) ? SUPPLY_GAIN_MAX : ((uint32_t)_nominal << 12) / filtered;
+    if (gain > SUPPLY_GAIN_MAX) gain = SUPPLY_GAIN_MAX;
+    if (gain < SUPPLY_GAIN_MIN) gain = SUPPLY_GAIN_MIN;
+    _gain = gain;
+}
+
+int16_t Supply::compensate(int16_t duty)
+{
+    int32_t compensated = ((int32_t)duty * getGain()) >> 12;
+    if (compensated > 32767) return 32767;
+    if (compensated < -32768) return -32768;
+    return compensated;
+}
+
+int16_t Supply::available(int16_t duty)
+{
+    return ((int32_t)duty << 12) / getGain();
+}
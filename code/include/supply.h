@@ -0,0 +1,89 @@
+#ifndef SUPPLY_H
+#define SUPPLY_H
+
+//! \file supply.h
+//! \brief Supply class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define SUPPLY_UNDERVOLTAGE     0x01    //!< Supply flag: the filtered voltage is under the undervoltage threshold
+#define SUPPLY_OVERVOLTAGE      0x02    //!< Supply flag: the filtered voltage is over the overvoltage threshold
+
+#define SUPPLY_FILTER_SHIFT     3       //!< Time constant of the voltage filter (2^3 updates)
+#define SUPPLY_GAIN_ONE         4096    //!< Compensation gain of 1.0 (Q12)
+#define SUPPLY_GAIN_MAX         (2*SUPPLY_GAIN_ONE) //!< Maximum compensation gain (supply at half the nominal voltage)
+#define SUPPLY_GAIN_MIN         (SUPPLY_GAIN_ONE/2) //!< Minimum compensation gain (supply at twice the nominal voltage)
+
+//! \class Supply
+//! \brief Supply class.
+//!
+//! Supply voltage of the H-bridge, and the compensation of the duty cycles: the
+//! conversion from counter values to duty cycles has been measured at the nominal
+//! voltage, the duty cycles are scaled by nominal / supply to keep the same voltage
+//! on the motor over the discharge of the battery.
+//! The voltage (mV) is given at each tick, from an ADC measure or from the CAN bus.
+//! It is low-pass filtered, and compared to the under and overvoltage thresholds.
+class Supply
+{
+public:
+
+    //! \brief Supply constructor
+    //!
+    //! \param[in] nominal : the nominal voltage (mV), also the initial voltage
+    Supply(uint16_t nominal);
+
+    //! \brief setNominal Set the nominal voltage and the thresholds
+    //!
+    //! \param[in] nominal : the nominal voltage (mV)
+    //! \param[in] undervoltage : the undervoltage threshold (mV)
+    //! \param[in] overvoltage : the overvoltage threshold (mV)
+    void setNominal(uint16_t nominal, uint16_t undervoltage, uint16_t overvoltage);
+
+    //! \brief setEnabled Enable or disable the compensation
+    //! \param[in] enabled : true to scale the duty cycles
+    inline void setEnabled(bool enabled) { _enabled = enabled; }
+
+    //! \brief isEnabled Check if the compensation is enabled
+    inline bool isEnabled() { return _enabled; }
+
+    //! \brief update Filter a new voltage, update the flags and the compensation
+    //!
+    //! \param[in] voltage : the supply voltage (mV)
+    void update(uint16_t voltage);
+
+    //! \brief getVoltage Get the filtered voltage
+    //! \return the voltage (mV)
+    inline uint16_t getVoltage() { return _filtered >> 8; }
+
+    //! \brief getFlags Get the voltage flags
+    //! \return SUPPLY_UNDERVOLTAGE, SUPPLY_OVERVOLTAGE or 0
+    inline uint8_t getFlags() { return _flags; }
+
+    //! \brief getGain Get the compensation gain (nominal / supply)
+    //! \return the gain (Q12, SUPPLY_GAIN_ONE if disabled)
+    inline uint16_t getGain() { return _enabled ? _gain : SUPPLY_GAIN_ONE; }
+
+    //! \brief compensate Scale a duty cycle by nominal / supply
+    //!
+    //! \param[in] duty : the duty cycle at the nominal voltage
+    //! \return the duty cycle at the supply voltage
+    int16_t compensate(int16_t duty);
+
+    //! \brief available Scale a duty cycle by supply / nominal (inverse of compensate)
+    //!
+    //! \param[in] duty : the duty cycle at the supply voltage
+    //! \return the equivalent duty cycle at the nominal voltage
+    int16_t available(int16_t duty);
+
+private:
+    uint32_t _filtered;     //!< The filtered voltage (mV, Q8)
+    uint16_t _nominal;      //!< The nominal voltage (mV)
+    uint16_t _undervoltage; //!< The undervoltage threshold (mV)
+    uint16_t _overvoltage;  //!< The overvoltage threshold (mV)
+    uint16_t _gain;         //!< The compensation gain, nominal / supply (Q12)
+    uint8_t  _flags;        //!< The voltage flags
+    bool     _enabled;      //!< true if the compensation is enabled
+};
+
+#endif // SUPPLY_H
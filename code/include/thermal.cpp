@@ -0,0 +1,62 @@
+#include "thermal.h"
+#include "motor_dc.h"
+
+Thermal::Thermal() :
+    _deratingStart(THERMAL_LEVEL_LIMIT-1),
+    _source(THERMAL_SOURCE_CURRENT),
+    _kDuty(0),
+    _kSpeed(0)
+{
+    for (uint8_t i=0; i<THERMAL_NB_MODELS; i++) {
+        _heat[i] = 0;
+        _continuous[i] = 0xFFFF;
+        _shift[i] = 0;
+    }
+}
+
+void Thermal::setModel(uint8_t model, uint8_t shift, uint16_t continuous)
+{
+    if (model >= THERMAL_NB_MODELS || continuous == 0) return;
+    _shift[model] = shift;
+    _continuous[model] = continuous;
+    _heat[model] = 0;
+}
+
+void Thermal::setBackEmfModel(uint16_t kDuty, uint16_t kSpeed)
+{
+    _kDuty = kDuty;
+    _kSpeed = kSpeed;
+}
+
+uint16_t Thermal::estimateCurrent(uint16_t duty, int16_t speed)
+{
+    if (speed < 0) speed = -speed;
+    // the motor is assumed to be driven in the direction of its motion
+    int32_t current = ((int32_t)_kDuty * duty - (int32_t)_kSpeed * speed) >> 8;
+    if (current < 0) return 0;
+    return (current > 0xFFFF) ? 0xFFFF : current;
+}
+
+// Called from the timer interruption
+uint16_t Thermal::update(uint16_t current, uint16_t duty, int16_t speed)
+{
+    if (_source == THERMAL_SOURCE_BACK_EMF) current = estimateCurrent(duty, speed);
+
+    uint16_t level = 0;
+    for (uint8_t i=0; i<THERMAL_NB_MODELS; i++) {
+        // square of the current relative to the continuous current (Q8)
+        uint32_t ratio = ((uint32_t)current << 8) / _continuous[i];
+        if (ratio > 0xFFFF) ratio = 0xFFFF;
+        uint32_t input = (ratio * ratio) >> 8;
+        if (input > 0xFFFF) input = 0xFFFF;
+        // first order filter, Q16
+        int32_t delta = (int32_t)(input << 8) - (int32_t)_heat[i];
+        _heat[i] += delta >> _shift[i];
+        if (getLevel(i) > level) level = getLevel(i);
+    }
+
+    // linear derating, from the full duty cycle at the start to 0 at the limit
+    if (level <= _deratingStart) return MOTOR_SPEED_MAX;
+    if (level >= THERMAL_LEVEL_LIMIT) return 0;
+    return ((uint32_t)MOTOR_SPEED_MAX * (THERMAL_LEVEL_LIMIT - level)) / (THERMAL_LEVEL_LIMIT - _deratingStart);
+}
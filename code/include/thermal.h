@@ -0,0 +1,91 @@
+#ifndef THERMAL_H
+#define THERMAL_H
+
+//! \file thermal.h
+//! \brief Thermal class
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define THERMAL_WINDING         0       //!< Thermal model of the motor winding
+#define THERMAL_BRIDGE          1       //!< Thermal model of the H-bridge
+#define THERMAL_NB_MODELS       2       //!< Number of thermal models
+
+#define THERMAL_SOURCE_CURRENT  0       //!< The models are driven by the measured current
+#define THERMAL_SOURCE_BACK_EMF 1       //!< The models are driven by the current estimated from the duty cycle and the speed
+
+#define THERMAL_LEVEL_LIMIT     256     //!< Thermal level at the limit (Q8)
+
+//! \class Thermal
+//! \brief Thermal class.
+//!
+//! I2t thermal models of the motor winding and of the H-bridge, with the duty cycle derating.
+//! Each model is a first order low-pass filter of the square of the current, relative to
+//! the continuous current of the part: its level is the temperature rise relative to the
+//! rise at the continuous current (Q8, THERMAL_LEVEL_LIMIT at the limit), the time constant
+//! is 2^shift ticks. Above the derating start the maximum duty cycle decreases linearly,
+//! down to 0 at the limit: the current settles where the temperature stays under the limit.
+//! The current is the measured one, or estimated with a back-EMF model when the measure
+//! is not available: current = (kDuty * duty - kSpeed * speed) / 256.
+//! The currents are in ADC units (above the 0A offset of the sensor).
+class Thermal
+{
+public:
+
+    //! \brief Thermal constructor (no limit, no derating)
+    Thermal();
+
+    //! \brief setModel Set the parameters of a model (the model is reset)
+    //!
+    //! \param[in] model : THERMAL_WINDING or THERMAL_BRIDGE
+    //! \param[in] shift : the time constant (2^shift ticks)
+    //! \param[in] continuous : the continuous current (ADC units)
+    void setModel(uint8_t model, uint8_t shift, uint16_t continuous);
+
+    //! \brief setDeratingStart Set the level where the derating starts
+    //!
+    //! \param[in] start : the level (Q8, below THERMAL_LEVEL_LIMIT)
+    void setDeratingStart(uint8_t start) { _deratingStart = start; }
+
+    //! \brief setSource Select the current used by the models
+    //!
+    //! \param[in] source : THERMAL_SOURCE_CURRENT or THERMAL_SOURCE_BACK_EMF
+    inline void setSource(uint8_t source) { _source = source; }
+
+    //! \brief setBackEmfModel Set the current estimation
+    //!
+    //! \param[in] kDuty : the current for a duty cycle unit (Q8)
+    //! \param[in] kSpeed : the current decrease for a counter unit (back-EMF, Q8)
+    void setBackEmfModel(uint16_t kDuty, uint16_t kSpeed);
+
+    //! \brief update Update the models, to call at each control tick
+    //!
+    //! \param[in] current : the measured current (ADC units above the offset)
+    //! \param[in] duty : the duty cycle of the tick (absolute value, 0 to MOTOR_SPEED_MAX)
+    //! \param[in] speed : the counter value of the tick
+    //! \return the maximum duty cycle (0 to MOTOR_SPEED_MAX)
+    uint16_t update(uint16_t current, uint16_t duty, int16_t speed);
+
+    //! \brief getLevel Get the level of a model
+    //!
+    //! \param[in] model : THERMAL_WINDING or THERMAL_BRIDGE
+    //! \return the level (Q8, THERMAL_LEVEL_LIMIT at the limit)
+    inline uint16_t getLevel(uint8_t model) { return _heat[model] >> 8; }
+
+private:
+    //! \brief estimateCurrent Estimate the current with the back-EMF model
+    //! \param[in] duty : the duty cycle (absolute value)
+    //! \param[in] speed : the counter value of the tick
+    //! \return the current (ADC units)
+    uint16_t estimateCurrent(uint16_t duty, int16_t speed);
+
+    uint32_t _heat[THERMAL_NB_MODELS];       //!< The filtered levels (Q16)
+    uint16_t _continuous[THERMAL_NB_MODELS]; //!< The continuous currents (ADC units)
+    uint8_t  _shift[THERMAL_NB_MODELS];      //!< The time constants (2^shift ticks)
+    uint8_t  _deratingStart;                 //!< The level where the derating starts (Q8)
+    uint8_t  _source;                        //!< The current used by the models
+    uint16_t _kDuty;                         //!< The current for a duty cycle unit (Q8)
+    uint16_t _kSpeed;                        //!< The current decrease for a counter unit (Q8)
+};
+
+#endif // THERMAL_H
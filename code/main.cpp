@@ -1,230 +1,1081 @@
-//! \file main.cpp
-//! \brief Main file for the MotorBoard
-//! \author Remy Guyonneau, Baptiste Hamard, Franck Mercier
-//! \date 2017 05 29
-
-
-
-// for ATMEL studio, not needed with the raspberry pi
-#define FOSC            16000       //!< The ATMEGA clock speed
-#define F_CPU           16000000UL  //!< The ATMEGA clock speed
-
-#include <avr/io.h>
-#include <util/delay.h>
-#include <stdio.h>
-#include <stdint.h>
-#include <avr/interrupt.h>
-
-#include "led.h"
-#include "pin.h"
-#include "m32m1_pwm.h"
-#include "motor_dc.h"
-#include "spi.h"
-#include "counter.h"
-#include "pid.h"
-#include "CanISR.h"
-
-#include <string.h> //POUR LES TESTS
-
-#define PI                      3.14159     //!< The PI constant, to handle mrad/s
-
-#define RIGHT_MOTOR             (1)         //!< The right motor value
-#define LEFT_MOTOR              (-1)        //!< The left motor value
-
-#define SIDE_MOTOR              RIGHT_MOTOR  //!< To handle left and right moteur
-                                            //!  choose between LEFT_MOTOR or RIGHT_MOTOR
-
-#define LED_RED_PORT            PORTB       //!< The port for the red LED
-#define LED_RED_PIN             3           //!< The pin for the red LED
-#define LED_RED_POL             0           //!< The polarity of the red LED
-
-#define LED_YELLOW_PORT         PORTB       //!< The port for the yellow LED
-#define LED_YELLOW_PIN          2           //!< The pin for the yellow LED
-#define LED_YELLOW_POL          0           //!< The polarity of the yellow LED
-
-#define ID_MOTORBOARD_DATASPEED 0x040       //!< The polarity of the yellow LED
-
-#define NB_STEPS                1920        //!< Number of tics for a complete wheel turn
-
-#define MAX_WATCH_DOG           100         //!< Time after the motor will stop
-                                            //!  if not receiving speed command* 10ms
-#define MAX_NB_FLAT             100         //!< Number of 0 value from the sensor before
-                                            //!  shutting down the robot (avoid motion after
-                                            //!  an emmergency stop for instance)
-
-#define DEFAULT_KP              0.07         //!< default KP for the PID  0.05
-#define DEFAULT_KI              0.001           //!< default KI for the PID  0.0009
-#define DEFAULT_KD              0.008           //!< default KD for the PID  0.8
-
-#define F_MOTOR_TIC2PWM(tic) (SIDE_MOTOR*35*tic) //!< To convert counter value to PWM,
-                                                 //!  the values are extracted from experimental tests
-
-Led redLed(&LED_RED_PORT, LED_RED_PIN, LED_RED_POL);             //!< the red LED
-Led yellowLed(&LED_YELLOW_PORT, LED_YELLOW_PIN, LED_YELLOW_POL); //!< the yellow LED
-M32m1_pwm pwm;                                                   //!< the PWM for the motor
-Motor_dc motor(&pwm, 0);                                         //!< the DC motor
-Spi spi;                                                         //!< the SPI communication
-Counter counter(&spi,&PORTC,&DDRC,PORTC1);                       //!< the counter (motor speed sensor)
-Pid pid(DEFAULT_KP, DEFAULT_KI, DEFAULT_KD);                     //!< the PID
-
-volatile uint32_t watch_dog;     //!< To stop the motor if no speed command reveiced after a delay
-volatile int16_t nb_tics_cmd;    //!< The counter value command
-volatile int16_t nb_tics_target; //!< The target counter value
-volatile uint8_t enablePID;      //!< To enable/disable the PID
-volatile uint8_t nbFlat;         //!< To stop the motor when not turning (after emmergency stop)
-
-//! \fn int main(void)
-//! \brief The main function of the MotorBoard
-//!
-int main(void)
-{
-    cli(); // clear all interruptions
-
-    // initialization of the flags and other global variables
-    watch_dog = 0;
-    enablePID = 1;
-    nb_tics_cmd = 0;
-    nb_tics_target = 0;
-    nbFlat = 0;
-
-    // make the LED blink to show that the board is alive
-    for (uint8_t i=0; i<5; i++) {
-        redLed.blink(50);
-        yellowLed.blink(50);
-    }
-
-    // to enable the LM2575
-    Output enable_LM2575(&PORTC,PORTC7);
-    enable_LM2575.setLow();
-
-    // Initialization of the Timer
-    TIFR1  |= 0x04;
-    TCCR1B |= 0x0D;
-    TCCR1A |= 0;
-    OCR1A   = 390;
-    // Value for the interruption (OCR1A)
-    // 7812 = 1   sec
-    // 1562 = 200 ms
-    // 781  = 100 ms
-    // 390  = 50  ms
-    // 195  = 25  ms
-    // 78   = 10  ms
-    TIMSK1 |= (1<<OCIE1A);
-
-    // initialization of the SPI communication
-    spi.spi_init_master(true, SPI_FALLING_EDGE);
-
-    counter.write_mode_register_0(0x03); // FILTER_1 | DISABLE_INDX | FREE_RUN | QUADRX4
-    counter.write_mode_register_1(0x00); // NO_FLAGS | EN_CNTR | BYTE_4
-    counter.clear_counter(); // reset the counter value
-    counter.clear_status_register(); // clear the counter register
-
-    initCANBus(); // initialization of the CAN Bus
-    initCANMOBasReceiver (1, ID_MOTORBOARD_DATASPEED, 0); // initialization of the CAN MOB
-
-    motor.enableMotor(); // enable the motor
-
-
-    sei(); // set enable interruption
-
-    while(1) {
-        // do nothing, everything is handled with the interruption
-        // (timer and CAN interruptions)
-    }
-}
-
-
-//! \fn ISR(TIMER1_COMPA_vect)
-//! \brief TIMER 1 interruption.
-//! This function is called when a TIMER1 interruption is raised.
-ISR(TIMER1_COMPA_vect){
-    cli(); // clear all interruption
-    TIFR1 |= 0; // reset the timer for the next interruption
-
-    int16_t val = counter.read_counter()*SIDE_MOTOR; // read the counter value
-    counter.clear_counter(); //reset the counter (for the next interruption)
-    
-    if(val == 0){ // if the motor did not turned
-        nbFlat ++; // increments the flat flag
-    }else{
-        nbFlat = 0; // reset the flat flag
-    }
-
-    if(watch_dog > MAX_WATCH_DOG || nb_tics_target == 0 || nbFlat > MAX_NB_FLAT){	//  || nb_tics_target == 0
-        // the motor is stopped if:
-        //      - the time of the received last command is over the watch dog delay
-        //      - the speed command is 0
-        //      - the number of 0 counter value is over the max value (possible emergency stop)
-        if (enablePID) {pid.reset(); } // reset the PID
-        motor.setSpeed(0);
-        nb_tics_target = 0; // reset the speed target
-    }else{
-        watch_dog ++; // increments the watch dog (reseted when receiving new speed command)
-        if(enablePID){ // if the PID is enabled
-            // compute the corrected command with the PID
-            int16_t cmd = nb_tics_cmd + pid.update(nb_tics_target, val);
-            // set the motor speed
-            motor.setSpeed(F_MOTOR_TIC2PWM(cmd));
-        }else{
-            // if the PID is desactivated, set directly the motor with the estimated transfer function
-            motor.setSpeed(F_MOTOR_TIC2PWM(nb_tics_cmd));
-        }
-    }
-    sei(); // enable the interruptions
-}
-
-//! \fn ISR(CAN_INT_vect)
-//! \brief CAN interruption.
-//! This function is called when an CAN interruption is raised.
-ISR(CAN_INT_vect){
-    cli(); // disable the interruption (no to be disturbed when dealing with one)
-
-    if ( (CANSIT2 & 0x02 )!=0x00){ // MOB1 interruption - SET MOTOR SPEED
-        CANPAGE = 0x10; // Selection of MOB 1
-		
-        // get the data from the mob 1:
-        uint8_t dlc = CANCDMOB & 0x0F; // get the DLC of the CAN frame
-        if(dlc == 0x03){ // rotationCW | speed(MSB) | speed(LSB)
-            // get the first data byte (rotationCW)
-            CANPAGE = 0x10; 
-            uint8_t rotationCW = CANMSG;
-            // get the second data byte (speed MSB)
-            CANPAGE = 0x11; 
-            uint8_t speedH = CANMSG;
-            // get the third and last data byte (speed LSB)
-            CANPAGE = 0x12;
-            uint8_t speedL = CANMSG;
-            // get the target speed (integer mrad/s)
-            uint16_t mrads = (uint16_t)(speedH << 8) + speedL;
-			//uint16_t mrads = 0x8000;
-			//rotationCW = 01;
-            int16_t nb_tics_new_target = 0; // to update the speed target (counter value)
-            watch_dog = 0; // reset the watch dog (a new command has been received)
-            if(mrads == 0){ // if the speed is 0, special case
-                nb_tics_new_target = 0; // the counter target must be O
-            }else if(!rotationCW){ // convert the mrad/s speed to counter/10ms speed, according to the rotation direction
-                nb_tics_new_target = (int16_t) (mrads*(NB_STEPS/100.0)/(2.0*PI*1000.0)); // convert mrad/s to tics/10ms
-            }else{
-                nb_tics_new_target = -(int16_t) (mrads*(NB_STEPS/100.0)/(2.0*PI*1000.0));
-            }
-
-            if(nb_tics_new_target != nb_tics_target){
-                // if the target speed has been changed
-                nb_tics_target = nb_tics_new_target; // update the target
-                //nb_tics_cmd = nb_tics_target; // update the command according to the target
-                //if (enablePID) {pid.reset(); } // reset the PID
-                nbFlat = 0; // reset the nbFlat flag
-            } // otherwise, nothing to change
-        }
-
-        // reset the MOB1 configuration for next CAN message
-        CANPAGE   = 0x10; // select MOB1
-        CANSTMOB  = 0x00; // Reset the status of the MOB1
-        CANCDMOB  = 0x80; // Config as reception MOB1
-        CANIE2   |= 0x02; // Enable the interruption over MOB 1 (for the next one)
-        CANSIT2  &= 0xFD; // remove the MOB1 raised flag
-
-    }
-
-    sei(); // enable the interruptions
-}
+//! \file main.cpp
+//! \brief Main file for the MotorBoard
+//! \author Remy Guyonneau, Baptiste Hamard, Franck Mercier
+//! \date 2017 05 29
+
+
+
+// for ATMEL studio, not needed with the raspberry pi
+#define FOSC            16000       //!< The ATMEGA clock speed
+#define F_CPU           16000000UL  //!< The ATMEGA clock speed
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <avr/eeprom.h>
+#include <avr/wdt.h>
+#include <avr/sleep.h>
+
+#include "led.h"
+#include "led_pattern.h"
+#include "pin.h"
+#include "m32m1_pwm.h"
+#include "motor_dc.h"
+#include "spi.h"
+#include "spi_bus.h"
+#include "counter.h"
+#include "pid.h"
+#include "m32m1_adc.h"
+#include "protection.h"
+#include "gain_schedule.h"
+#include "capture.h"
+#include "supervisor.h"
+#include "encoder_index.h"
+#include "encoder_health.h"
+#include "thermal.h"
+#include "supply.h"
+#include "disturbance_observer.h"
+#include "can_boot.h"
+#include "speed_frame.h"
+#include "profile.h"
+#include "CanISR.h"
+
+#define PI                      3.14159     //!< The PI constant, to handle mrad/s
+
+#define RIGHT_MOTOR             (1)         //!< The right motor value
+#define LEFT_MOTOR              (-1)        //!< The left motor value
+
+#define SIDE_MOTOR              RIGHT_MOTOR  //!< To handle left and right moteur
+                                            //!  choose between LEFT_MOTOR or RIGHT_MOTOR
+
+#define LED_RED_PORT            GPIO_PORTB  //!< The port for the red LED
+#define LED_RED_PIN             3           //!< The pin for the red LED
+#define LED_RED_POL             0           //!< The polarity of the red LED
+
+#define LED_YELLOW_PORT         GPIO_PORTB  //!< The port for the yellow LED
+#define LED_YELLOW_PIN          2           //!< The pin for the yellow LED
+#define LED_YELLOW_POL          0           //!< The polarity of the yellow LED
+
+#ifndef MOTORBOARD
+#define MOTORBOARD              0           //!< Number of the board on the CAN bus (make BOARD=n), 0 to 15
+#endif
+#define ID_MOTORBOARD_BASE      (0x040 + 0x010*MOTORBOARD) //!< First CAN ID of the board (0x040, 0x050, 0x060...)
+
+#define ID_MOTORBOARD_DATASPEED (ID_MOTORBOARD_BASE + 0) //!< The CAN ID of the speed commands (rotationCW | speed(MSB) | speed(LSB))
+#define ID_MOTORBOARD_FAULT     (ID_MOTORBOARD_BASE + 1) //!< The CAN ID of the fault reports (fault code | current(MSB) | current(LSB))
+#define ID_MOTORBOARD_CONFIG    (ID_MOTORBOARD_BASE + 2) //!< The CAN ID of the configuration commands (command | parameters)
+                                            //!  (0x042 + 0x10*MOTORBOARD, as given to tools/can_flasher)
+#define ID_MOTORBOARD_REPLY     (ID_MOTORBOARD_BASE + 3) //!< The CAN ID of the replies to the configuration commands (command | data)
+#define ID_MOTORBOARD_CAPTURE   (ID_MOTORBOARD_BASE + 4) //!< The CAN ID of the capture dump: header (nb records | trigger position | trigger source | post-trigger)
+                                            //!  then the records, oldest first (val | target | P | I | D | pwm(MSB) | pwm(LSB) | current)
+#define ID_MOTORBOARD_STATUS    (ID_MOTORBOARD_BASE + 5) //!< The CAN ID of the status, sent by the CAN controller as reply to a remote frame (DLC 8):
+                                            //!  speed(MSB) | speed(LSB) (counter value per tick) | position (4 bytes, MSB first, counter value)
+                                            //!  | fault code | flags (STATUS_XXX)
+                                            //!  The payload is updated at each tick (40 Hz): faster polls get the same status.
+                                            //!  One reply per remote frame, the next remote frame is answered once the CAN
+                                            //!  interruption has re-armed the MOB (delayed while the timer interruption runs,
+                                            //!  PROFILE_TIMER_ISR), a remote frame received before is not answered.
+                                            //!  On an idle bus at 500kb/s, a poll (remote frame and reply) takes about 350us.
+
+#define CAN_MOB_SEND            0           //!< The CAN MOB sending the replies to the configuration commands
+#define CAN_MOB_SPEED           1           //!< The CAN MOB receiving the speed commands
+#define CAN_MOB_CONFIG          2           //!< The CAN MOB receiving the configuration commands
+#define CAN_MOB_CAPTURE         3           //!< The CAN MOB sending the capture dump (from the main loop)
+#define CAN_MOB_STATUS          4           //!< The CAN MOB replying to the status remote frames (updated at each tick)
+#define CAN_MOB_FAULT           5           //!< The CAN MOB sending the fault reports (from the timer interruption)
+#define CAN_REPLY_QUEUE_SIZE    4           //!< Number of replies waiting for the MOB (sent from the main loop)
+
+#define STATUS_MOTOR_ENABLED    0x01        //!< Status flag: the H-bridge is enabled
+#define STATUS_PID_ENABLED      0x02        //!< Status flag: the PID is enabled
+#define STATUS_COMM_LOST        0x04        //!< Status flag: the commands are lost (target ramped down)
+#define STATUS_CAPTURE          0x08        //!< Status flag: a capture is recording
+#define STATUS_UNDERVOLTAGE     0x10        //!< Status flag: the supply voltage is under the undervoltage threshold
+#define STATUS_OVERVOLTAGE      0x20        //!< Status flag: the supply voltage is over the overvoltage threshold
+
+#define CONFIG_CLEAR_FAULT      0x01        //!< Configuration command: clear the latched fault (a counter fault is
+                                            //!  kept until the counters answer with their configuration)
+#define CONFIG_SET_PID_GAINS    0x02        //!< Configuration command: | kp(MSB) | kp(LSB) | ki(MSB) | ki(LSB) | kd(MSB) | kd(LSB) (Q16)
+#define CONFIG_GAIN_SCHEDULE    0x03        //!< Configuration command: | flags (bit0: enable, bit1: directional, bit7: clear the table)
+#define CONFIG_SET_PWM_FREQUENCY 0x04       //!< Configuration command: | frequency (Hz, 3 bytes, MSB first)
+                                            //!  reply: | counter max(MSB) | counter max(LSB) | frequency (Hz, 3 bytes, MSB first)
+#define CONFIG_SET_DUTY_COMPENSATION 0x05   //!< Configuration command: | offset(MSB) | offset(LSB) | min pulse(MSB) | min pulse(LSB) (ns)
+#define CONFIG_SET_DRIVE_MODE   0x06        //!< Configuration command: | mode (0: slow decay, 1: asynchronous slow decay, 2: locked anti-phase,
+                                            //!  3: asynchronous fast decay)
+#define CONFIG_GET_BOOT_TIMES   0x07        //!< Configuration command: | first stage
+                                            //!  reply: | first stage | 3 x (time(MSB) | time(LSB)) (us since the timer start)
+#define CONFIG_CAPTURE          0x08        //!< Configuration command: | mode | post-trigger | threshold (see CAPTURE_MODE_XXX)
+#define CONFIG_ENTER_BOOTLOADER 0x09        //!< Configuration command: | node (0-15) | reset in the CAN bootloader (see can_boot.h)
+#define CONFIG_GET_CAN_STATS    0x0A        //!< Configuration command: | reset (optional, 1 to reset the statistics)
+                                            //!  reply: | speed frames(MSB) | speed frames(LSB) | invalid frames
+                                            //!         | max latency(MSB) | max latency(LSB) (x100us, reception to PWM update) | REC | TEC
+#define CONFIG_GET_PROFILE      0x0B        //!< Configuration command: | probe (PROFILE_XXX, firmware built with make PROFILE=1)
+                                            //!  reply: | probe | last(3 bytes) | max(3 bytes) (CPU cycles, MSB first)
+                                            //!  or | 0xFF if the firmware is not built for profiling
+#define CONFIG_SET_COMM_TIMEOUT 0x0C        //!< Configuration command: | type (COMM_SPEED, COMM_CONFIG) | timeout(MSB) | timeout(LSB)
+                                            //!  (x100us, 0: not supervised) | deceleration (counter value per tick, 0: immediate stop)
+#define CONFIG_GET_CPU_LOAD     0x0D        //!< Configuration command: | reset (optional, 1 to reset the peak)
+                                            //!  reply: | load(MSB) | load(LSB) | peak(MSB) | peak(LSB) (per mille of the control period)
+#define CONFIG_GET_COMMAND_AGE  0x0E        //!< Configuration command: no parameter
+                                            //!  reply: | speed age(MSB) | speed age(LSB) | config age(MSB) | config age(LSB)
+                                            //!         (x100us at the last tick, 0xFFFF if older than 6s or never received)
+#define CONFIG_INDEX            0x0F        //!< Configuration command: | counts per index(MSB) | counts per index(LSB) | tolerance (optional, restart the tracking)
+                                            //!  reply: | angle(MSB) | angle(LSB) (counts from the index, 0xFFFF if no index seen) | indexes(MSB)
+                                            //!         | indexes(LSB) | errors | last error(MSB) | last error(LSB) (counts, <0: missing counts)
+#define CONFIG_ENCODER_HEALTH   0x20        //!< Configuration command: | flags (optional, bit0: counter clock filter FILTER_2, bit1: counter
+                                            //!  clock filter FILTER_1, the filter is kept without these bits, bit7: reset the counters)
+                                            //!  reply: | link | disabled | power loss | wrap | overspeed | jump (see ENCODER_XXX)
+                                            //!         | last status register
+#define CONFIG_GET_LOAD_ENCODER 0x21        //!< Configuration command: no parameter (firmware built with make DUAL_ENCODER=1)
+                                            //!  reply: | speed(MSB) | speed(LSB) (counter value per tick) | position (4 bytes, MSB first)
+                                            //!  of the load side counter, or no data if the firmware has a single counter
+#define CONFIG_THERMAL          0x22        //!< Configuration command: | source (THERMAL_SOURCE_XXX) | derating start (Q8)
+                                            //!  | kDuty(MSB) | kDuty(LSB) | kSpeed(MSB) | kSpeed(LSB) (optional, see Thermal)
+                                            //!  reply: | winding level(MSB) | winding level(LSB) | bridge level(MSB) | bridge level(LSB)
+                                            //!         (Q8, 256 at the limit) | duty limit(MSB) | duty limit(LSB) | TEMP (ADC3 value / 4)
+#define CONFIG_SET_VBUS         0x23        //!< Configuration command: | voltage(MSB) | voltage(LSB) (mV, supply voltage measured by
+                                            //!  another board, ignored if the firmware is built with VBUS_ADC)
+#define CONFIG_SUPPLY           0x24        //!< Configuration command: | flags (bit0: enable the compensation) | nominal(MSB) | nominal(LSB)
+                                            //!  | undervoltage(MSB) | undervoltage(LSB) | overvoltage(MSB) | overvoltage(LSB) (mV, optional)
+                                            //!  reply: | voltage(MSB) | voltage(LSB) (mV, filtered) | flags (SUPPLY_XXX)
+                                            //!         | gain(MSB) | gain(LSB) (duty cycle compensation, Q12)
+#define CONFIG_DISTURBANCE_OBSERVER 0x25    //!< Configuration command: | flags (bit0: enable) | bandwidth (Q8 per tick)
+                                            //!  | time constant(MSB) | time constant(LSB) (ticks, Q8) (optional, the flags alone are accepted)
+                                            //!  reply: | enabled | estimate(MSB) | estimate(LSB) (counter value)
+#define CONFIG_SET_GAIN_POINT   0x10        //!< Configuration command (0x10 | backward << 3 | index):
+                                            //!  | speed | kp(MSB) | kp(LSB) | ki(MSB) | ki(LSB) | kd(MSB) | kd(LSB) (Q16)
+
+// Boot stages: read on a board with CONFIG_GET_BOOT_TIMES, or under simavr with make cycles
+// (boot_<stage> of tools/cycles/cycles.txt in CPU cycles, boot: from the reset to the first idle sleep)
+#define BOOT_STAGE_IO           0           //!< Boot stage: LM2575 enabled
+#define BOOT_STAGE_COUNTER      1           //!< Boot stage: SPI and counter initialized
+#define BOOT_STAGE_CAN          2           //!< Boot stage: CAN initialized, MOBs armed
+#define BOOT_STAGE_ADC          3           //!< Boot stage: ADC and protections initialized
+#define BOOT_STAGE_PLL          4           //!< Boot stage: PLL locked, PWM running
+#define BOOT_STAGE_READY        5           //!< Boot stage: interruptions enabled (commands accepted)
+#define BOOT_NB_STAGES          6           //!< Number of boot stages
+#define BOOT_TIME_OVERFLOW      0xFFFF      //!< Boot time of a stage reached after the first timer period
+#define TIMER1_COUNTS_PER_US    (F_CPU/8000000UL) //!< Timer 1 counts per us (clk/8)
+
+#define CAPTURE_MODE_ARM        0x10        //!< Capture mode: arm with the trigger sources of bits 0-2 (CAPTURE_TRIGGER_XXX)
+#define CAPTURE_MODE_TRIGGER    0x20        //!< Capture mode: trigger now
+#define CAPTURE_MODE_DUMP       0x40        //!< Capture mode: dump the buffer again (when not recording)
+#define CAPTURE_MODE_STOP       0x80        //!< Capture mode: stop recording
+#define CAPTURE_NO_DUMP         0xFF        //!< Capture dump position when no dump is in progress
+
+#define CURRENT_ADC_CHANNEL     9           //!< ADC9 (PC5, also ACMP3): output of the ACS713-20A current sensor
+#define CURRENT_ADC_OFFSET      102         //!< ADC value at 0A (0.5V)
+#define CURRENT_MA_TO_ADC(ma)   (CURRENT_ADC_OFFSET + ((uint32_t)(ma)*37851UL)/1000000UL) //!< 185mV/A, 5V for 1023
+
+#define TEMP_ADC_CHANNEL        3           //!< ADC3 (PD6): TEMP input of the board
+
+#define THERMAL_WINDING_MA      3000        //!< Continuous current (mA) of the motor winding
+#define THERMAL_WINDING_SHIFT   10          //!< Time constant of the winding model (2^10 ticks, 26s)
+#define THERMAL_BRIDGE_MA       6000        //!< Continuous current (mA) of the H-bridge
+#define THERMAL_BRIDGE_SHIFT    7           //!< Time constant of the H-bridge model (2^7 ticks, 3.2s)
+#define THERMAL_DERATING_START  192         //!< Thermal level (Q8) where the duty cycle derating starts (75%)
+
+#define VBUS_NOMINAL_MV         24000       //!< Supply voltage (mV) of the TIC2PWM_FACTOR measures (no compensation at this voltage)
+#define VBUS_UNDERVOLTAGE_MV    20000       //!< Undervoltage threshold (mV)
+#define VBUS_OVERVOLTAGE_MV     30000       //!< Overvoltage threshold (mV)
+#ifdef VBUS_ADC_CHANNEL
+// no divider on the board: the supply voltage is measured on a free ADC input (make VBUS_ADC=...)
+#define VBUS_DIVIDER            13          //!< Ratio of the supply voltage divider (60V max)
+#define VBUS_ADC_TO_MV(adc)     ((uint16_t)(((uint32_t)(adc)*VBUS_DIVIDER*5000UL)/1023)) //!< ADC value to mV (AVcc reference)
+#endif
+
+#define CURRENT_TRIP_MA         15000       //!< Current (mA) disabling the motor immediately (analog comparator)
+#define CURRENT_LIMIT_MA        8000        //!< Current (mA) not to exceed more than CURRENT_LIMIT_NB_TICKS
+#define CURRENT_LIMIT_NB_TICKS  10          //!< Number of ticks over CURRENT_LIMIT_MA before disabling the motor
+
+#define DUTY_OFFSET_NS          0           //!< Calibrated duration (ns) added to the non-zero duty-cycles
+#define DUTY_MIN_PULSE_NS       0           //!< Minimum PWM pulse width (ns) of the drivers and MOSFETs (shorter pulses are skipped, dithered)
+
+#define STALL_MIN_DUTY          700         //!< Minimum PWM duty cycle considered as a motion command
+#define STALL_MAX_TICS          1           //!< Maximum counter value considered as not turning
+#define STALL_NB_TICKS          4           //!< Number of stalled ticks before braking the motor
+
+#define COUNTER_MODE_0          (FILTER_1 | INDX_LOADO | ASYNCH_INDX | FREE_RUN | QUADRX4) //!< The counter MDR0 configuration
+                                            //!  (the index latches the counter value in the OTR)
+#define COUNTER_MODE_1          (IDX_FLAG | EN_CNTR | BYTE_4) //!< The counter MDR1 configuration (LFLAG/ low on index)
+#define COUNTER_LFLAG           Pin<GPIO_PORTD, 1> //!< The counter LFLAG/ output (PD1, pulled up)
+
+#ifdef DUAL_ENCODER
+// second counter on the load side of the gearbox (backlash and wheel slip), on the same SPI bus
+#define COUNTER_B_CS            Output<GPIO_PORTB, 4> //!< The chip select of the load side counter (PB4, free pin)
+#define COUNTER_B_MODE_0        (FILTER_1 | DISABLE_INDX | FREE_RUN | QUADRX4) //!< The load side counter MDR0 configuration
+#define COUNTER_B_MODE_1        (NO_FLAGS | EN_CNTR | BYTE_4) //!< The load side counter MDR1 configuration
+#endif
+
+#define ENCODER_SAMPLE_TICKS    8           //!< Number of ticks between two samples of the counter status register
+#define ENCODER_MAX_SPEED       (2*MAX_NB_TICS_CMD) //!< Counter value of a tick over the motor maximum speed
+#define ENCODER_MAX_JUMP        (MAX_NB_TICS_CMD/2) //!< Change of the counter value in a tick over the motor acceleration
+
+#define INDEX_COUNTS            NB_STEPS    //!< Default number of counts between two index pulses
+#define INDEX_TOLERANCE         4           //!< Error (counts) accepted between two index pulses (width of the index pulse)
+
+#define NB_STEPS                1920        //!< Number of tics for a complete wheel turn
+#define MRADS_TO_TICS_Q22       ((uint32_t)((NB_STEPS/100.0)/(2.0*PI*1000.0)*4194304.0 + 0.5))
+                                            //!< mrad/s to tics/10ms factor (Q22), computed at compile time
+
+#define CAN_TIMER_PRESCALER     199         //!< CAN timer prescaler: 8*(199+1) CPU clocks = 100us per count (CANTIM, CANSTM)
+
+#define COMM_SPEED_TIMEOUT      25000       //!< Age of the last speed command (x100us) before the motor is stopped
+#define COMM_DECELERATION       2           //!< Deceleration (counter value per tick) to stop the motor after a command loss
+#define WATCHDOG_TIMEOUT        WDTO_120MS  //!< Hardware watchdog timeout (more than 4 control ticks)
+#define MAX_NB_FLAT             100         //!< Number of 0 value from the sensor before
+                                            //!  shutting down the robot (avoid motion after
+                                            //!  an emmergency stop for instance)
+
+// The previous PID accumulated its output (correction += kp*e + ki*sum(e) + kd*delta(e)),
+// its KP acted as an integral gain and its KD as a proportional gain (0.07, 0.001, 0.008)
+#define DEFAULT_KP              0.008       //!< default KP for the PID
+#define DEFAULT_KI              0.07        //!< default KI for the PID
+#define DEFAULT_KD              0.0         //!< default KD for the PID
+#define DEFAULT_SETPOINT_WEIGHT 1.0         //!< default weight of the target in the PID proportional term
+#define DEFAULT_D_FILTER        2           //!< default PID derivative filter (time constant of 2^n ticks)
+
+#define DOB_BANDWIDTH           32          //!< Default filter gain of the disturbance observer (Q8 per tick, 0.8Hz)
+#define DOB_TIME_CONSTANT       1024        //!< Default mechanical time constant of the motor (ticks, Q8: 4 ticks, 100ms)
+
+#define TIC2PWM_FACTOR          35          //!< PWM value for one counter tic
+#define F_MOTOR_TIC2PWM(tic) (SIDE_MOTOR*TIC2PWM_FACTOR*(tic)) //!< To convert counter value to PWM,
+                                                 //!  the values are extracted from experimental tests
+#define MAX_NB_TICS_CMD         (MOTOR_SPEED_MAX/TIC2PWM_FACTOR) //!< Counter command giving the maximum PWM
+
+Led<LED_RED_PORT, LED_RED_PIN, LED_RED_POL> redLed;             //!< the red LED
+Led<LED_YELLOW_PORT, LED_YELLOW_PIN, LED_YELLOW_POL> yellowLed; //!< the yellow LED
+LedPattern redPattern;                                           //!< the red LED pattern (fault blink code)
+LedPattern yellowPattern;                                        //!< the yellow LED pattern (heartbeat, CAN activity)
+M32m1_pwm pwm;                                                   //!< the PWM for the motor
+Motor_dc motor(&pwm, 0);                                         //!< the DC motor
+Spi spi;                                                         //!< the SPI communication
+#ifdef DUAL_ENCODER
+typedef SpiBus<SPI_CS_A, COUNTER_B_CS> CounterBus;               //!< the SPI bus of the counters (motor, load side)
+#else
+typedef SpiBus<SPI_CS_A> CounterBus;                             //!< the SPI bus of the counter
+#endif
+CounterBus counterBus(&spi);                                     //!< the counters chip selects (all high before any transaction)
+Counter<CounterBus, 0> counter(&counterBus);                     //!< the counter (motor speed sensor)
+#ifdef DUAL_ENCODER
+Counter<CounterBus, 1> counterB(&counterBus);                    //!< the load side counter
+Counter<CounterBus, SPI_BUS_ALL> counters(&counterBus);          //!< the two counters, selected together (snapshots)
+int16_t loadSpeed;                                               //!< The load side counter value of the last tick
+int32_t loadPosition;                                            //!< The load side position (counter value)
+#endif
+Pid pid(DEFAULT_KP, DEFAULT_KI, DEFAULT_KD);                     //!< the PID
+M32m1_adc adc;                                                   //!< the ADC (current measurement)
+Protection protection(&motor);                                   //!< the overcurrent and stall protection
+GainSchedule schedule;                                           //!< the speed dependent PID gains
+Capture capture;                                                 //!< the capture of the control loop signals
+Supervisor supervisor;                                           //!< the communication loss supervisor
+EncoderIndex encoderIndex(INDEX_COUNTS, INDEX_TOLERANCE);        //!< the index pulse tracking
+Thermal thermal;                                                 //!< the thermal models (duty cycle derating)
+Supply supply(VBUS_NOMINAL_MV);                                  //!< the supply voltage (duty cycle compensation)
+DisturbanceObserver observer(DOB_BANDWIDTH, DOB_TIME_CONSTANT);  //!< the load disturbance observer (disabled by default)
+EncoderHealth encoderHealth(ENCODER_SAMPLE_TICKS, ENCODER_MAX_SPEED, ENCODER_MAX_JUMP); //!< the encoder diagnostics
+
+uint8_t counterFilter = FILTER_1; //!< The clock filter of the counters (FILTER_1 or FILTER_2)
+int32_t position;                //!< The position (counter value, free running)
+int32_t lastCount;               //!< The counter value at the previous tick
+volatile uint8_t tickCount;      //!< Number of control ticks (wrapping), the main loop resets the watchdog when it moves
+volatile int16_t nb_tics_cmd;    //!< The counter value command
+volatile int16_t nb_tics_target; //!< The target counter value
+volatile uint8_t enablePID;      //!< To enable/disable the PID
+volatile uint8_t nbFlat;         //!< To stop the motor when not turning (after emmergency stop)
+uint8_t currentChannel;          //!< The ADC channel index of the current measurement
+uint8_t tempChannel;             //!< The ADC channel index of the TEMP input
+#ifdef VBUS_ADC_CHANNEL
+uint8_t vbusChannel;             //!< The ADC channel index of the supply voltage
+#else
+volatile uint16_t vbusCommand = VBUS_NOMINAL_MV; //!< The supply voltage given on the CAN bus (mV)
+#endif
+uint16_t pidGains[3] = {(uint16_t)(DEFAULT_KP*PID_ONE), (uint16_t)(DEFAULT_KI*PID_ONE), (uint16_t)(DEFAULT_KD*PID_ONE)};
+                                 //!< The PID gains (Q16) when the gain schedule is disabled
+volatile uint8_t captureDump = CAPTURE_NO_DUMP; //!< Position of the next capture frame to send (0: header)
+volatile uint16_t canSpeedFrames;    //!< Number of speed frames received
+volatile uint8_t canInvalidFrames;   //!< Number of speed frames with a wrong length
+volatile uint16_t canLatencyMax;     //!< Maximum delay from the reception of a speed frame to the PWM update (CAN timer counts)
+volatile uint16_t canCommandStamp;   //!< Reception time of the oldest speed frame not applied yet (CAN timer)
+volatile bool canCommandPending;     //!< true if a speed frame has been received since the last PWM update
+uint16_t bootTimes[BOOT_NB_STAGES];  //!< Time of each boot stage (timer 1 counts since its start)
+uint8_t replyQueue[CAN_REPLY_QUEUE_SIZE][9]; //!< The replies waiting for the MOB (dlc | data), oldest at replyFirst
+volatile uint8_t replyFirst;         //!< Index of the oldest reply waiting in replyQueue
+volatile uint8_t replyCount;         //!< Number of replies waiting in replyQueue
+volatile bool bootloaderRequest;     //!< true once CONFIG_ENTER_BOOTLOADER is accepted (reset by the main loop)
+volatile bool sleeping;              //!< true while the main loop is in idle sleep (until the next interruption)
+uint16_t idleStart;                  //!< Timer 1 value when entering the idle sleep
+uint16_t idleCounts;                 //!< Idle time of the current control period (timer 1 counts)
+volatile uint16_t idleLast;          //!< Idle time of the last control period (timer 1 counts)
+volatile uint16_t idleMin = 0xFFFF;  //!< Shortest idle time of a control period (peak load)
+
+void processConfigCommand(const uint8_t* data, uint8_t dlc);
+void dumpCapture();
+void sendQueuedReply();
+
+//! \fn void bootStamp(uint8_t stage)
+//! \brief Record the time of a boot stage (timer 1, started at the beginning of main)
+static inline void bootStamp(uint8_t stage){
+    // after the first period the counter has been cleared (compare flag set, interruptions still disabled)
+    bootTimes[stage] = (TIFR1 & (1<<OCF1A)) ? BOOT_TIME_OVERFLOW : TCNT1;
+}
+
+//! \fn void idleStop()
+//! \brief Account the idle time, if the interruption woke the main loop up.
+//! This function is called first by all the interruptions.
+static inline void idleStop(){
+    if(!sleeping) return;
+    sleeping = false;
+    uint16_t now = TCNT1;
+    // the counter is cleared after OCR1A
+    idleCounts += (now >= idleStart) ? now - idleStart : now + OCR1A + 1 - idleStart;
+}
+
+//! \fn uint16_t cpuLoad(uint16_t idle)
+//! \brief Convert an idle time to a CPU load.
+//! \return the load (per mille of the control period)
+static uint16_t cpuLoad(uint16_t idle){
+    return 1000 - (uint16_t)(((uint32_t)idle * 1000) / ((uint32_t)OCR1A + 1));
+}
+
+//! \fn void configureCounters()
+//! \brief Write the mode registers of the counters.
+static void configureCounters(){
+    counter.write_mode_register_0(COUNTER_MODE_0 | counterFilter);
+    counter.write_mode_register_1(COUNTER_MODE_1);
+#ifdef DUAL_ENCODER
+    counterB.write_mode_register_0(COUNTER_B_MODE_0 | counterFilter);
+    counterB.write_mode_register_1(COUNTER_B_MODE_1);
+#endif
+}
+
+//! \fn bool checkCounters()
+//! \brief Check the SPI link of the counters: their mode registers are read back.
+//! \return true if all the counters answer with their configuration
+static bool checkCounters(){
+    bool ok = counter.read_mode_register_0() == (COUNTER_MODE_0 | counterFilter)
+           && counter.read_mode_register_1() == COUNTER_MODE_1;
+#ifdef DUAL_ENCODER
+    ok = ok && counterB.read_mode_register_0() == (COUNTER_B_MODE_0 | counterFilter)
+            && counterB.read_mode_register_1() == COUNTER_B_MODE_1;
+#endif
+    return ok;
+}
+
+//! \fn int main(void)
+//! \brief The main function of the MotorBoard
+//!
+int main(void)
+{
+    cli(); // clear all interruptions
+    // after a watchdog reset the watchdog is still running: stop it during the initializations
+    MCUSR = 0;
+    wdt_disable();
+
+    // Initialization of the Timer, first: it gives the boot times
+    // (the PLL has been started by the PWM constructor, it locks during the initializations)
+    TIFR1   = (1<<OCF1A);
+    OCR1A   = 50047;
+    TCCR1A |= 0;
+    TCCR1B |= 0x0A; // CTC, clk/8: a count is 8 CPU clocks (0.5us), see profile.h
+    // Value for the interruption (OCR1A)
+    // 50047 = 25.024 ms (the period of the previous clk/1024 setting, 390)
+    // 39999 = 20  ms
+    // 19999 = 10  ms
+    // 9999  = 5   ms
+    TIMSK1 |= (1<<OCIE1A);
+
+    // initialization of the flags and other global variables
+    tickCount = 0;
+    enablePID = 1;
+    nb_tics_cmd = 0;
+    nb_tics_target = 0;
+    nbFlat = 0;
+
+    pid.setSetpointWeight(DEFAULT_SETPOINT_WEIGHT);
+    pid.setDerivativeFilter(DEFAULT_D_FILTER);
+    supervisor.setTimeout(COMM_SPEED, COMM_SPEED_TIMEOUT);
+    supervisor.setDeceleration(COMM_DECELERATION);
+
+    // the yellow LED shows that the board is alive (from the timer interruption)
+    yellowPattern.set(LED_PATTERN_HEARTBEAT);
+
+    // to enable the LM2575
+    Output<GPIO_PORTC,PORTC7>::init(false);
+    bootStamp(BOOT_STAGE_IO);
+
+    // initialization of the SPI communication
+    spi.spi_init_master(true, SPI_FALLING_EDGE);
+
+    configureCounters();
+    counter.clear_counter(); // reset the counter value
+    counter.clear_status_register(); // clear the counter register
+#ifdef DUAL_ENCODER
+    counterB.clear_counter();
+    counterB.clear_status_register();
+#endif
+    // check the SPI link (no speed measure without the counter)
+    bool counterOk = checkCounters();
+    bootStamp(BOOT_STAGE_COUNTER);
+
+    initCANBus(); // initialization of the CAN Bus
+    CANTCON = CAN_TIMER_PRESCALER; // CAN timer for the reception time stamps
+    initCANMOBasReceiver (CAN_MOB_SPEED, ID_MOTORBOARD_DATASPEED, 0); // initialization of the CAN MOB
+    initCANMOBasReceiver (CAN_MOB_CONFIG, ID_MOTORBOARD_CONFIG, 0); // configuration commands
+    CANIE2 |= (1 << CAN_MOB_SEND); // a reply sent wakes the main loop up, for the queued replies
+    initCANMOBasAutoReply(CAN_MOB_STATUS, ID_MOTORBOARD_STATUS); // status, armed at each tick
+    bootStamp(BOOT_STAGE_CAN);
+
+    // initialization of the current measurement and of the protections
+    adc.init();
+    currentChannel = adc.addChannel(CURRENT_ADC_CHANNEL);
+    tempChannel = adc.addChannel(TEMP_ADC_CHANNEL);
+    thermal.setModel(THERMAL_WINDING, THERMAL_WINDING_SHIFT, CURRENT_MA_TO_ADC(THERMAL_WINDING_MA) - CURRENT_ADC_OFFSET);
+    thermal.setModel(THERMAL_BRIDGE, THERMAL_BRIDGE_SHIFT, CURRENT_MA_TO_ADC(THERMAL_BRIDGE_MA) - CURRENT_ADC_OFFSET);
+    thermal.setDeratingStart(THERMAL_DERATING_START);
+    supply.setNominal(VBUS_NOMINAL_MV, VBUS_UNDERVOLTAGE_MV, VBUS_OVERVOLTAGE_MV);
+#ifdef VBUS_ADC_CHANNEL
+    vbusChannel = adc.addChannel(VBUS_ADC_CHANNEL);
+#endif
+    protection.setCurrentLimit(CURRENT_MA_TO_ADC(CURRENT_LIMIT_MA), CURRENT_LIMIT_NB_TICKS);
+    protection.setStallDetection(STALL_MIN_DUTY, STALL_MAX_TICS, STALL_NB_TICKS);
+    bootStamp(BOOT_STAGE_ADC);
+
+    // the PLL has been locking since the PWM initialization
+    while (!pwm.poll());
+    bootStamp(BOOT_STAGE_PLL);
+
+    motor.setDutyCompensation(DUTY_OFFSET_NS, DUTY_MIN_PULSE_NS); // linearization around 0
+    motor.enableMotor(); // enable the motor
+    protection.enableTrip(CURRENT_MA_TO_ADC(CURRENT_TRIP_MA)); // hardware overcurrent trip
+    if(!counterOk){ protection.trip(FAULT_COUNTER); } // reported by the timer interruption
+
+    bootStamp(BOOT_STAGE_READY);
+    sei(); // set enable interruption
+    wdt_enable(WATCHDOG_TIMEOUT);
+
+    uint8_t lastTick = tickCount;
+    set_sleep_mode(SLEEP_MODE_IDLE); // the PSC, SPI, CAN, ADC and timers keep running
+    while(1) {
+        // the watchdog is reset only if the control loop is running
+        if(tickCount != lastTick && !bootloaderRequest){
+            lastTick = tickCount;
+            wdt_reset();
+        }
+        // everything is handled with the interruption (timer and CAN interruptions)
+        // the PWM is restarted here after a change of PLL frequency (see M32m1_pwm::poll)
+        pwm.poll();
+        // the capture is sent frame by frame, when the MOB is free
+        dumpCapture();
+        // the replies that found their MOB busy (sent one by one, when the MOB is free)
+        sendQueuedReply();
+        // reset in the CAN bootloader once the pending replies are sent (or by the
+        // watchdog of the main loop, no longer reset, if the bus does not take them)
+        if(bootloaderRequest && replyCount == 0 && !isCANMOBBusy(CAN_MOB_SEND)){
+            wdt_enable(WDTO_15MS);
+            while(1);
+        }
+
+        // sleep until the next interruption, unless the PLL lock or the capture dump are polled
+        cli();
+        if(pwm.isRunning() && captureDump == CAPTURE_NO_DUMP){
+            idleStart = TCNT1;
+            sleeping = true;
+            sleep_enable();
+            sei(); // the instruction after sei is executed before any interruption
+            sleep_cpu();
+            sleep_disable();
+        }
+        sei();
+    }
+}
+
+
+//! \fn void updateCommandLatency()
+//! \brief Measure the delay from the reception of the speed frame to the PWM update.
+//! This function is called from the timer interruption, once the PWM is updated.
+static inline void updateCommandLatency(){
+    if(!canCommandPending) return;
+    uint16_t latency = CANTIM - canCommandStamp;
+    if(latency > canLatencyMax) canLatencyMax = latency;
+    canCommandPending = false;
+}
+
+//! \fn void beginNestable()
+//! \brief Let the overcurrent trip interrupt a long interruption (timer or CAN).
+//! The timer and CAN interruptions are masked: they never nest into each other, their
+//! data are shared without protection. Only the trip and the ADC interruptions can nest.
+static inline void beginNestable(){
+    TIMSK1 &= ~(1<<OCIE1A);
+    CANGIE &= ~(1<<ENIT);
+    sei();
+}
+
+//! \fn void endNestable()
+//! \brief End of the nestable part of an interruption.
+//! The timer and CAN interruptions raised meanwhile are served after this one.
+static inline void endNestable(){
+    cli();
+    CANGIE |= (1<<ENIT);
+    TIMSK1 |= (1<<OCIE1A);
+}
+
+//! \fn ISR(TIMER1_COMPA_vect)
+//! \brief TIMER 1 interruption.
+//! This function is called when a TIMER1 interruption is raised.
+ISR(TIMER1_COMPA_vect){
+    cli(); // clear all interruption
+    TIFR1 |= 0; // reset the timer for the next interruption
+    idleStop();
+    // CPU load of the previous control period
+    idleLast = idleCounts;
+    if(idleCounts < idleMin) idleMin = idleCounts;
+    idleCounts = 0;
+    // the overcurrent trip is not delayed by the SPI transactions and the computations
+    beginNestable();
+    PROFILE_BEGIN(PROFILE_TIMER_ISR);
+
+    // an index pulse latched the counter value in the OTR (LFLAG/ low until the status register is cleared),
+    // the status register is also sampled at a low rate for the diagnostics.
+    // The counter value is read through the OTR: the index value is read first
+    bool indexed = !COUNTER_LFLAG::read();
+    int32_t indexCount = 0;
+    if(encoderHealth.tick() || indexed){
+        // the latched flags are cleared with the index flag, check them first
+        bool latched = encoderHealth.checkStatus(counter.read_status_register());
+        if(indexed || latched){ counter.clear_status_register(); }
+        if(indexed){ indexCount = counter.read_OTR(); }
+    }
+
+    // the counter is free running (no count lost between a read and a clear)
+    PROFILE_BEGIN(PROFILE_READ_COUNTER);
+#ifdef DUAL_ENCODER
+    // the two counters are latched by the same SPI byte, then read one after the other
+    counters.load_OTR();
+    int32_t count = counter.read_OTR();
+    int32_t loadCount = counterB.read_OTR()*SIDE_MOTOR;
+    loadSpeed = (int16_t)(loadCount - loadPosition);
+    loadPosition = loadCount;
+#else
+    int32_t count = counter.read_counter(); // read the counter value
+#endif
+    PROFILE_END(PROFILE_READ_COUNTER);
+    // a transaction of the bus interrupted by another one (see spi_bus.h): the values are not reliable
+    if(CounterBus::overlaps() != 0){ protection.trip(FAULT_COUNTER); }
+    int16_t val = (int16_t)(count - lastCount)*SIDE_MOTOR; // the counter value of the tick
+    lastCount = count;
+    position = count*SIDE_MOTOR;
+
+    if(indexed){ encoderIndex.onIndex(indexCount*SIDE_MOTOR); }
+    if(!COUNTER_LFLAG::read()){
+        // index during the reads, its OTR value may have been overwritten by the counter value:
+        // its position is not known (the counts of the tick are more than the tolerance)
+        counter.clear_status_register();
+        encoderIndex.onLostIndex();
+    }
+    encoderHealth.checkSpeed(val);
+    
+    if(val == 0){ // if the motor did not turned
+        nbFlat ++; // increments the flat flag
+    }else{
+        nbFlat = 0; // reset the flat flag
+    }
+
+    // check the current and the stall conditions (with the current measured during the previous tick)
+    uint16_t current = adc.value(currentChannel);
+    protection.check(current, val);
+    // the thermal models derate the maximum duty cycle, applied from this tick
+    motor.setDutyLimit(thermal.update(current > CURRENT_ADC_OFFSET ? current - CURRENT_ADC_OFFSET : 0,
+                                      motor.getDutyCycle(), val));
+    // the duty cycles are scaled by nominal / supply voltage
+#ifdef VBUS_ADC_CHANNEL
+    supply.update(VBUS_ADC_TO_MV(adc.value(vbusChannel)));
+#else
+    supply.update(vbusCommand);
+#endif
+    int16_t maxCmd = supply.available(motor.getDutyLimit())/TIC2PWM_FACTOR; // counter command giving the maximum PWM
+    adc.startScan();
+
+    // after a command loss, the target is ramped down to 0
+    if(supervisor.tick(CANTIM)){
+        nb_tics_target = supervisor.ramp(nb_tics_target);
+    }
+
+    int16_t speed = 0; // the speed applied to the motor
+    if(protection.isFaulted()){
+        // the motor has been disabled or braked by the protection, until the fault is cleared
+        if (enablePID) {pid.reset(); } // reset the PID
+        observer.reset();
+        nb_tics_target = 0; // reset the speed target
+        // the report waits for the MOB if the previous one is not sent yet
+        if(!isCANMOBBusy(CAN_MOB_FAULT) && protection.takeReport()){
+            uint8_t data[3] = {protection.getFault(), (uint8_t)(current >> 8), (uint8_t)current};
+            sendData(CAN_MOB_FAULT, ID_MOTORBOARD_FAULT, 3, data);
+        }
+    }else if(nb_tics_target == 0 || nbFlat > MAX_NB_FLAT){
+        // the motor is stopped if:
+        //      - the speed command is 0 (or the target has been ramped down after a command loss)
+        //      - the number of 0 counter value is over the max value (possible emergency stop)
+        if (enablePID) {pid.reset(); } // reset the PID
+        observer.reset();
+        motor.setSpeed(0);
+        nb_tics_target = 0; // reset the speed target
+    }else{
+        if(enablePID){ // if the PID is enabled
+            // the load estimated by the disturbance observer is added to the command
+            int16_t disturbance = 0;
+            if (observer.isEnabled()) { disturbance = observer.update(val, maxCmd); }
+            // the PID output is bounded so that the command stays within the PWM range (anti-windup)
+            pid.setOutputLimits(-maxCmd - nb_tics_cmd - disturbance, maxCmd - nb_tics_cmd - disturbance);
+            // update the PID gains according to the speed
+            if (schedule.isEnabled()) { schedule.apply(&pid, nb_tics_target, val); }
+            // compute the corrected command with the PID
+            PROFILE_BEGIN(PROFILE_PID_UPDATE);
+            int16_t cmd = nb_tics_cmd + disturbance + pid.update(nb_tics_target, val);
+            PROFILE_END(PROFILE_PID_UPDATE);
+            observer.setCommand(cmd);
+            // set the motor speed
+            speed = supply.compensate(F_MOTOR_TIC2PWM(cmd));
+            PROFILE_BEGIN(PROFILE_SET_SPEED);
+            motor.setSpeed(speed);
+            PROFILE_END(PROFILE_SET_SPEED);
+            updateCommandLatency();
+        }else{
+            // if the PID is desactivated, set directly the motor with the estimated transfer function
+            int16_t cmd = nb_tics_cmd;
+            if (cmd >  maxCmd) cmd =  maxCmd;
+            if (cmd < -maxCmd) cmd = -maxCmd;
+            speed = supply.compensate(F_MOTOR_TIC2PWM(cmd));
+            motor.setSpeed(speed);
+            updateCommandLatency();
+            // the PID follows the open loop command, to be enabled without bump
+            pid.initialize(0, nb_tics_target, val);
+            observer.reset();
+        }
+    }
+
+    // record the signals of the tick, the buffer is dumped once the capture is done
+    if (capture.isRecording()) {
+        CaptureRecord rec = {Capture::saturate(val), Capture::saturate(nb_tics_target),
+                             Capture::saturate(pid.getProportional()), Capture::saturate(pid.getIntegral()),
+                             Capture::saturate(pid.getDerivative()), speed, (uint8_t)(current >> 2)};
+        capture.record(rec, protection.isFaulted() ? CAPTURE_TRIGGER_FAULT : 0);
+        if (capture.getState() == CAPTURE_DONE) { captureDump = 0; }
+    }
+
+    // update the LEDs: the red LED blinks the fault code
+    redPattern.set(LedPattern::blinkCode(protection.getFault()));
+    redLed.setState(redPattern.tick());
+    yellowLed.setState(yellowPattern.tick());
+
+    // the status is sent by the CAN controller (payload updated in place, the MOB stays armed)
+    uint8_t flags = (motor.isEnabled() ? STATUS_MOTOR_ENABLED : 0) | (enablePID ? STATUS_PID_ENABLED : 0)
+                  | (supervisor.isLost() ? STATUS_COMM_LOST : 0) | (capture.isRecording() ? STATUS_CAPTURE : 0)
+                  | ((supply.getFlags() & SUPPLY_UNDERVOLTAGE) ? STATUS_UNDERVOLTAGE : 0)
+                  | ((supply.getFlags() & SUPPLY_OVERVOLTAGE) ? STATUS_OVERVOLTAGE : 0);
+    uint8_t status[8] = {(uint8_t)(val >> 8), (uint8_t)val,
+                         (uint8_t)(position >> 24), (uint8_t)(position >> 16), (uint8_t)(position >> 8), (uint8_t)position,
+                         protection.getFault(), flags};
+    updateCANMOBAutoReply(CAN_MOB_STATUS, 8, status);
+    tickCount++;
+    PROFILE_END(PROFILE_TIMER_ISR);
+    endNestable();
+}
+
+//! \fn ISR(ANACOMP3_vect)
+//! \brief Analog comparator 3 interruption.
+//! This function is called when the current goes over the trip level.
+ISR(ANACOMP3_vect){
+    idleStop();
+    protection.onTrip(); // disable the motor immediately
+}
+
+//! \fn ISR(ADC_vect)
+//! \brief ADC interruption.
+//! This function is called at the end of each ADC conversion.
+ISR(ADC_vect){
+    idleStop();
+    adc.onConversionComplete(); // store the value, convert the next channel
+}
+
+//! \fn ISR(CAN_INT_vect)
+//! \brief CAN interruption.
+//! This function is called when an CAN interruption is raised.
+ISR(CAN_INT_vect){
+    cli(); // disable the interruption (no to be disturbed when dealing with one)
+    idleStop();
+    // the overcurrent trip is not delayed by the configuration commands (EEPROM writes...)
+    beginNestable();
+    PROFILE_BEGIN(PROFILE_CAN_ISR);
+
+    if ( (CANSIT2 & (1 << CAN_MOB_SPEED)) != 0x00){ // MOB1 interruption - SET MOTOR SPEED
+        // get the data from the mob 1:
+        uint8_t data[8];
+        uint8_t dlc = getData(CAN_MOB_SPEED, data);
+        uint16_t stamp = CANSTM; // reception time of the frame (MOB 1 still selected)
+        int16_t nb_tics_new_target; // to update the speed target (counter value)
+        if(!decodeSpeedFrame(data, dlc, MRADS_TO_TICS_Q22, &nb_tics_new_target)){
+            canInvalidFrames++;
+        }else{
+            canSpeedFrames++;
+            if(!canCommandPending){
+                canCommandStamp = stamp;
+                canCommandPending = true;
+            }
+            supervisor.onCommand(COMM_SPEED, stamp); // a new command has been received
+            yellowPattern.flash(); // CAN activity
+
+            if(nb_tics_new_target != nb_tics_target){
+                // if the target speed has been changed
+                nb_tics_target = nb_tics_new_target; // update the target
+                capture.trigger(CAPTURE_TRIGGER_COMMAND);
+                //nb_tics_cmd = nb_tics_target; // update the command according to the target
+                //if (enablePID) {pid.reset(); } // reset the PID
+                nbFlat = 0; // reset the nbFlat flag
+            } // otherwise, nothing to change
+        }
+
+        // reset the MOB1 configuration for next CAN message
+        rearmCANMOBasReceiver(CAN_MOB_SPEED);
+    }
+
+    if ( (CANSIT2 & (1 << CAN_MOB_SEND)) != 0x00){ // MOB0 interruption - REPLY SENT
+        clearCANMOBStatus(CAN_MOB_SEND); // the main loop sends the next queued reply
+    }
+
+    if ( (CANSIT2 & (1 << CAN_MOB_STATUS)) != 0x00){ // MOB4 interruption - STATUS SENT
+        rearmCANMOBAutoReply(CAN_MOB_STATUS, 8); // ready for the next remote frame, same payload
+    }
+
+    if ( (CANSIT2 & (1 << CAN_MOB_CONFIG)) != 0x00){ // MOB2 interruption - CONFIGURATION
+        uint8_t data[8];
+        uint8_t dlc = getData(CAN_MOB_CONFIG, data);
+        supervisor.onCommand(COMM_CONFIG, CANSTM); // reception time of the frame (MOB 2 still selected)
+        processConfigCommand(data, dlc);
+        rearmCANMOBasReceiver(CAN_MOB_CONFIG); // ready for the next configuration command
+    }
+
+    PROFILE_END(PROFILE_CAN_ISR);
+    endNestable();
+}
+
+//! \fn void sendReply(uint8_t dlc, uint8_t* data)
+//! \brief Send a reply to a configuration command (from the CAN interruption).
+//! The previous reply may still be waiting for the bus: it is not overwritten, the new
+//! reply is queued and sent by the main loop (no wait in the interruption). The reply is
+//! dropped if CAN_REPLY_QUEUE_SIZE replies are already waiting.
+static void sendReply(uint8_t dlc, uint8_t* data){
+    if(replyCount == 0 && !isCANMOBBusy(CAN_MOB_SEND)){
+        sendData(CAN_MOB_SEND, ID_MOTORBOARD_REPLY, dlc, data);
+        return;
+    }
+    if(replyCount >= CAN_REPLY_QUEUE_SIZE) return;
+    uint8_t* reply = replyQueue[(replyFirst + replyCount) % CAN_REPLY_QUEUE_SIZE];
+    reply[0] = dlc;
+    for(uint8_t i=0; i<dlc; i++){ reply[1+i] = data[i]; }
+    replyCount++;
+}
+
+//! \fn void setCounterFilter(uint8_t filter)
+//! \brief Select the clock filter of the counters (FILTER_1 or FILTER_2), the same on both counters.
+static void setCounterFilter(uint8_t filter){
+    counterFilter = filter;
+    counter.write_mode_register_0(COUNTER_MODE_0 | filter);
+#ifdef DUAL_ENCODER
+    counterB.write_mode_register_0(COUNTER_B_MODE_0 | filter);
+#endif
+}
+
+//! \fn void processConfigCommand(const uint8_t* data, uint8_t dlc)
+//! \brief Process a configuration command.
+//! This function is called from the CAN interruption, the first byte is the command.
+void processConfigCommand(const uint8_t* data, uint8_t dlc){
+    if(dlc < 1) return;
+
+    if((data[0] & 0xF0) == CONFIG_SET_GAIN_POINT){ // | speed | kp | ki | kd
+        if(dlc == 8){
+            uint8_t direction = (data[0] & 0x08) ? GAIN_SCHEDULE_BACKWARD : GAIN_SCHEDULE_FORWARD;
+            schedule.setPoint(direction, data[0] & 0x07, data[1],
+                              (uint16_t)(data[2] << 8) | data[3],
+                              (uint16_t)(data[4] << 8) | data[5],
+                              (uint16_t)(data[6] << 8) | data[7]);
+        }
+        return;
+    }
+
+    switch(data[0]){
+    case CONFIG_CLEAR_FAULT:
+        if(protection.getFault() == FAULT_COUNTER){
+            // no closed loop control on a broken sensor: the counters are configured again
+            // (power loss), the fault is kept if they still do not answer
+            CounterBus::clearOverlaps();
+            configureCounters();
+            if(!checkCounters()) break;
+        }
+        protection.clear();
+        break;
+    case CONFIG_SET_PID_GAINS: // | kp | ki | kd
+        if(dlc == 7){
+            for(uint8_t i=0; i<3; i++){
+                pidGains[i] = (uint16_t)(data[1+2*i] << 8) | data[2+2*i];
+            }
+            if(!schedule.isEnabled()){ pid.setGains(pidGains[0], pidGains[1], pidGains[2]); }
+        }
+        break;
+    case CONFIG_GAIN_SCHEDULE: // | flags
+        if(dlc == 2){
+            if(data[1] & 0x80){ schedule.clear(); }
+            schedule.setEnabled(data[1] & 0x01, data[1] & 0x02);
+            if(!schedule.isEnabled()){ pid.setGains(pidGains[0], pidGains[1], pidGains[2]); }
+        }
+        break;
+    case CONFIG_SET_PWM_FREQUENCY: // | frequency
+        if(dlc == 4){
+            uint32_t frequency = ((uint32_t)data[1] << 16) | ((uint16_t)data[2] << 8) | data[3];
+            uint16_t counterMax = motor.setPwmFrequency(frequency);
+            frequency = pwm.getFrequency();
+            uint8_t reply[6] = {CONFIG_SET_PWM_FREQUENCY, (uint8_t)(counterMax >> 8), (uint8_t)counterMax,
+                                (uint8_t)(frequency >> 16), (uint8_t)(frequency >> 8), (uint8_t)frequency};
+            sendReply(6, reply);
+        }
+        break;
+    case CONFIG_SET_DUTY_COMPENSATION: // | offset | min pulse
+        if(dlc == 5){
+            motor.setDutyCompensation((uint16_t)(data[1] << 8) | data[2], (uint16_t)(data[3] << 8) | data[4]);
+        }
+        break;
+    case CONFIG_SET_DRIVE_MODE: // | mode
+        if(dlc == 2){
+            motor.setDriveMode(data[1]);
+        }
+        break;
+    case CONFIG_GET_BOOT_TIMES: // | first stage
+        if(dlc == 2){
+            uint8_t reply[8] = {CONFIG_GET_BOOT_TIMES, data[1]};
+            for(uint8_t i=0; i<3; i++){
+                uint16_t time = BOOT_TIME_OVERFLOW;
+                if(data[1]+i < BOOT_NB_STAGES && bootTimes[data[1]+i] != BOOT_TIME_OVERFLOW){
+                    time = bootTimes[data[1]+i]/TIMER1_COUNTS_PER_US;
+                }
+                reply[2+2*i] = time >> 8;
+                reply[3+2*i] = time;
+            }
+            sendReply(8, reply);
+        }
+        break;
+    case CONFIG_CAPTURE: // | mode | post-trigger | threshold
+        if(dlc >= 2){
+            uint8_t mode = data[1];
+            if(mode & CAPTURE_MODE_STOP){ capture.stop(); }
+            if((mode & CAPTURE_MODE_ARM) && dlc == 4){
+                captureDump = CAPTURE_NO_DUMP; // the buffer is overwritten
+                capture.arm(mode & 0x07, data[2], data[3]);
+            }
+            if(mode & CAPTURE_MODE_TRIGGER){ capture.trigger(CAPTURE_TRIGGER_MANUAL); }
+            if((mode & CAPTURE_MODE_DUMP) && !capture.isRecording()){ captureDump = 0; }
+        }
+        break;
+    case CONFIG_ENTER_BOOTLOADER: // | node
+        if(dlc == 2 && data[1] < CAN_BOOT_MAX_NODES){
+            motor.disableMotor();
+            eeprom_update_byte((uint8_t*)CAN_BOOT_EE_NODE, data[1]);
+            eeprom_update_byte((uint8_t*)CAN_BOOT_EE_REQUEST, CAN_BOOT_REQUEST_MAGIC);
+            // reset by the watchdog from the main loop, the bootloader stays active
+            bootloaderRequest = true;
+        }
+        break;
+    case CONFIG_GET_CAN_STATS: // | reset
+        {
+            uint16_t frames = canSpeedFrames;
+            uint16_t latency = canLatencyMax;
+            uint8_t reply[8] = {CONFIG_GET_CAN_STATS, (uint8_t)(frames >> 8), (uint8_t)frames, canInvalidFrames,
+                                (uint8_t)(latency >> 8), (uint8_t)latency, CANREC, CANTEC};
+            sendReply(8, reply);
+            if(dlc == 2 && data[1] == 1){
+                canSpeedFrames = 0;
+                canInvalidFrames = 0;
+                canLatencyMax = 0;
+            }
+        }
+        break;
+    case CONFIG_SET_COMM_TIMEOUT: // | type | timeout | deceleration
+        if(dlc == 5){
+            supervisor.setTimeout(data[1], (uint16_t)(data[2] << 8) | data[3]);
+            supervisor.setDeceleration(data[4]);
+        }
+        break;
+    case CONFIG_GET_CPU_LOAD: // | reset
+        {
+            uint16_t load = cpuLoad(idleLast);
+            uint16_t peak = cpuLoad(idleMin);
+            uint8_t reply[5] = {CONFIG_GET_CPU_LOAD, (uint8_t)(load >> 8), (uint8_t)load,
+                                (uint8_t)(peak >> 8), (uint8_t)peak};
+            sendReply(5, reply);
+            if(dlc == 2 && data[1] == 1){ idleMin = 0xFFFF; }
+        }
+        break;
+    case CONFIG_GET_COMMAND_AGE:
+        {
+            uint16_t speedAge = supervisor.getAge(COMM_SPEED);
+            uint16_t configAge = supervisor.getAge(COMM_CONFIG);
+            uint8_t reply[5] = {CONFIG_GET_COMMAND_AGE, (uint8_t)(speedAge >> 8), (uint8_t)speedAge,
+                                (uint8_t)(configAge >> 8), (uint8_t)configAge};
+            sendReply(5, reply);
+        }
+        break;
+    case CONFIG_INDEX: // | counts per index | tolerance
+        if(dlc == 4){
+            encoderIndex.setCountsPerIndex((uint16_t)(data[1] << 8) | data[2], data[3]);
+        }
+        {
+            uint16_t angle = encoderIndex.isReferenced() ? encoderIndex.getAngle(position) : 0xFFFF;
+            uint16_t indexes = encoderIndex.getNbIndexes();
+            int16_t error = encoderIndex.getLastError();
+            uint8_t reply[8] = {CONFIG_INDEX, (uint8_t)(angle >> 8), (uint8_t)angle,
+                                (uint8_t)(indexes >> 8), (uint8_t)indexes, encoderIndex.getNbErrors(),
+                                (uint8_t)(error >> 8), (uint8_t)error};
+            sendReply(8, reply);
+        }
+        break;
+    case CONFIG_ENCODER_HEALTH: // | flags
+        if(dlc == 2){
+            // the filter is only changed when requested
+            if(data[1] & 0x01){ setCounterFilter(FILTER_2); }
+            else if(data[1] & 0x02){ setCounterFilter(FILTER_1); }
+            if(data[1] & 0x80){ encoderHealth.clear(); }
+        }
+        {
+            uint8_t reply[8] = {CONFIG_ENCODER_HEALTH};
+            for(uint8_t i=0; i<ENCODER_NB_ANOMALIES; i++){
+                reply[1+i] = encoderHealth.getCount(i);
+            }
+            reply[7] = encoderHealth.getLastStatus();
+            sendReply(8, reply);
+        }
+        break;
+    case CONFIG_GET_LOAD_ENCODER:
+        {
+#ifdef DUAL_ENCODER
+            uint8_t reply[7] = {CONFIG_GET_LOAD_ENCODER, (uint8_t)(loadSpeed >> 8), (uint8_t)loadSpeed,
+                                (uint8_t)(loadPosition >> 24), (uint8_t)(loadPosition >> 16),
+                                (uint8_t)(loadPosition >> 8), (uint8_t)loadPosition};
+            sendReply(7, reply);
+#else
+            uint8_t reply[1] = {CONFIG_GET_LOAD_ENCODER};
+            sendReply(1, reply);
+#endif
+        }
+        break;
+    case CONFIG_THERMAL: // | source | derating start | kDuty | kSpeed
+        if(dlc == 7){
+            thermal.setSource(data[1]);
+            thermal.setDeratingStart(data[2]);
+            thermal.setBackEmfModel((uint16_t)(data[3] << 8) | data[4], (uint16_t)(data[5] << 8) | data[6]);
+        }
+        {
+            uint16_t winding = thermal.getLevel(THERMAL_WINDING);
+            uint16_t bridge = thermal.getLevel(THERMAL_BRIDGE);
+            uint16_t limit = motor.getDutyLimit();
+            uint8_t reply[8] = {CONFIG_THERMAL, (uint8_t)(winding >> 8), (uint8_t)winding,
+                                (uint8_t)(bridge >> 8), (uint8_t)bridge, (uint8_t)(limit >> 8), (uint8_t)limit,
+                                (uint8_t)(adc.value(tempChannel) >> 2)};
+            sendReply(8, reply);
+        }
+        break;
+    case CONFIG_SET_VBUS: // | voltage
+#ifndef VBUS_ADC_CHANNEL
+        if(dlc == 3){
+            vbusCommand = (uint16_t)(data[1] << 8) | data[2];
+        }
+#endif
+        break;
+    case CONFIG_SUPPLY: // | flags | nominal | undervoltage | overvoltage
+        if(dlc == 8){
+            supply.setEnabled(data[1] & 0x01);
+            supply.setNominal((uint16_t)(data[2] << 8) | data[3], (uint16_t)(data[4] << 8) | data[5],
+                              (uint16_t)(data[6] << 8) | data[7]);
+        }
+        {
+            uint16_t voltage = supply.getVoltage();
+            uint16_t gain = supply.getGain();
+            uint8_t reply[6] = {CONFIG_SUPPLY, (uint8_t)(voltage >> 8), (uint8_t)voltage, supply.getFlags(),
+                                (uint8_t)(gain >> 8), (uint8_t)gain};
+            sendReply(6, reply);
+        }
+        break;
+    case CONFIG_DISTURBANCE_OBSERVER: // | flags | bandwidth | time constant
+        if(dlc == 5){
+            observer.setParameters(data[2], (uint16_t)(data[3] << 8) | data[4]);
+        }
+        if(dlc == 2 || dlc == 5){
+            observer.setEnabled(data[1] & 0x01);
+        }
+        {
+            int16_t estimate = observer.getEstimate();
+            uint8_t reply[4] = {CONFIG_DISTURBANCE_OBSERVER, observer.isEnabled(),
+                                (uint8_t)(estimate >> 8), (uint8_t)estimate};
+            sendReply(4, reply);
+        }
+        break;
+    case CONFIG_GET_PROFILE: // | probe
+        if(dlc == 2){
+#ifdef PROFILE
+            if(data[1] < PROFILE_NB_PROBES){
+                uint32_t last = profileLast(data[1]);
+                uint32_t max = profileMax(data[1]);
+                uint8_t reply[8] = {CONFIG_GET_PROFILE, data[1],
+                                    (uint8_t)(last >> 16), (uint8_t)(last >> 8), (uint8_t)last,
+                                    (uint8_t)(max >> 16), (uint8_t)(max >> 8), (uint8_t)max};
+                sendReply(8, reply);
+            }
+#else
+            uint8_t reply[2] = {CONFIG_GET_PROFILE, 0xFF};
+            sendReply(2, reply);
+#endif
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+//! \fn void dumpCapture()
+//! \brief Send the next frame of the capture dump.
+//! This function is called from the main loop, a frame is sent when the MOB is free.
+void dumpCapture(){
+    if(captureDump == CAPTURE_NO_DUMP || isCANMOBBusy(CAN_MOB_CAPTURE)) return;
+
+    // the CAN page is shared with the interruptions, and a new capture can be armed
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        uint8_t position = captureDump;
+        if(position == CAPTURE_NO_DUMP) return;
+        if(position == 0){
+            uint8_t data[4] = {capture.getNbRecords(), capture.getTriggerPosition(),
+                               capture.getTriggerSource(), capture.getPostTrigger()};
+            sendData(CAN_MOB_CAPTURE, ID_MOTORBOARD_CAPTURE, 4, data);
+        }else{
+            const CaptureRecord& rec = capture.getRecord(position-1);
+            uint8_t data[8] = {(uint8_t)rec.val, (uint8_t)rec.target, (uint8_t)rec.p, (uint8_t)rec.i,
+                               (uint8_t)rec.d, (uint8_t)(rec.pwm >> 8), (uint8_t)rec.pwm, rec.current};
+            sendData(CAN_MOB_CAPTURE, ID_MOTORBOARD_CAPTURE, 8, data);
+        }
+        captureDump = (position >= capture.getNbRecords()) ? CAPTURE_NO_DUMP : position+1;
+    }
+}
+
+//! \fn void sendQueuedReply()
+//! \brief Send the oldest queued reply (see sendReply).
+//! This function is called from the main loop, the reply is sent when the MOB is free.
+void sendQueuedReply(){
+    if(replyCount == 0 || isCANMOBBusy(CAN_MOB_SEND)) return;
+
+    // the CAN page and the queue are shared with the CAN interruption
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+        uint8_t* reply = replyQueue[replyFirst];
+        sendData(CAN_MOB_SEND, ID_MOTORBOARD_REPLY, reply[0], reply + 1);
+        replyFirst = (replyFirst + 1) % CAN_REPLY_QUEUE_SIZE;
+        replyCount--;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef MOCK_AVR_EEPROM_H
+#define MOCK_AVR_EEPROM_H
+
+//! \file eeprom.h
+//! \brief Host replacement of <avr/eeprom.h> for the host run of the firmware
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define MOCK_EEPROM_SIZE    1024    //!< EEPROM of the ATmega32M1 (bytes)
+
+extern uint8_t mockEeprom[MOCK_EEPROM_SIZE];    //!< The EEPROM content (0xFF when erased)
+
+inline uint8_t eeprom_read_byte(const uint8_t* address) { return mockEeprom[(uintptr_t)address % MOCK_EEPROM_SIZE]; }
+inline void eeprom_write_byte(uint8_t* address, uint8_t value) { mockEeprom[(uintptr_t)address % MOCK_EEPROM_SIZE] = value; }
+inline void eeprom_update_byte(uint8_t* address, uint8_t value) { eeprom_write_byte(address, value); }
+inline void eeprom_busy_wait() {}
+
+#endif // MOCK_AVR_EEPROM_H
@@ -0,0 +1,18 @@
+#ifndef MOCK_AVR_INTERRUPT_H
+#define MOCK_AVR_INTERRUPT_H
+
+//! \file interrupt.h
+//! \brief Host replacement of <avr/interrupt.h> for the unit tests
+//! \date 2026 10 18
+//!
+//! The interruption vectors are plain functions, called by the host run of the
+//! firmware (see mock_firmware.h).
+
+#include <avr/io.h>
+
+#define ISR(vector, ...)    extern "C" void vector(void); extern "C" void vector(void)
+
+inline void sei() {}
+inline void cli() {}
+
+#endif // MOCK_AVR_INTERRUPT_H
@@ -0,0 +1,186 @@
+#ifndef MOCK_AVR_IO_H
+#define MOCK_AVR_IO_H
+
+//! \file io.h
+//! \brief Host replacement of <avr/io.h> for the unit tests
+//! \date 2026 10 18
+//!
+//! The registers are bytes of mockIo (mockIo16 for the 16-bit registers), indexed by
+//! their address. The GPIO registers are at their ATmega32M1 addresses (the Pin template
+//! accesses them with _MMIO_BYTE, see pin.h), the other addresses are only distinct.
+//! The registers of the CAN MOBs are proxies of the controller model (see mock_can.h).
+
+#include <stdint.h>
+
+extern volatile uint8_t mockIo[0x100];     //!< The 8-bit registers
+extern volatile uint16_t mockIo16[0x100];  //!< The 16-bit registers
+
+#define _MMIO_BYTE(addr)    (mockIo[(addr)])
+#define _MMIO_WORD(addr)    (mockIo16[(addr)])
+#define _BV(bit)            (1 << (bit))
+
+extern void (*mockPscWrite)(uint8_t address); //!< Called after each write of a duty cycle register
+                                              //!  of the PSC (POCRnSA, POCRnSB), 0 if none
+
+//! \class MockPscRegister
+//! \brief A duty cycle register of the PSC (a word of mockIo16), its writes call mockPscWrite
+template<uint8_t ADDR>
+class MockPscRegister
+{
+public:
+    inline operator uint16_t() const { return mockIo16[ADDR]; }
+    inline MockPscRegister& operator=(uint16_t value)
+    {
+        mockIo16[ADDR] = value;
+        if (mockPscWrite) mockPscWrite(ADDR);
+        return *this;
+    }
+};
+
+// GPIO
+#define PINB    _MMIO_BYTE(0x23)
+#define DDRB    _MMIO_BYTE(0x24)
+#define PORTB   _MMIO_BYTE(0x25)
+#define PINC    _MMIO_BYTE(0x26)
+#define DDRC    _MMIO_BYTE(0x27)
+#define PORTC   _MMIO_BYTE(0x28)
+#define PIND    _MMIO_BYTE(0x29)
+#define DDRD    _MMIO_BYTE(0x2A)
+#define PORTD   _MMIO_BYTE(0x2B)
+#define PINE    _MMIO_BYTE(0x2C)
+#define DDRE    _MMIO_BYTE(0x2D)
+#define PORTE   _MMIO_BYTE(0x2E)
+
+#define PB0     0
+#define PB1     1
+#define PB2     2
+#define PB3     3
+#define PB4     4
+#define PB5     5
+#define PB6     6
+#define PB7     7
+#define PORTC7  7
+
+// PLL
+#define PLLCSR  _MMIO_BYTE(0x49)
+#define PLLF    2
+#define PLLE    1
+#define PLOCK   0
+
+// SPI (the Spi class is replaced by mock_spi.cpp)
+#define SPCR    _MMIO_BYTE(0x4C)
+#define SPSR    _MMIO_BYTE(0x4D)
+#define SPDR    _MMIO_BYTE(0x4E)
+#define MCUCR   _MMIO_BYTE(0x55)
+#define SPE     6
+#define SPIF    7
+
+// PSC
+#define PMIC0   _MMIO_BYTE(0xB8)
+#define PMIC1   _MMIO_BYTE(0xB9)
+#define PMIC2   _MMIO_BYTE(0xBA)
+#define PCTL    _MMIO_BYTE(0xB7)
+#define POC     _MMIO_BYTE(0xB6)
+#define PCNF    _MMIO_BYTE(0xB5)
+#define POCR_RB _MMIO_WORD(0xB2)
+#define POCR2RA _MMIO_WORD(0xB0)
+#define POCR2SB (MockPscRegister<0xAE>{})
+#define POCR2SA (MockPscRegister<0xAC>{})
+#define POCR1RA _MMIO_WORD(0xAA)
+#define POCR1SB (MockPscRegister<0xA8>{})
+#define POCR1SA (MockPscRegister<0xA6>{})
+#define POCR0RA _MMIO_WORD(0xA4)
+#define POCR0SB (MockPscRegister<0xA2>{})
+#define POCR0SA (MockPscRegister<0xA0>{})
+
+#define POVEN0  7
+#define POVEN1  7
+#define POVEN2  7
+#define PPRE1   7
+#define PPRE0   6
+#define PCLKSEL 5
+#define PCCYC   1
+#define PRUN    0
+#define PULOCK  5
+#define PMODE   4
+#define POPB    3
+#define POPA    2
+
+// Reset and sleep
+#define MCUSR   _MMIO_BYTE(0x54)
+#define SMCR    _MMIO_BYTE(0x53)
+
+// Timer 1
+#define TIFR1   _MMIO_BYTE(0x36)
+#define TIMSK1  _MMIO_BYTE(0x6F)
+#define TCCR1A  _MMIO_BYTE(0x80)
+#define TCCR1B  _MMIO_BYTE(0x81)
+#define TCNT1   _MMIO_WORD(0x84)
+#define OCR1A   _MMIO_WORD(0x88)
+#define OCF1A   1
+#define OCIE1A  1
+
+// ADC, DAC and analog comparator 3
+#define ADC     _MMIO_WORD(0x78)
+#define ADCSRA  _MMIO_BYTE(0x7A)
+#define ADCSRB  _MMIO_BYTE(0x7B)
+#define ADMUX   _MMIO_BYTE(0x7C)
+#define DACON   _MMIO_BYTE(0x90)
+#define DAC     _MMIO_WORD(0x91)
+#define AC3CON  _MMIO_BYTE(0x97)
+#define ACSR    _MMIO_BYTE(0x50)
+#define ADEN    7
+#define ADSC    6
+#define ADIE    3
+#define REFS0   6
+#define DAEN    0
+#define AC3EN   7
+#define AC3IE   6
+#define AC3IS1  5
+#define AC3IS0  4
+#define AC3M2   2
+#define AC3M1   1
+#define AC3M0   0
+#define AC3IF   7
+#define AC3O    3
+
+// CAN, the registers of the MOBs are paged by CANPAGE (see mock_can.h)
+#define CANGCON     _MMIO_BYTE(0xD8)
+#define CANGSTA     _MMIO_BYTE(0xD9)
+#define CANGIE      _MMIO_BYTE(0xDB)
+#define CANIE2      _MMIO_BYTE(0xDE)
+#define CANBT1      _MMIO_BYTE(0xE2)
+#define CANBT2      _MMIO_BYTE(0xE3)
+#define CANBT3      _MMIO_BYTE(0xE4)
+#define CANTCON     _MMIO_BYTE(0xE5)
+#define CANTIM      _MMIO_WORD(0xE6)
+#define CANTEC      _MMIO_BYTE(0xEA)
+#define CANREC      _MMIO_BYTE(0xEB)
+#define CANHPMOB    _MMIO_BYTE(0xEC)
+#define CANPAGE     _MMIO_BYTE(0xED)
+#define CANEN2      (MockCanRegister<MOCK_CAN_EN2>{})
+#define CANSIT2     (MockCanRegister<MOCK_CAN_SIT2>{})
+#define CANSTMOB    (MockCanRegister<MOCK_CAN_STMOB>{})
+#define CANCDMOB    (MockCanRegister<MOCK_CAN_CDMOB>{})
+#define CANIDT1     (MockCanRegister<MOCK_CAN_IDT1>{})
+#define CANIDT2     (MockCanRegister<MOCK_CAN_IDT1 + 1>{})
+#define CANIDT3     (MockCanRegister<MOCK_CAN_IDT1 + 2>{})
+#define CANIDT4     (MockCanRegister<MOCK_CAN_IDT1 + 3>{})
+#define CANIDM1     (MockCanRegister<MOCK_CAN_IDM1>{})
+#define CANIDM2     (MockCanRegister<MOCK_CAN_IDM1 + 1>{})
+#define CANIDM3     (MockCanRegister<MOCK_CAN_IDM1 + 2>{})
+#define CANIDM4     (MockCanRegister<MOCK_CAN_IDM1 + 3>{})
+#define CANSTM      (MockCanTimeStamp{})
+#define CANMSG      (MockCanRegister<MOCK_CAN_MSG>{})
+#define SWRES   0
+#define ENIT    7
+#define TXBSY   4
+#define RXBSY   3
+#define TXOK    6
+#define RXOK    5
+#define RPLV    5
+#define AINC    3
+
+#include "mock_can.h"
+
+#endif // MOCK_AVR_IO_H
@@ -0,0 +1,22 @@
+#ifndef MOCK_AVR_SLEEP_H
+#define MOCK_AVR_SLEEP_H
+
+//! \file sleep.h
+//! \brief Host replacement of <avr/sleep.h> for the host run of the firmware
+//! \date 2026 10 18
+//!
+//! sleep_cpu hands the control back to the host until the next interruption (see mock_firmware.h).
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE     0
+
+//! \brief mockSleep The main loop of the firmware sleeps until the next interruption
+void mockSleep();
+
+inline void set_sleep_mode(uint8_t) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+inline void sleep_cpu() { mockSleep(); }
+
+#endif // MOCK_AVR_SLEEP_H
@@ -0,0 +1,38 @@
+#ifndef MOCK_AVR_WDT_H
+#define MOCK_AVR_WDT_H
+
+//! \file wdt.h
+//! \brief Host replacement of <avr/wdt.h> for the host run of the firmware
+//! \date 2026 10 18
+//!
+//! The watchdog does not run on the host: a timeout shorter than a control tick is a
+//! reset requested by the firmware, the MockWatchdogReset exception ends the firmware.
+
+#include <stdint.h>
+
+#define WDTO_15MS   0
+#define WDTO_30MS   1
+#define WDTO_60MS   2
+#define WDTO_120MS  3
+#define WDTO_250MS  4
+#define WDTO_500MS  5
+#define WDTO_1S     6
+#define WDTO_2S     7
+
+//! \struct MockWatchdogReset
+//! \brief Thrown by wdt_enable(WDTO_15MS): the firmware resets itself
+struct MockWatchdogReset {};
+
+extern uint8_t mockWdtTimeout;  //!< The timeout of the watchdog (WDTO_XXX), 0xFF when disabled
+
+inline void wdt_enable(uint8_t timeout)
+{
+    mockWdtTimeout = timeout;
+    if (timeout == WDTO_15MS) throw MockWatchdogReset();
+}
+
+inline void wdt_disable() { mockWdtTimeout = 0xFF; }
+
+inline void wdt_reset() {}
+
+#endif // MOCK_AVR_WDT_H
@@ -0,0 +1,96 @@
+#ifndef MOCK_CAN_H
+#define MOCK_CAN_H
+
+//! \file mock_can.h
+//! \brief Host model of the CAN controller of the ATmega32M1 (see mock_can.cpp)
+//! \date 2026 10 18
+//!
+//! The MOB registers are paged by CANPAGE: they are proxies of the MOB selected by
+//! CANPAGE (CANMSG with the auto-increment of INDX), CANEN2 and CANSIT2 are computed from
+//! the MOBs. The other CAN registers are plain mock registers (see avr/io.h). The frames
+//! are given to the controller by mockCanReceive, the frames sent are recorded.
+
+#include <stdint.h>
+
+#define MOCK_CAN_NB_MOBS    6       //!< Number of MOBs of the ATmega32M1
+#define MOCK_CAN_NB_SENT    64      //!< Number of frames sent recorded (the oldest ones are dropped)
+
+// Registers of the selected MOB (mockCanRead, mockCanWrite)
+#define MOCK_CAN_STMOB      0       //!< CANSTMOB
+#define MOCK_CAN_CDMOB      1       //!< CANCDMOB
+#define MOCK_CAN_IDT1       2       //!< CANIDT1 (CANIDT2 to CANIDT4 follow)
+#define MOCK_CAN_IDM1       6       //!< CANIDM1 (CANIDM2 to CANIDM4 follow)
+#define MOCK_CAN_MSG        10      //!< CANMSG (byte INDX of CANPAGE)
+#define MOCK_CAN_EN2        11      //!< CANEN2 (read only)
+#define MOCK_CAN_SIT2       12      //!< CANSIT2 (read only)
+
+//! \struct MockCanMob
+//! \brief State of a MOB
+struct MockCanMob
+{
+    uint8_t stmob;      //!< CANSTMOB
+    uint8_t cdmob;      //!< CANCDMOB
+    uint8_t idt[4];     //!< CANIDT1 to CANIDT4
+    uint8_t idm[4];     //!< CANIDM1 to CANIDM4
+    uint8_t msg[8];     //!< The data buffer
+    uint16_t stm;       //!< CANSTM, CANTIM at the end of the last frame
+    bool enabled;       //!< The bit of the MOB in CANEN2 (reception or transmission pending)
+};
+
+//! \struct MockCanFrame
+//! \brief A frame on the bus
+struct MockCanFrame
+{
+    uint16_t id;        //!< Identifier (11 bits)
+    bool rtr;           //!< Remote frame
+    uint8_t dlc;        //!< Data length code
+    uint8_t data[8];    //!< Data
+};
+
+extern MockCanMob mockCanMobs[MOCK_CAN_NB_MOBS];    //!< The MOBs
+extern MockCanFrame mockCanSent[MOCK_CAN_NB_SENT];  //!< The frames sent, in order
+extern uint8_t mockCanNbSent;                       //!< Number of frames in mockCanSent
+extern bool mockCanHoldTx;                          //!< The frames to send wait for mockCanTransmit (bus busy)
+
+//! \brief mockCanReset Reset the controller (MOBs disabled, no frame sent, immediate transmissions)
+void mockCanReset();
+
+//! \brief mockCanRead Read a paged register of the selected MOB (MOCK_CAN_XXX)
+uint8_t mockCanRead(uint8_t reg);
+
+//! \brief mockCanWrite Write a paged register of the selected MOB (MOCK_CAN_XXX)
+void mockCanWrite(uint8_t reg, uint8_t value);
+
+//! \brief mockCanReceive A frame received from the bus: stored by the first enabled reception
+//!        MOB that accepts it (the lowest number), or answered by an automatic reply MOB
+//! \return the MOB of the frame, -1 if no MOB accepts it (frame lost)
+int8_t mockCanReceive(const MockCanFrame& frame);
+
+//! \brief mockCanTransmit Send the frames of the enabled transmission MOBs (mockCanHoldTx)
+//! \return the number of frames sent
+uint8_t mockCanTransmit();
+
+//! \brief mockCanInterrupt The CAN interruption is raised (ENIT and an enabled MOB interruption)
+bool mockCanInterrupt();
+
+//! \class MockCanRegister
+//! \brief Proxy of a paged register of the selected MOB
+template<uint8_t REG>
+class MockCanRegister
+{
+public:
+    inline operator uint8_t() const { return mockCanRead(REG); }
+    inline MockCanRegister& operator=(uint8_t value) { mockCanWrite(REG, value); return *this; }
+    inline MockCanRegister& operator|=(uint8_t value) { mockCanWrite(REG, mockCanRead(REG) | value); return *this; }
+    inline MockCanRegister& operator&=(uint8_t value) { mockCanWrite(REG, mockCanRead(REG) & value); return *this; }
+};
+
+//! \class MockCanTimeStamp
+//! \brief Proxy of CANSTM (time stamp of the selected MOB, 16 bits)
+class MockCanTimeStamp
+{
+public:
+    operator uint16_t() const;
+};
+
+#endif // MOCK_CAN_H
@@ -0,0 +1,14 @@
+#ifndef MOCK_UTIL_ATOMIC_H
+#define MOCK_UTIL_ATOMIC_H
+
+//! \file atomic.h
+//! \brief Host replacement of <util/atomic.h> for the unit tests (no interruption on the host)
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+#define ATOMIC_BLOCK(type)  for (uint8_t _atomic_done = 0; !_atomic_done; _atomic_done = 1)
+
+#endif // MOCK_UTIL_ATOMIC_H
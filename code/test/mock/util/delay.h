@@ -0,0 +1,11 @@
+#ifndef MOCK_UTIL_DELAY_H
+#define MOCK_UTIL_DELAY_H
+
+//! \file delay.h
+//! \brief Host replacement of <util/delay.h> (no wait on the host)
+//! \date 2026 10 18
+
+inline void _delay_ms(double) {}
+inline void _delay_us(double) {}
+
+#endif // MOCK_UTIL_DELAY_H
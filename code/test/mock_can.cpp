@@ -0,0 +1,154 @@
+#include <string.h>
+#include <avr/io.h>
+
+MockCanMob mockCanMobs[MOCK_CAN_NB_MOBS];
+MockCanFrame mockCanSent[MOCK_CAN_NB_SENT];
+uint8_t mockCanNbSent;
+bool mockCanHoldTx;
+
+#define MOCK_CAN_CONMOB         0xC0    //!< CONMOB bits of CANCDMOB
+#define MOCK_CAN_CONMOB_TX      0x40    //!< Transmission
+#define MOCK_CAN_CONMOB_RX      0x80    //!< Reception
+#define MOCK_CAN_RTRTAG         0x04    //!< RTRTAG bit of CANIDT4 (RTRMSK in CANIDM4)
+#define MOCK_CAN_STATUS         0x7F    //!< Status bits of CANSTMOB raising the interruption of the MOB
+
+void mockCanReset()
+{
+    memset(mockCanMobs, 0, sizeof(mockCanMobs));
+    mockCanNbSent = 0;
+    mockCanHoldTx = false;
+}
+
+//! \brief mockCanPage The MOB selected by CANPAGE (0 if MOBNB is out of range)
+static MockCanMob* mockCanPage()
+{
+    uint8_t mob = CANPAGE >> 4;
+    return (mob < MOCK_CAN_NB_MOBS) ? &mockCanMobs[mob] : 0;
+}
+
+//! \brief mockCanRecord Record a frame sent on the bus
+static void mockCanRecord(const MockCanFrame& frame)
+{
+    if (mockCanNbSent == MOCK_CAN_NB_SENT) {
+        memmove(mockCanSent, mockCanSent + 1, sizeof(mockCanSent) - sizeof(MockCanFrame));
+        mockCanNbSent--;
+    }
+    mockCanSent[mockCanNbSent++] = frame;
+}
+
+//! \brief mockCanSend Send the frame of a transmission MOB, its TXOK is set
+static void mockCanSend(MockCanMob* mob)
+{
+    MockCanFrame frame;
+    frame.id = (mob->idt[0] << 3) | (mob->idt[1] >> 5);
+    frame.rtr = mob->idt[3] & MOCK_CAN_RTRTAG;
+    frame.dlc = mob->cdmob & 0x0F;
+    memcpy(frame.data, mob->msg, sizeof(frame.data));
+    mockCanRecord(frame);
+    mob->stm = CANTIM;
+    mob->stmob |= (1 << TXOK);
+    mob->enabled = false;
+}
+
+uint8_t mockCanRead(uint8_t reg)
+{
+    if (reg == MOCK_CAN_EN2 || reg == MOCK_CAN_SIT2) {
+        uint8_t bits = 0;
+        for (uint8_t i=0; i<MOCK_CAN_NB_MOBS; i++) {
+            bool set = (reg == MOCK_CAN_EN2) ? mockCanMobs[i].enabled
+                                             : (mockCanMobs[i].stmob & MOCK_CAN_STATUS) && (CANIE2 & (1 << i));
+            if (set) bits |= (1 << i);
+        }
+        return bits;
+    }
+    MockCanMob* mob = mockCanPage();
+    if (!mob) return 0;
+    if (reg == MOCK_CAN_STMOB) return mob->stmob;
+    if (reg == MOCK_CAN_CDMOB) return mob->cdmob;
+    if (reg < MOCK_CAN_IDM1) return mob->idt[reg - MOCK_CAN_IDT1];
+    if (reg < MOCK_CAN_MSG) return mob->idm[reg - MOCK_CAN_IDM1];
+    // CANMSG, INDX incremented unless AINC is set
+    uint8_t index = CANPAGE & 0x07;
+    if (!(CANPAGE & (1 << AINC))) CANPAGE = (CANPAGE & 0xF8) | ((index + 1) & 0x07);
+    return mob->msg[index];
+}
+
+void mockCanWrite(uint8_t reg, uint8_t value)
+{
+    MockCanMob* mob = mockCanPage();
+    if (!mob || reg == MOCK_CAN_EN2 || reg == MOCK_CAN_SIT2) return;
+    if (reg == MOCK_CAN_STMOB) {
+        mob->stmob = value;
+    } else if (reg == MOCK_CAN_CDMOB) {
+        mob->cdmob = value;
+        mob->enabled = (value & MOCK_CAN_CONMOB) != 0;
+        if ((value & MOCK_CAN_CONMOB) == MOCK_CAN_CONMOB_TX && !mockCanHoldTx) mockCanSend(mob);
+    } else if (reg < MOCK_CAN_IDM1) {
+        mob->idt[reg - MOCK_CAN_IDT1] = value;
+    } else if (reg < MOCK_CAN_MSG) {
+        mob->idm[reg - MOCK_CAN_IDM1] = value;
+    } else {
+        uint8_t index = CANPAGE & 0x07;
+        if (!(CANPAGE & (1 << AINC))) CANPAGE = (CANPAGE & 0xF8) | ((index + 1) & 0x07);
+        mob->msg[index] = value;
+    }
+}
+
+int8_t mockCanReceive(const MockCanFrame& frame)
+{
+    uint8_t idt1 = frame.id >> 3;
+    uint8_t idt2 = (frame.id & 0x07) << 5;
+    for (uint8_t i=0; i<MOCK_CAN_NB_MOBS; i++) {
+        MockCanMob* mob = &mockCanMobs[i];
+        if (!mob->enabled || (mob->cdmob & MOCK_CAN_CONMOB) != MOCK_CAN_CONMOB_RX) continue;
+        // acceptance filter: identifier bits under the mask, RTR bit if RTRMSK is set
+        if ((idt1 ^ mob->idt[0]) & mob->idm[0]) continue;
+        if ((idt2 ^ mob->idt[1]) & mob->idm[1] & 0xE0) continue;
+        if ((mob->idm[3] & MOCK_CAN_RTRTAG) && (frame.rtr != ((mob->idt[3] & MOCK_CAN_RTRTAG) != 0))) continue;
+
+        if (frame.rtr && (mob->cdmob & (1 << RPLV))) {
+            // automatic reply: the data of the MOB, sent with the identifier received
+            mob->cdmob &= ~(1 << RPLV);
+            mob->idt[0] = idt1;
+            mob->idt[1] = idt2;
+            mob->idt[3] &= ~MOCK_CAN_RTRTAG;
+            mockCanSend(mob);
+            return i;
+        }
+        mob->idt[0] = idt1;
+        mob->idt[1] = idt2;
+        mob->idt[3] = frame.rtr ? MOCK_CAN_RTRTAG : 0;
+        mob->cdmob = (mob->cdmob & 0xF0) | (frame.dlc & 0x0F);
+        memcpy(mob->msg, frame.data, sizeof(mob->msg));
+        mob->stm = CANTIM;
+        mob->stmob |= (1 << RXOK);
+        mob->enabled = false;
+        return i;
+    }
+    return -1;
+}
+
+uint8_t mockCanTransmit()
+{
+    uint8_t nbSent = 0;
+    // the lowest MOB number first (no priority between the MOBs, CANHPMOB = 0)
+    for (uint8_t i=0; i<MOCK_CAN_NB_MOBS; i++) {
+        MockCanMob* mob = &mockCanMobs[i];
+        if (mob->enabled && (mob->cdmob & MOCK_CAN_CONMOB) == MOCK_CAN_CONMOB_TX) {
+            mockCanSend(mob);
+            nbSent++;
+        }
+    }
+    return nbSent;
+}
+
+bool mockCanInterrupt()
+{
+    return (CANGIE & (1 << ENIT)) && mockCanRead(MOCK_CAN_SIT2);
+}
+
+MockCanTimeStamp::operator uint16_t() const
+{
+    MockCanMob* mob = mockCanPage();
+    return mob ? mob->stm : 0;
+}
@@ -0,0 +1,193 @@
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/wdt.h>
+#include "counter.h"
+#include "mock_spi.h"
+#include "mock_firmware.h"
+
+#define MOCK_LS7366R_MDR0   1   //!< Register field of the op-codes (bits 5:3)
+#define MOCK_LS7366R_MDR1   2
+#define MOCK_LS7366R_DTR    3
+#define MOCK_LS7366R_CNTR   4
+#define MOCK_LS7366R_OTR    5
+#define MOCK_LS7366R_STR    6
+
+int firmware_main();
+
+uint8_t mockEeprom[MOCK_EEPROM_SIZE];
+uint8_t mockWdtTimeout = 0xFF;
+int32_t mockCounterValue;
+uint8_t mockCounterStatus;
+
+//! \struct MockFirmwareStop
+//! \brief Thrown by mockSleep to end the firmware thread
+struct MockFirmwareStop {};
+
+static std::thread firmwareThread;
+static std::mutex firmwareLock;
+static std::condition_variable firmwareTurn;
+static bool firmwareRuns;       //!< The firmware has the hand, the host waits
+static bool firmwareStopping;
+static bool firmwareEnded;
+static bool firmwareReset;
+
+static uint8_t counterMdr0;
+static uint8_t counterMdr1;
+static uint32_t counterDtr;
+static uint32_t counterOtr;
+
+//! \brief mockCounterSize Size of a register of the LS7366R model (bytes)
+static uint8_t mockCounterSize(uint8_t reg)
+{
+    if (reg == MOCK_LS7366R_MDR0 || reg == MOCK_LS7366R_MDR1 || reg == MOCK_LS7366R_STR) return 1;
+    return 4 - (counterMdr1 & 0x03);
+}
+
+//! \brief mockCounter The LS7366R model: a byte exchanged on the SPI bus
+static uint8_t mockCounter(uint8_t mosi)
+{
+    static uint8_t opcode;
+    static uint8_t remaining;  // data bytes of the op-code still to exchange
+    static uint32_t value;
+    if (PORTC & (1 << 1)) return 0; // not selected, MISO not driven
+
+    uint8_t reg = (opcode >> 3) & 0x07;
+    if (remaining == 0) {
+        opcode = mosi;
+        reg = (opcode >> 3) & 0x07;
+        switch (opcode >> 6) {
+        case 0: // CLR
+            if (reg == MOCK_LS7366R_MDR0) counterMdr0 = 0;
+            if (reg == MOCK_LS7366R_MDR1) counterMdr1 = 0;
+            if (reg == MOCK_LS7366R_CNTR) mockCounterValue = 0;
+            if (reg == MOCK_LS7366R_STR) mockCounterStatus &= (STR_CEN | STR_UD | STR_S);
+            break;
+        case 1: // RD
+            remaining = mockCounterSize(reg);
+            value = (reg == MOCK_LS7366R_MDR0) ? counterMdr0 : (reg == MOCK_LS7366R_MDR1) ? counterMdr1
+                  : (reg == MOCK_LS7366R_DTR) ? counterDtr : (reg == MOCK_LS7366R_CNTR) ? (uint32_t)mockCounterValue
+                  : (reg == MOCK_LS7366R_OTR) ? counterOtr : mockCounterStatus;
+            break;
+        case 2: // WR
+            remaining = mockCounterSize(reg);
+            value = 0;
+            break;
+        default: // LOAD
+            if (reg == MOCK_LS7366R_CNTR) mockCounterValue = counterDtr;
+            if (reg == MOCK_LS7366R_OTR) counterOtr = mockCounterValue;
+            break;
+        }
+        return 0;
+    }
+
+    remaining--;
+    if ((opcode >> 6) == 1) return value >> (8*remaining);
+    value = (value << 8) | mosi;
+    if (remaining == 0) {
+        if (reg == MOCK_LS7366R_MDR0) counterMdr0 = value;
+        if (reg == MOCK_LS7366R_MDR1) counterMdr1 = value;
+        if (reg == MOCK_LS7366R_DTR) counterDtr = value;
+    }
+    return 0;
+}
+
+void mockSleep()
+{
+    std::unique_lock<std::mutex> lock(firmwareLock);
+    firmwareRuns = false;
+    firmwareTurn.notify_all();
+    firmwareTurn.wait(lock, [] { return firmwareRuns; });
+    if (firmwareStopping) throw MockFirmwareStop();
+}
+
+//! \brief mockFirmwareResume Give the hand to the firmware until it sleeps (or ends)
+static void mockFirmwareResume()
+{
+    std::unique_lock<std::mutex> lock(firmwareLock);
+    if (firmwareEnded) return;
+    firmwareRuns = true;
+    firmwareTurn.notify_all();
+    firmwareTurn.wait(lock, [] { return !firmwareRuns; });
+}
+
+//! \brief mockFirmwareThread The firmware, until it resets itself or it is stopped
+static void mockFirmwareThread()
+{
+    try {
+        firmware_main();
+    } catch (const MockWatchdogReset&) {
+        firmwareReset = true;
+    } catch (const MockFirmwareStop&) {
+    }
+    std::lock_guard<std::mutex> lock(firmwareLock);
+    firmwareEnded = true;
+    firmwareRuns = false;
+    firmwareTurn.notify_all();
+}
+
+bool mockFirmwareStart()
+{
+    // the inputs of the board: PLL locked, LFLAG/ pulled up, erased EEPROM, counter powered up
+    PLLCSR |= (1 << PLOCK);
+    PIND |= (1 << 1);
+    memset(mockEeprom, 0xFF, sizeof(mockEeprom));
+    mockCanReset();
+    mockCounterValue = 0;
+    mockCounterStatus = STR_CEN | STR_PLS;
+    mockSpiDevice = mockCounter;
+
+    {
+        std::lock_guard<std::mutex> lock(firmwareLock);
+        firmwareRuns = true;
+    }
+    firmwareThread = std::thread(mockFirmwareThread);
+    std::unique_lock<std::mutex> lock(firmwareLock);
+    firmwareTurn.wait(lock, [] { return !firmwareRuns; });
+    return !firmwareEnded;
+}
+
+void mockFirmwareRun()
+{
+    for (uint8_t i=0; i<MOCK_FIRMWARE_WAKE_UPS; i++) {
+        // the interruption is called again while a MOB raises it (at most once per MOB)
+        for (uint8_t mob=0; mob<MOCK_CAN_NB_MOBS && mockCanInterrupt(); mob++) CAN_INT_vect();
+        mockFirmwareResume();
+        if (firmwareEnded || !mockCanInterrupt()) return;
+    }
+}
+
+int8_t mockFirmwareReceive(const MockCanFrame& frame)
+{
+    int8_t mob = mockCanReceive(frame);
+    mockFirmwareRun();
+    return mob;
+}
+
+void mockFirmwareTick()
+{
+    CANTIM += MOCK_FIRMWARE_TICK_CAN;
+    TIMER1_COMPA_vect();
+    mockFirmwareRun();
+}
+
+bool mockFirmwareReset()
+{
+    return firmwareReset;
+}
+
+void mockFirmwareStop()
+{
+    if (!firmwareThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(firmwareLock);
+        firmwareStopping = true;
+        firmwareRuns = true;
+        firmwareTurn.notify_all();
+    }
+    firmwareThread.join();
+    mockSpiDevice = 0;
+}
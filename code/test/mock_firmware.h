@@ -0,0 +1,50 @@
+#ifndef MOCK_FIRMWARE_H
+#define MOCK_FIRMWARE_H
+
+//! \file mock_firmware.h
+//! \brief Host run of the firmware (main.cpp) against the mock registers and the CAN controller model
+//! \date 2026 10 18
+//!
+//! main.cpp is compiled with its main renamed firmware_main (see the Makefile). The firmware
+//! runs in its own thread, in turn with the host: the main loop runs until it sleeps
+//! (sleep_cpu), then the host calls the interruptions and wakes the main loop up again.
+//! The interruptions never interrupt the main loop, and the main loop must reach its sleep
+//! (no capture dump with mockCanHoldTx). The global objects of the firmware are constructed
+//! with the program: the firmware is started once per process.
+//! The counter is a model of the LS7366R on the SPI bus (op-codes of counter.h, active while
+//! its chip select SPI_CS_A is low), its LFLAG/ output stays high (no index).
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#define MOCK_FIRMWARE_TICK_CAN  250     //!< CAN timer counts (100us) of a control tick (25.024ms)
+#define MOCK_FIRMWARE_WAKE_UPS  8       //!< Maximum number of wake-ups of the main loop by mockFirmwareRun
+
+extern "C" void TIMER1_COMPA_vect();
+extern "C" void CAN_INT_vect();
+
+extern int32_t mockCounterValue;    //!< The counter value (CNTR) of the LS7366R model
+extern uint8_t mockCounterStatus;   //!< The status register (STR) of the LS7366R model
+
+//! \brief mockFirmwareStart Start the firmware, run until the main loop sleeps
+//! \return false if the firmware ended (reset) during its initialization
+bool mockFirmwareStart();
+
+//! \brief mockFirmwareRun Serve the CAN interruptions raised and wake the main loop up, until it
+//!        sleeps with no interruption raised (frames sent meanwhile raise new ones)
+void mockFirmwareRun();
+
+//! \brief mockFirmwareReceive A frame received from the bus (mockCanReceive), then mockFirmwareRun
+//! \return the MOB of the frame, -1 if no MOB accepts it
+int8_t mockFirmwareReceive(const MockCanFrame& frame);
+
+//! \brief mockFirmwareTick A control tick: the CAN timer moves, the timer interruption, then mockFirmwareRun
+void mockFirmwareTick();
+
+//! \brief mockFirmwareReset The firmware reset itself (wdt_enable(WDTO_15MS)), it no longer runs
+bool mockFirmwareReset();
+
+//! \brief mockFirmwareStop End the firmware thread (before the end of the program)
+void mockFirmwareStop();
+
+#endif // MOCK_FIRMWARE_H
@@ -0,0 +1,41 @@
+#include <avr/io.h>
+#include "spi.h"
+#include "mock_spi.h"
+
+MockSpiByte mockSpiSent[MOCK_SPI_SIZE];
+uint8_t mockSpiNbSent;
+uint8_t mockSpiMiso[MOCK_SPI_SIZE];
+uint8_t mockSpiNbMiso;
+uint8_t (*mockSpiDevice)(uint8_t mosi);
+static uint8_t mockSpiNbReceived;
+
+void mockSpiReset()
+{
+    mockSpiNbSent = 0;
+    mockSpiNbMiso = 0;
+    mockSpiNbReceived = 0;
+}
+
+Spi::Spi() {}
+
+Spi::~Spi() {}
+
+void Spi::spi_init_master(bool redirection, uint8_t) { _spiOut = redirection; }
+
+void Spi::spi_init_slave(bool redirection) { _spiOut = redirection; }
+
+void Spi::spi_begin_transceive() {}
+
+void Spi::spi_stop_transceive() {}
+
+unsigned char Spi::spi_tranceiver(unsigned char data)
+{
+    if (mockSpiNbSent < MOCK_SPI_SIZE) {
+        mockSpiSent[mockSpiNbSent].mosi = data;
+        mockSpiSent[mockSpiNbSent].portB = PORTB;
+        mockSpiSent[mockSpiNbSent].portC = PORTC;
+        mockSpiNbSent++;
+    }
+    if (mockSpiDevice) return mockSpiDevice(data);
+    return (mockSpiNbReceived < mockSpiNbMiso) ? mockSpiMiso[mockSpiNbReceived++] : 0;
+}
@@ -0,0 +1,31 @@
+#ifndef MOCK_SPI_H
+#define MOCK_SPI_H
+
+//! \file mock_spi.h
+//! \brief Host replacement of the SPI interface (see spi.h): the bytes sent are recorded
+//!        with the state of the GPIO ports, the bytes received are given by the test
+//! \date 2026 10 18
+
+#include <stdint.h>
+
+#define MOCK_SPI_SIZE   32  //!< Maximum number of bytes of a test
+
+//! \brief MockSpiByte A byte sent on the bus
+struct MockSpiByte
+{
+    uint8_t mosi;   //!< The byte sent
+    uint8_t portB;  //!< PORTB during the transfer (chip selects)
+    uint8_t portC;  //!< PORTC during the transfer (chip selects)
+};
+
+extern MockSpiByte mockSpiSent[MOCK_SPI_SIZE];  //!< The bytes sent, in order
+extern uint8_t mockSpiNbSent;                   //!< Number of bytes sent
+extern uint8_t mockSpiMiso[MOCK_SPI_SIZE];      //!< The bytes received, in order (0 after the last one)
+extern uint8_t mockSpiNbMiso;                   //!< Number of bytes to receive
+extern uint8_t (*mockSpiDevice)(uint8_t mosi);  //!< Model of the devices on the bus, gives the byte
+                                                //!  received instead of mockSpiMiso when set
+
+//! \brief mockSpiReset Forget the bytes sent, nothing to receive
+void mockSpiReset();
+
+#endif // MOCK_SPI_H
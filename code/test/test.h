@@ -0,0 +1,46 @@
+#ifndef TEST_H
+#define TEST_H
+
+//! \file test.h
+//! \brief Checks of the host unit tests
+//! \date 2026 10 18
+
+#include <stdio.h>
+#include <stdint.h>
+
+extern int testChecks;      //!< Number of checks done
+extern int testFailures;    //!< Number of checks failed
+
+//! \brief CHECK A condition that must be true
+#define CHECK(condition) do { \
+        testChecks++; \
+        if (!(condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+//! \brief CHECK_EQUAL An integer value that must be the expected one
+#define CHECK_EQUAL(expected, actual) do { \
+        long _expected = (long)(expected); \
+        long _actual = (long)(actual); \
+        testChecks++; \
+        if (_expected != _actual) { \
+            printf("%s:%d: CHECK_EQUAL(%s, %s) failed: %ld != %ld\n", \
+                   __FILE__, __LINE__, #expected, #actual, _expected, _actual); \
+            testFailures++; \
+        } \
+    } while (0)
+
+//! \brief mockReset Clear the registers of the mock
+void mockReset();
+
+// The test suites (one per test_*.cpp file)
+void testCounter();
+void testFirmware();
+void testMotorDc();
+void testPid();
+void testSpeedFrame();
+void testSupervisor();
+
+#endif // TEST_H
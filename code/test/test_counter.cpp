@@ -0,0 +1,120 @@
+//! \file test_counter.cpp
+//! \brief Counter (LS7366R) and SpiBus tests: op-code sequences and chip selects
+
+#include <string.h>
+#include "test.h"
+#include "mock_spi.h"
+#include "spi_bus.h"
+#include "counter.h"
+
+#define CS_B    Output<GPIO_PORTB, 4>   //!< Chip select of the second counter (as DUAL_ENCODER in main.cpp)
+
+typedef SpiBus<SPI_CS_A, CS_B> TestBus;
+
+static bool selectedA(uint8_t i) { return !(mockSpiSent[i].portC & (1 << 1)); }
+static bool selectedB(uint8_t i) { return !(mockSpiSent[i].portB & (1 << 4)); }
+static bool deselected() { return (PORTC & (1 << 1)) && (PORTB & (1 << 4)); }
+
+static void setMiso(const uint8_t* data, uint8_t size)
+{
+    memcpy(mockSpiMiso, data, size);
+    mockSpiNbMiso = size;
+}
+
+void testCounter()
+{
+    mockReset();
+    Spi spi;
+    TestBus bus(&spi);
+    Counter<TestBus, 0> counterA(&bus);
+    Counter<TestBus, 1> counterB(&bus);
+    Counter<TestBus, SPI_BUS_ALL> counters(&bus);
+
+    // the chip selects are outputs, high, before the first transaction
+    CHECK(DDRC & (1 << 1));
+    CHECK(DDRB & (1 << 4));
+    CHECK(deselected());
+
+    // command of one counter
+    counterA.clear_counter();
+    CHECK_EQUAL(1, mockSpiNbSent);
+    CHECK_EQUAL(CLR_CNTR, mockSpiSent[0].mosi);
+    CHECK(selectedA(0) && !selectedB(0));
+    CHECK(deselected());
+
+    // write of the other one
+    mockSpiReset();
+    counterB.write_mode_register_0(QUADRX4 | FILTER_2);
+    CHECK_EQUAL(2, mockSpiNbSent);
+    CHECK_EQUAL(WRITE_MDR0, mockSpiSent[0].mosi);
+    CHECK_EQUAL(QUADRX4 | FILTER_2, mockSpiSent[1].mosi);
+    CHECK(!selectedA(0) && selectedB(0) && selectedB(1));
+    CHECK(deselected());
+
+    // snapshot of both counters at once
+    mockSpiReset();
+    counters.load_OTR();
+    CHECK_EQUAL(1, mockSpiNbSent);
+    CHECK_EQUAL(LOAD_OTR, mockSpiSent[0].mosi);
+    CHECK(selectedA(0) && selectedB(0));
+    CHECK(deselected());
+
+    // 32 bits read, MSB first
+    mockSpiReset();
+    const uint8_t value[5] = {0x00, 0x01, 0x02, 0x03, 0x04};
+    setMiso(value, 5);
+    CHECK_EQUAL(0x01020304, counterA.read_counter());
+    CHECK_EQUAL(5, mockSpiNbSent);
+    CHECK_EQUAL(READ_CNTR, mockSpiSent[0].mosi);
+    for (uint8_t i=1; i<5; i++) CHECK_EQUAL(0x00, mockSpiSent[i].mosi);
+    for (uint8_t i=0; i<5; i++) CHECK(selectedA(i) && !selectedB(i));
+    CHECK(deselected());
+
+    // negative values (two's complement)
+    mockSpiReset();
+    const uint8_t negative[5] = {0x00, 0xFF, 0xFF, 0xFF, 0xFE};
+    setMiso(negative, 5);
+    CHECK_EQUAL(-2, counterB.read_OTR());
+    CHECK_EQUAL(READ_OTR, mockSpiSent[0].mosi);
+    CHECK(!selectedA(0) && selectedB(0));
+
+    // 8 bits read
+    mockSpiReset();
+    const uint8_t status[2] = {0x00, STR_CEN | STR_UD};
+    setMiso(status, 2);
+    CHECK_EQUAL(STR_CEN | STR_UD, counterA.read_status_register());
+    CHECK_EQUAL(2, mockSpiNbSent);
+    CHECK_EQUAL(READ_STR, mockSpiSent[0].mosi);
+
+    // mode registers read back (SPI link check)
+    mockSpiReset();
+    const uint8_t mode[2] = {0x00, QUADRX4 | FILTER_2};
+    setMiso(mode, 2);
+    CHECK_EQUAL(QUADRX4 | FILTER_2, counterB.read_mode_register_0());
+    CHECK_EQUAL(READ_MDR0, mockSpiSent[0].mosi);
+    CHECK(!selectedA(0) && selectedB(0));
+    mockSpiReset();
+    counterA.read_mode_register_1();
+    CHECK_EQUAL(READ_MDR1, mockSpiSent[0].mosi);
+    CHECK(deselected());
+
+    // data register, MSB first
+    mockSpiReset();
+    counterA.write_data_register(-2);
+    CHECK_EQUAL(5, mockSpiNbSent);
+    CHECK_EQUAL(WRITE_DTR, mockSpiSent[0].mosi);
+    CHECK_EQUAL(0xFF, mockSpiSent[1].mosi);
+    CHECK_EQUAL(0xFF, mockSpiSent[2].mosi);
+    CHECK_EQUAL(0xFF, mockSpiSent[3].mosi);
+    CHECK_EQUAL(0xFE, mockSpiSent[4].mosi);
+    CHECK(deselected());
+
+    // the transactions above were back to back, one started inside another is counted
+    CHECK_EQUAL(0, TestBus::overlaps());
+    TestBus::select<0>();
+    counterB.clear_counter(); // as from an interruption
+    TestBus::deselect<0>();
+    CHECK_EQUAL(1, TestBus::overlaps());
+    TestBus::clearOverlaps();
+    CHECK_EQUAL(0, TestBus::overlaps());
+}
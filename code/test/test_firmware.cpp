@@ -0,0 +1,147 @@
+//! \file test_firmware.cpp
+//! \brief Firmware tests (main.cpp on the host): CAN identifiers, length checks of the commands, replies
+
+#include <avr/eeprom.h>
+#include "test.h"
+#include "mock_firmware.h"
+
+// CAN identifiers and commands of the board 0 (see main.cpp)
+#define ID_DATASPEED            0x040
+#define ID_CONFIG               0x042
+#define ID_REPLY                0x043
+#define ID_STATUS               0x045
+#define ID_OTHER_BOARD          0x010   //!< Offset of the identifiers of the board 1
+#define CONFIG_SET_PWM_FREQUENCY 0x04
+#define CONFIG_GET_BOOT_TIMES   0x07
+#define CONFIG_ENTER_BOOTLOADER 0x09
+#define CONFIG_GET_CAN_STATS    0x0A
+#define CONFIG_DISTURBANCE_OBSERVER 0x25
+#define EE_BOOT_REQUEST         0x3F8   //!< CAN_BOOT_EE_REQUEST (see can_boot.h)
+#define EE_BOOT_NODE            0x3F9   //!< CAN_BOOT_EE_NODE
+
+//! \brief receive A frame received by the board, the firmware runs until it sleeps
+static int8_t receive(uint16_t id, uint8_t dlc, uint8_t b0 = 0, uint8_t b1 = 0, uint8_t b2 = 0, uint8_t b3 = 0)
+{
+    MockCanFrame frame = {id, false, dlc, {b0, b1, b2, b3, 0, 0, 0, 0}};
+    return mockFirmwareReceive(frame);
+}
+
+//! \brief remote A remote frame received by the board
+static int8_t remote(uint16_t id)
+{
+    MockCanFrame frame = {id, true, 8, {0}};
+    return mockFirmwareReceive(frame);
+}
+
+//! \brief lastSent The last frame sent by the board (0 if none)
+static const MockCanFrame* lastSent()
+{
+    return mockCanNbSent ? &mockCanSent[mockCanNbSent - 1] : 0;
+}
+
+void testFirmware()
+{
+    mockReset();
+    CHECK(mockFirmwareStart());
+    CHECK(!mockFirmwareReset());
+
+    // the frames of the other boards and the frames of the board itself are not received
+    uint8_t nbSent = mockCanNbSent;
+    CHECK_EQUAL(-1, receive(ID_CONFIG + ID_OTHER_BOARD, 2, CONFIG_GET_CAN_STATS));
+    CHECK_EQUAL(-1, receive(ID_DATASPEED + ID_OTHER_BOARD, 3, 0, 0x03, 0xE8));
+    CHECK_EQUAL(-1, receive(ID_REPLY, 8, CONFIG_GET_CAN_STATS));
+    CHECK_EQUAL(nbSent, mockCanNbSent);
+
+    // command of the board: replied on its reply identifier
+    CHECK_EQUAL(2, receive(ID_CONFIG, 2, CONFIG_GET_CAN_STATS, 1));
+    CHECK_EQUAL(nbSent + 1, mockCanNbSent);
+    CHECK_EQUAL(ID_REPLY, lastSent()->id);
+    CHECK_EQUAL(8, lastSent()->dlc);
+    CHECK_EQUAL(CONFIG_GET_CAN_STATS, lastSent()->data[0]);
+
+    // empty frame: no command
+    nbSent = mockCanNbSent;
+    CHECK_EQUAL(2, receive(ID_CONFIG, 0));
+    CHECK_EQUAL(nbSent, mockCanNbSent);
+
+    // length of the commands: no reply and no effect with a wrong length
+    CHECK_EQUAL(2, receive(ID_CONFIG, 3, CONFIG_SET_PWM_FREQUENCY, 0x00, 0x4E));
+    CHECK_EQUAL(2, receive(ID_CONFIG, 5, CONFIG_SET_PWM_FREQUENCY, 0x00, 0x4E, 0x20));
+    CHECK_EQUAL(2, receive(ID_CONFIG, 1, CONFIG_GET_BOOT_TIMES));
+    CHECK_EQUAL(2, receive(ID_CONFIG, 3, CONFIG_GET_BOOT_TIMES, 0));
+    CHECK_EQUAL(nbSent, mockCanNbSent);
+    CHECK_EQUAL(2, receive(ID_CONFIG, 4, CONFIG_SET_PWM_FREQUENCY, 0x00, 0x4E, 0x20));
+    CHECK_EQUAL(nbSent + 1, mockCanNbSent);
+    CHECK_EQUAL(6, lastSent()->dlc);
+    CHECK_EQUAL(CONFIG_SET_PWM_FREQUENCY, lastSent()->data[0]);
+    CHECK_EQUAL(2, receive(ID_CONFIG, 2, CONFIG_GET_BOOT_TIMES, 1));
+    CHECK_EQUAL(nbSent + 2, mockCanNbSent);
+    CHECK_EQUAL(8, lastSent()->dlc);
+    CHECK_EQUAL(CONFIG_GET_BOOT_TIMES, lastSent()->data[0]);
+    CHECK_EQUAL(1, lastSent()->data[1]);
+
+    // the reply gives the state: the observer is only enabled by the flags alone or all the parameters
+    receive(ID_CONFIG, 3, CONFIG_DISTURBANCE_OBSERVER, 0x01, 32);
+    CHECK_EQUAL(4, lastSent()->dlc);
+    CHECK_EQUAL(0, lastSent()->data[1]);
+    receive(ID_CONFIG, 2, CONFIG_DISTURBANCE_OBSERVER, 0x01);
+    CHECK_EQUAL(1, lastSent()->data[1]);
+    receive(ID_CONFIG, 2, CONFIG_DISTURBANCE_OBSERVER, 0x00);
+    CHECK_EQUAL(0, lastSent()->data[1]);
+
+    // speed frames: the wrong lengths are counted as invalid
+    CHECK_EQUAL(1, receive(ID_DATASPEED, 3, 0, 0x03, 0xE8));
+    CHECK_EQUAL(1, receive(ID_DATASPEED, 2, 0, 0x03));
+    CHECK_EQUAL(1, receive(ID_DATASPEED, 4, 0, 0x03, 0xE8));
+    receive(ID_CONFIG, 2, CONFIG_GET_CAN_STATS, 1);
+    CHECK_EQUAL(0, lastSent()->data[1]);
+    CHECK_EQUAL(1, lastSent()->data[2]);
+    CHECK_EQUAL(2, lastSent()->data[3]);
+    receive(ID_CONFIG, 1, CONFIG_GET_CAN_STATS);
+    CHECK_EQUAL(0, lastSent()->data[2]);
+    CHECK_EQUAL(0, lastSent()->data[3]);
+
+    // status: no reply before the first tick, then replied by the controller at each remote frame
+    nbSent = mockCanNbSent;
+    CHECK_EQUAL(-1, remote(ID_STATUS));
+    mockFirmwareTick();
+    CHECK_EQUAL(4, remote(ID_STATUS));
+    CHECK_EQUAL(4, remote(ID_STATUS));
+    CHECK_EQUAL(nbSent + 2, mockCanNbSent);
+    CHECK_EQUAL(ID_STATUS, lastSent()->id);
+    CHECK(!lastSent()->rtr);
+    CHECK_EQUAL(8, lastSent()->dlc);
+
+    // bus busy: the replies wait in the queue, sent in order by the main loop
+    mockCanHoldTx = true;
+    nbSent = mockCanNbSent;
+    receive(ID_CONFIG, 2, CONFIG_GET_BOOT_TIMES, 0);
+    receive(ID_CONFIG, 2, CONFIG_GET_BOOT_TIMES, 3);
+    CHECK_EQUAL(nbSent, mockCanNbSent);
+    CHECK_EQUAL(1, mockCanTransmit());
+    mockFirmwareRun();
+    CHECK_EQUAL(1, mockCanTransmit());
+    mockFirmwareRun();
+    CHECK_EQUAL(0, mockCanTransmit());
+    CHECK_EQUAL(nbSent + 2, mockCanNbSent);
+    CHECK_EQUAL(0, mockCanSent[nbSent].data[1]);
+    CHECK_EQUAL(3, mockCanSent[nbSent + 1].data[1]);
+
+    // bootloader: node and length checked, the reset waits for the pending reply
+    receive(ID_CONFIG, 2, CONFIG_ENTER_BOOTLOADER, 16);
+    receive(ID_CONFIG, 3, CONFIG_ENTER_BOOTLOADER, 3);
+    receive(ID_CONFIG, 1, CONFIG_ENTER_BOOTLOADER);
+    CHECK(!mockFirmwareReset());
+    CHECK_EQUAL(0xFF, mockEeprom[EE_BOOT_REQUEST]);
+    receive(ID_CONFIG, 1, CONFIG_GET_CAN_STATS);
+    receive(ID_CONFIG, 2, CONFIG_ENTER_BOOTLOADER, 3);
+    CHECK(!mockFirmwareReset());
+    CHECK_EQUAL(0xB0, mockEeprom[EE_BOOT_REQUEST]);
+    CHECK_EQUAL(3, mockEeprom[EE_BOOT_NODE]);
+    mockCanTransmit();
+    mockFirmwareRun();
+    CHECK(mockFirmwareReset());
+
+    mockFirmwareStop();
+    mockCanHoldTx = false;
+}
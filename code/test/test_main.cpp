@@ -0,0 +1,37 @@
+//! \file test_main.cpp
+//! \brief Host unit tests of the drivers (make test), against mock registers
+//! \date 2026 10 18
+
+#include <avr/io.h>
+#include "test.h"
+#include "mock_spi.h"
+#include "mock_can.h"
+
+volatile uint8_t mockIo[0x100];
+volatile uint16_t mockIo16[0x100];
+void (*mockPscWrite)(uint8_t address);
+int testChecks;
+int testFailures;
+
+void mockReset()
+{
+    for (uint16_t i=0; i<0x100; i++) {
+        mockIo[i] = 0;
+        mockIo16[i] = 0;
+    }
+    mockSpiReset();
+    mockCanReset();
+}
+
+int main()
+{
+    testCounter();
+    testMotorDc();
+    testPid();
+    testSpeedFrame();
+    testSupervisor();
+    testFirmware();
+
+    printf("%d checks, %d failed\n", testChecks, testFailures);
+    return testFailures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+//! \file test_motor_dc.cpp
+//! \brief Motor_dc tests: direction, clamping and PSC register writes of each drive mode
+
+#include "test.h"
+#include "motor_dc.h"
+
+#define DEAD_TIME   PWM_DEADTIME_DEFAULT_NB_CYCLES
+#define SENTINEL    0xBEEF  //!< Value written in a register to check that it is not written again
+
+//! \brief checkOutputs Check the PSC registers after a speed change
+static void checkOutputs(const char* step, uint8_t config, uint16_t duty0, uint16_t duty1)
+{
+    int failures = testFailures;
+    CHECK_EQUAL(config, POC);
+    CHECK_EQUAL(duty0, POCR0SA);
+    CHECK_EQUAL(duty0 + DEAD_TIME, POCR0SB);
+    CHECK_EQUAL(duty1, POCR1SA);
+    CHECK_EQUAL(duty1 + DEAD_TIME, POCR1SB);
+    // the updates are applied together, when unlocking
+    CHECK(!(PCNF & (1 << PULOCK)));
+    if (testFailures != failures) printf("    in: %s\n", step);
+}
+
+void testMotorDc()
+{
+    mockReset();
+    PLLCSR = (1 << PLOCK); // the PSC starts at once
+    M32m1_pwm pwm;
+    Motor_dc motor(&pwm, 0);
+
+    CHECK(pwm.isRunning());
+    CHECK_EQUAL(PWM_COUNTER_MAX_DEFAULT, pwm.getCounterMax());
+    CHECK_EQUAL(PWM_COUNTER_MAX_DEFAULT + DEAD_TIME - 1, POCR_RB);
+    CHECK_EQUAL(PWM_CONFIG_DISABLE_ALL, POC);
+
+    // not enabled: no output
+    motor.setSpeed(1024);
+    CHECK_EQUAL(PWM_CONFIG_DISABLE_ALL, POC);
+    CHECK_EQUAL(0, POCR0SA);
+
+    // slow decay: half-bridge 0 switched forward, 1 backward, complementary outputs
+    motor.enableMotor();
+    motor.setSpeed(1024);
+    checkOutputs("slow decay, forward", 0b001111, 1024, 0);
+    CHECK_EQUAL(1024, motor.getDutyCycle());
+    motor.setSpeed(-512);
+    checkOutputs("slow decay, backward", 0b001111, 0, 512);
+    motor.setSpeed(0);
+    checkOutputs("slow decay, 0 (brake)", 0b001111, 0, 0);
+
+    // clamping to the full scale, then to the duty limit
+    motor.setSpeed(5000);
+    checkOutputs("clamped forward", 0b001111, PWM_COUNTER_MAX_DEFAULT, 0);
+    CHECK_EQUAL(MOTOR_SPEED_MAX, motor.getDutyCycle());
+    motor.setDutyLimit(1000);
+    motor.setSpeed(-3000);
+    checkOutputs("duty limit", 0b001111, 0, 1000);
+    CHECK_EQUAL(1000, motor.getDutyCycle());
+    motor.setDutyLimit(MOTOR_SPEED_MAX);
+
+    // only the changed registers are written
+    motor.setSpeed(256);
+    POCR1SA = SENTINEL;
+    motor.setSpeed(300);
+    CHECK_EQUAL(300, POCR0SA);
+    CHECK_EQUAL(SENTINEL, POCR1SA);
+    POCR0SA = SENTINEL;
+    motor.setSpeed(300);
+    CHECK_EQUAL(SENTINEL, POCR0SA);
+    POCR1SA = 0;
+
+    // low-duty linearization (64MHz PSC clock: 8 cycles of offset, 64 of minimum pulse)
+    motor.setDutyCompensation(125, 1000);
+    motor.setSpeed(100);
+    checkOutputs("compensated offset", 0b001111, 108, 0);
+    // 14 cycles requested, 56 effective per minimum pulse: one pulse every 4 updates
+    uint16_t total = 0;
+    for (uint8_t i=0; i<8; i++) {
+        motor.setSpeed(14);
+        CHECK(POCR0SA == 0 || POCR0SA == 64);
+        if (POCR0SA) total += POCR0SA - 8;
+    }
+    CHECK_EQUAL(8*14, total);
+    CHECK_EQUAL(64, POCR0SA);
+    motor.setSpeed(0);
+    checkOutputs("compensated 0", 0b001111, 0, 0);
+    motor.setDutyCompensation(0, 0);
+
+    // asynchronous slow decay: high sides only, all open at 0 (coast)
+    motor.setDriveMode(DRIVE_MODE_ASYNC_DECAY);
+    CHECK_EQUAL(DRIVE_MODE_ASYNC_DECAY, motor.getDriveMode());
+    motor.setSpeed(1024);
+    checkOutputs("asynchronous decay, forward", 0b001001, 1024, 0);
+    motor.setSpeed(-1024);
+    checkOutputs("asynchronous decay, backward", 0b000110, 0, 1024);
+    motor.setSpeed(0);
+    checkOutputs("asynchronous decay, 0 (coast)", PWM_CONFIG_DISABLE_ALL, 0, 0);
+
+    // locked anti-phase: 50% at 0, the difference of the duty cycles gives the voltage
+    motor.setDriveMode(DRIVE_MODE_LOCKED_ANTIPHASE);
+    checkOutputs("locked anti-phase, 0", 0b001111, 1024, 1024);
+    motor.setSpeed(1024);
+    checkOutputs("locked anti-phase, forward", 0b001111, 1536, 512);
+    motor.setSpeed(-MOTOR_SPEED_MAX);
+    checkOutputs("locked anti-phase, full backward", 0b001111, 0, 2048);
+
+    // asynchronous fast decay: high side and opposite low side (inverted B outputs), all open at 0 (coast)
+    CHECK(PCNF & (1 << POPB));
+    motor.setSpeed(0);
+    motor.setDriveMode(DRIVE_MODE_FAST_DECAY);
+    CHECK(!(PCNF & (1 << POPB)));
+    checkOutputs("fast decay, 0 (coast)", PWM_CONFIG_DISABLE_ALL, 0, 0);
+    motor.setSpeed(1024);
+    checkOutputs("fast decay, forward", 0b001001, 1024, 1024);
+    motor.setSpeed(-512);
+    checkOutputs("fast decay, backward", 0b000110, 512, 512);
+    // back to a complementary mode: outputs disabled before the polarity is restored
+    pwm.setOutputPolarityB(false);
+    CHECK_EQUAL(PWM_CONFIG_DISABLE_ALL, POC);
+    CHECK(PCNF & (1 << POPB));
+    pwm.setOutputPolarityB(true);
+    motor.setDriveMode(DRIVE_MODE_LOCKED_ANTIPHASE);
+    CHECK(PCNF & (1 << POPB));
+    CHECK_EQUAL(0b001111, POC);
+    motor.setSpeed(0);
+
+    // unknown drive mode: ignored
+    motor.setDriveMode(4);
+    CHECK_EQUAL(DRIVE_MODE_LOCKED_ANTIPHASE, motor.getDriveMode());
+
+    // inverted rotation (wheels of the other side)
+    Motor_dc inverted(&pwm, 1);
+    inverted.enableMotor();
+    inverted.setSpeed(1024);
+    checkOutputs("inverted, forward", 0b001111, 0, 1024);
+
+    // disabled: the outputs stay off whatever the speed
+    motor.disableMotor();
+    CHECK_EQUAL(PWM_CONFIG_DISABLE_ALL, POC);
+    CHECK(!motor.isEnabled());
+    motor.setSpeed(2000);
+    CHECK_EQUAL(PWM_CONFIG_DISABLE_ALL, POC);
+    CHECK_EQUAL(0, POCR0SA);
+
+    // braked: low sides closed (PB1, PB6, PB7), outputs off
+    motor.brakeMotor();
+    CHECK_EQUAL(PWM_CONFIG_DISABLE_ALL, POC);
+    CHECK_EQUAL((1 << PB1) | (1 << PB6) | (1 << PB7), PORTB & ((1 << PB1) | (1 << PB6) | (1 << PB7)));
+}
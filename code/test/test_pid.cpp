@@ -0,0 +1,83 @@
+//! \file test_pid.cpp
+//! \brief Pid tests: reference traces of each term, anti-windup and bumpless start
+
+#include "test.h"
+#include "pid.h"
+
+//! \brief checkTrace Run the PID on a trace and check its outputs
+static void checkTrace(Pid* pid, const char* name, uint8_t size,
+                       const int16_t* targets, const int16_t* states, const int16_t* outputs)
+{
+    for (uint8_t i=0; i<size; i++) {
+        int16_t output = pid->update(targets[i], states[i]);
+        if (output != outputs[i]) {
+            printf("%s, step %d: output %d, expected %d\n", name, i, output, outputs[i]);
+            testFailures++;
+        }
+        testChecks++;
+    }
+}
+
+void testPid()
+{
+    // proportional: Kp * error, bounded error
+    {
+        Pid pid(1.5, 0, 0);
+        const int16_t targets[4] = {100, 100, -50, 2000};
+        const int16_t states[4]  = {0, 60, 0, 0};
+        const int16_t outputs[4] = {150, 60, -75, 1536};
+        checkTrace(&pid, "proportional", 4, targets, states, outputs);
+    }
+
+    // integral with anti-windup: frozen while the output is saturated
+    {
+        Pid pid(1, 0.5, 0);
+        pid.setOutputLimits(-200, 200);
+        const int16_t targets[5] = {100, 100, 100, 100, 100};
+        const int16_t states[5]  = {0, 0, 0, 0, 150};
+        const int16_t outputs[5] = {150, 200, 200, 200, 25};
+        checkTrace(&pid, "integral", 5, targets, states, outputs);
+        CHECK_EQUAL(75, pid.getIntegral());
+    }
+
+    // derivative on the measurement, no kick on the first update, filtered
+    {
+        Pid pid(0, 0, 2);
+        pid.setDerivativeFilter(1);
+        const int16_t targets[4] = {500, 0, 0, 0};
+        const int16_t states[4]  = {0, 10, 10, 10};
+        const int16_t outputs[4] = {0, -10, -5, -2};
+        checkTrace(&pid, "derivative", 4, targets, states, outputs);
+    }
+
+    // setpoint weight 0: no proportional kick on a target step
+    {
+        Pid pid(1, 0, 0);
+        pid.setSetpointWeight(0);
+        const int16_t targets[2] = {100, 100};
+        const int16_t states[2]  = {0, 10};
+        const int16_t outputs[2] = {0, -10};
+        checkTrace(&pid, "setpoint weight", 2, targets, states, outputs);
+    }
+
+    // bumpless start: the integral takes the output not given by the proportional term
+    {
+        Pid pid(1, 0.5, 0);
+        pid.initialize(300, 100, 50);
+        CHECK_EQUAL(50, pid.getProportional());
+        CHECK_EQUAL(250, pid.getIntegral());
+        const int16_t targets[1] = {100};
+        const int16_t states[1]  = {50};
+        const int16_t outputs[1] = {325};
+        checkTrace(&pid, "initialize", 1, targets, states, outputs);
+    }
+
+    // reset: everything back to 0
+    {
+        Pid pid(1, 1, 0);
+        pid.update(100, 0);
+        pid.reset();
+        CHECK_EQUAL(0, pid.getIntegral());
+        CHECK_EQUAL(20, pid.update(10, 0)); // no derivative kick, integral from 0
+    }
+}
@@ -0,0 +1,49 @@
+//! \file test_speed_frame.cpp
+//! \brief decodeSpeedFrame tests: length, zero, maximum speed and direction byte
+
+#include "test.h"
+#include "speed_frame.h"
+
+#define FIRMWARE_MRADS_TO_TICS_Q22  12817   //!< MRADS_TO_TICS_Q22 of main.cpp (1920 tics per turn)
+
+void testSpeedFrame()
+{
+    int16_t target = 1234;
+
+    // wrong lengths, the target is not modified
+    const uint8_t frame[8] = {0x00, 0x03, 0xE8, 0, 0, 0, 0, 0};
+    CHECK(!decodeSpeedFrame(frame, 0, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK(!decodeSpeedFrame(frame, 2, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK(!decodeSpeedFrame(frame, 8, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(1234, target);
+
+    // 1 rad/s: 1920/(2*pi) tics per second, 3.05 per 10ms, truncated
+    CHECK(decodeSpeedFrame(frame, SPEED_FRAME_DLC, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(3, target);
+
+    // zero, in both directions
+    const uint8_t zero[3] = {0x00, 0x00, 0x00};
+    const uint8_t zeroCW[3] = {0x01, 0x00, 0x00};
+    CHECK(decodeSpeedFrame(zero, SPEED_FRAME_DLC, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(0, target);
+    target = 1234;
+    CHECK(decodeSpeedFrame(zeroCW, SPEED_FRAME_DLC, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(0, target);
+
+    // maximum speed (65.535 rad/s), no overflow of the 32 bits product
+    const uint8_t max[3] = {0x00, 0xFF, 0xFF};
+    const uint8_t maxCW[3] = {0x01, 0xFF, 0xFF};
+    CHECK(decodeSpeedFrame(max, SPEED_FRAME_DLC, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(200, target);
+    CHECK(decodeSpeedFrame(maxCW, SPEED_FRAME_DLC, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(-200, target);
+
+    // largest factor: 65535 mrad/s give 65535/64 tics
+    CHECK(decodeSpeedFrame(maxCW, SPEED_FRAME_DLC, 65536UL, &target));
+    CHECK_EQUAL(-1023, target);
+
+    // any non-zero direction byte is clockwise
+    const uint8_t direction[3] = {0x80, 0x03, 0xE8};
+    CHECK(decodeSpeedFrame(direction, SPEED_FRAME_DLC, FIRMWARE_MRADS_TO_TICS_Q22, &target));
+    CHECK_EQUAL(-3, target);
+}
@@ -0,0 +1,55 @@
+//! \file test_supervisor.cpp
+//! \brief Supervisor tests: timeouts across the wrap of the CAN timer, expiry, ramp
+
+#include "test.h"
+#include "supervisor.h"
+
+void testSupervisor()
+{
+    Supervisor supervisor;
+
+    // nothing supervised, nothing received
+    CHECK(!supervisor.tick(0));
+    CHECK_EQUAL(COMM_AGE_EXPIRED, supervisor.getAge(COMM_SPEED));
+
+    // supervised, never received
+    supervisor.setTimeout(COMM_SPEED, 100);
+    CHECK(supervisor.tick(0));
+
+    // received just before the wrap of the CAN timer
+    supervisor.onCommand(COMM_SPEED, 0xFFF0);
+    CHECK(!supervisor.tick(0x0010));
+    CHECK_EQUAL(0x20, supervisor.getAge(COMM_SPEED));
+    CHECK(!supervisor.tick(0x0054));
+    CHECK_EQUAL(100, supervisor.getAge(COMM_SPEED));
+    CHECK(supervisor.tick(0x0055));
+    CHECK(supervisor.isLost());
+
+    // older than COMM_AGE_MAX: expired, even when the timer comes back near the stamp
+    supervisor.onCommand(COMM_SPEED, 0x1000);
+    CHECK(!supervisor.tick(0x1010));
+    CHECK(supervisor.tick((uint16_t)(0x1000 + COMM_AGE_MAX + 1)));
+    CHECK_EQUAL(COMM_AGE_EXPIRED, supervisor.getAge(COMM_SPEED));
+    CHECK(supervisor.tick(0x1005));
+    CHECK_EQUAL(COMM_AGE_EXPIRED, supervisor.getAge(COMM_SPEED));
+
+    // a new command
+    supervisor.onCommand(COMM_SPEED, 0x2000);
+    CHECK(!supervisor.tick(0x2001));
+    CHECK_EQUAL(1, supervisor.getAge(COMM_SPEED));
+
+    // the timeouts are bounded to COMM_AGE_MAX
+    supervisor.setTimeout(COMM_SPEED, COMM_NO_TIMEOUT);
+    supervisor.setTimeout(COMM_CONFIG, 0xFFFF);
+    supervisor.onCommand(COMM_CONFIG, 0x2000);
+    CHECK(!supervisor.tick((uint16_t)(0x2000 + COMM_AGE_MAX)));
+    CHECK(supervisor.tick((uint16_t)(0x2000 + COMM_AGE_MAX + 1)));
+
+    // ramp to 0 under the deceleration limit
+    CHECK_EQUAL(0, supervisor.ramp(100));
+    supervisor.setDeceleration(10);
+    CHECK_EQUAL(15, supervisor.ramp(25));
+    CHECK_EQUAL(-15, supervisor.ramp(-25));
+    CHECK_EQUAL(0, supervisor.ramp(10));
+    CHECK_EQUAL(0, supervisor.ramp(-5));
+}
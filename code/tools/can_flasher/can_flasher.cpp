@@ -0,0 +1,314 @@
+//! \file can_flasher.cpp
+//! \brief Host flasher for the CAN bootloader of the MotorBoards (Linux, SocketCAN)
+//! \date 2026 10 18
+//!
+//! Usage: can_flasher [-i interface] -f image.bin node[:config_id] [node[:config_id] ...]
+//!     - image.bin : the application (make bin)
+//!     - node : the bootloader node identifier (0-15)
+//!     - config_id : the CAN ID of the configuration commands of the board, 0x042 + 0x10*n
+//!       for the firmware built with make BOARD=n (0x042, 0x052...), to reset it in the
+//!       bootloader (CONFIG_ENTER_BOOTLOADER). Without it, the board must already be in
+//!       the bootloader.
+//! All the boards are flashed concurrently, each one with CAN_BOOT_WINDOW pages in flight.
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../../include/can_boot.h"
+
+#define CONFIG_ENTER_BOOTLOADER 0x09    //!< Configuration command of the application (see main.cpp)
+
+#define READY_TIMEOUT_MS    1000        //!< Delay for the bootloader to start
+#define REPLY_TIMEOUT_MS    300         //!< Delay for the replies to START and PAGE
+#define COMMIT_TIMEOUT_MS   5000        //!< Delay for the installation of the image
+#define MAX_RETRIES         5           //!< Number of times a command is sent again
+
+typedef std::chrono::steady_clock Clock;
+
+//! \brief States of the flashing of a node
+enum State { WAIT_READY, START, PAGES, COMMIT, DONE, FAILED };
+
+//! \struct Node
+//! \brief A board being flashed
+struct Node
+{
+    int                 id;         //!< Bootloader node identifier
+    int                 configId;   //!< CAN ID of the configuration commands (-1: already in the bootloader)
+    State               state;      //!< Current state
+    unsigned            nextPage;   //!< Next page to send
+    std::deque<unsigned> inFlight;  //!< Pages sent, not acknowledged yet
+    Clock::time_point   deadline;   //!< Timeout of the current request
+    int                 retries;    //!< Number of retries of the current request
+};
+
+static int canSocket = -1;
+static std::vector<uint8_t> image;
+
+//! \brief Send a frame (retried while the socket buffer is full)
+static void sendFrame(uint32_t id, const uint8_t* data, uint8_t dlc)
+{
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id;
+    frame.can_dlc = dlc;
+    memcpy(frame.data, data, dlc);
+    while (write(canSocket, &frame, sizeof(frame)) != sizeof(frame)) {
+        if (errno != ENOBUFS && errno != EAGAIN) { perror("write"); exit(1); }
+        usleep(200);
+    }
+}
+
+static void sendCommand(const Node& node, const uint8_t* data, uint8_t dlc)
+{
+    sendFrame(CAN_BOOT_ID(node.id, CAN_BOOT_TYPE_COMMAND), data, dlc);
+}
+
+static unsigned nbPages()
+{
+    return (image.size() + CAN_BOOT_PAGE_SIZE - 1) / CAN_BOOT_PAGE_SIZE;
+}
+
+static uint16_t crc(const uint8_t* data, size_t size)
+{
+    uint16_t value = 0xFFFF;
+    for (size_t i = 0; i < size; i++) value = canBootCrc(value, data[i]);
+    return value;
+}
+
+static void setTimeout(Node& node, int ms)
+{
+    node.deadline = Clock::now() + std::chrono::milliseconds(ms);
+}
+
+//! \brief Send a page header and its data frames (padded with 0xFF)
+static void sendPage(Node& node, unsigned page)
+{
+    uint8_t content[CAN_BOOT_PAGE_SIZE];
+    memset(content, 0xFF, sizeof(content));
+    size_t offset = page * CAN_BOOT_PAGE_SIZE;
+    size_t size = std::min<size_t>(CAN_BOOT_PAGE_SIZE, image.size() - offset);
+    memcpy(content, &image[offset], size);
+
+    uint16_t value = crc(content, sizeof(content));
+    uint8_t header[4] = {CAN_BOOT_CMD_PAGE, (uint8_t)page, (uint8_t)(value >> 8), (uint8_t)value};
+    sendCommand(node, header, 4);
+    uint8_t parity = (page & 1) ? CAN_BOOT_TYPE_PARITY : 0;
+    for (unsigned i = 0; i < CAN_BOOT_FRAMES_PER_PAGE; i++) {
+        sendFrame(CAN_BOOT_ID(node.id, CAN_BOOT_TYPE_DATA | parity | i), content + 8 * i, 8);
+    }
+}
+
+//! \brief Send the request of the current state
+static void request(Node& node)
+{
+    switch (node.state) {
+    case WAIT_READY: {
+        uint8_t data[2] = {CONFIG_ENTER_BOOTLOADER, (uint8_t)node.id};
+        sendFrame(node.configId, data, 2);
+        setTimeout(node, READY_TIMEOUT_MS);
+        break;
+    }
+    case START: {
+        uint16_t size = image.size();
+        uint16_t value = crc(image.data(), image.size());
+        uint8_t data[5] = {CAN_BOOT_CMD_START, (uint8_t)(size >> 8), (uint8_t)size, (uint8_t)(value >> 8), (uint8_t)value};
+        sendCommand(node, data, 5);
+        setTimeout(node, REPLY_TIMEOUT_MS);
+        break;
+    }
+    case PAGES:
+        // all the pages in flight are sent again
+        for (unsigned page : node.inFlight) sendPage(node, page);
+        while (node.inFlight.size() < CAN_BOOT_WINDOW && node.nextPage < nbPages()) {
+            node.inFlight.push_back(node.nextPage);
+            sendPage(node, node.nextPage++);
+        }
+        setTimeout(node, REPLY_TIMEOUT_MS);
+        break;
+    case COMMIT: {
+        uint8_t data[1] = {CAN_BOOT_CMD_COMMIT};
+        sendCommand(node, data, 1);
+        setTimeout(node, COMMIT_TIMEOUT_MS);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void enter(Node& node, State state)
+{
+    node.state = state;
+    node.retries = 0;
+    if (state == PAGES && nbPages() == 0) node.state = COMMIT;
+    request(node);
+}
+
+static void fail(Node& node, const char* reason)
+{
+    fprintf(stderr, "node %d: %s\n", node.id, reason);
+    node.state = FAILED;
+}
+
+//! \brief Process a reply of a node
+static void onReply(Node& node, const struct can_frame& frame)
+{
+    if (frame.can_dlc < 1) return;
+    uint8_t command = frame.data[0];
+    uint8_t status = (frame.can_dlc > 1) ? frame.data[1] : CAN_BOOT_OK;
+
+    if (command == CAN_BOOT_CMD_READY) {
+        // (re)started: the transfer starts again
+        printf("node %d: bootloader version %d\n", node.id, status);
+        node.inFlight.clear();
+        node.nextPage = 0;
+        if (node.state != DONE && node.state != FAILED) enter(node, START);
+        return;
+    }
+
+    switch (node.state) {
+    case START:
+        if (command != CAN_BOOT_CMD_START) break;
+        if (status != CAN_BOOT_OK) { fail(node, "image refused (size)"); break; }
+        enter(node, PAGES);
+        break;
+
+    case PAGES: {
+        if (command != CAN_BOOT_CMD_PAGE || frame.can_dlc < 3) break;
+        unsigned page = frame.data[2];
+        if (status != CAN_BOOT_OK) {
+            if (++node.retries > MAX_RETRIES) { fail(node, "page not written"); break; }
+            sendPage(node, page);
+            setTimeout(node, REPLY_TIMEOUT_MS);
+            break;
+        }
+        for (auto it = node.inFlight.begin(); it != node.inFlight.end(); ++it) {
+            if (*it == page) { node.inFlight.erase(it); break; }
+        }
+        node.retries = 0;
+        if (node.inFlight.empty() && node.nextPage >= nbPages()) {
+            printf("node %d: %u pages sent\n", node.id, nbPages());
+            enter(node, COMMIT);
+        } else if (node.nextPage < nbPages()) {
+            // the window moves forward
+            node.inFlight.push_back(node.nextPage);
+            sendPage(node, node.nextPage++);
+            setTimeout(node, REPLY_TIMEOUT_MS);
+        }
+        break;
+    }
+
+    case COMMIT:
+        if (command != CAN_BOOT_CMD_COMMIT) break;
+        if (status != CAN_BOOT_OK) { fail(node, "image CRC error, the old application is kept"); break; }
+        printf("node %d: done\n", node.id);
+        node.state = DONE;
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-i interface] -f image.bin node[:config_id] [node[:config_id] ...]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* interface = "can0";
+    const char* file = 0;
+    int option;
+    while ((option = getopt(argc, argv, "i:f:")) != -1) {
+        switch (option) {
+        case 'i': interface = optarg; break;
+        case 'f': file = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (!file || optind >= argc) usage(argv[0]);
+
+    std::ifstream input(file, std::ios::binary);
+    if (!input) { perror(file); return 1; }
+    image.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    if (image.empty() || image.size() > CAN_BOOT_STAGING_SIZE) {
+        fprintf(stderr, "%s: %zu bytes, the image must be 1 to %d bytes\n", file, image.size(), CAN_BOOT_STAGING_SIZE);
+        return 1;
+    }
+
+    std::vector<Node> nodes;
+    for (int i = optind; i < argc; i++) {
+        Node node = Node();
+        char* end;
+        node.id = strtol(argv[i], &end, 0);
+        node.configId = (*end == ':') ? (int)strtol(end + 1, 0, 0) : -1;
+        if (node.id < 0 || node.id >= CAN_BOOT_MAX_NODES) usage(argv[0]);
+        nodes.push_back(node);
+    }
+
+    // CAN socket, only the replies of the bootloaders are received
+    canSocket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (canSocket < 0) { perror("socket"); return 1; }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface, IFNAMSIZ - 1);
+    if (ioctl(canSocket, SIOCGIFINDEX, &ifr) < 0) { perror(interface); return 1; }
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(canSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return 1; }
+    struct can_filter filter = {CAN_BOOT_ID(0, CAN_BOOT_TYPE_REPLY), CAN_SFF_MASK & ~(CAN_BOOT_ID_MASK & ~CAN_BOOT_ID_BASE)};
+    setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+    printf("%s: %zu bytes, %u pages, CRC 0x%04X\n", file, image.size(), nbPages(), crc(image.data(), image.size()));
+    for (Node& node : nodes) enter(node, (node.configId >= 0) ? WAIT_READY : START);
+
+    Clock::time_point start = Clock::now();
+    for (;;) {
+        bool running = false;
+        for (Node& node : nodes) running |= (node.state != DONE && node.state != FAILED);
+        if (!running) break;
+
+        struct pollfd fd = {canSocket, POLLIN, 0};
+        if (poll(&fd, 1, 10) > 0) {
+            struct can_frame frame;
+            if (read(canSocket, &frame, sizeof(frame)) == sizeof(frame)) {
+                for (Node& node : nodes) {
+                    if ((frame.can_id & CAN_SFF_MASK) == (canid_t)CAN_BOOT_ID(node.id, CAN_BOOT_TYPE_REPLY)) onReply(node, frame);
+                }
+            }
+        }
+
+        Clock::time_point now = Clock::now();
+        for (Node& node : nodes) {
+            if (node.state == DONE || node.state == FAILED || now < node.deadline) continue;
+            if (++node.retries > MAX_RETRIES) { fail(node, "no reply"); continue; }
+            request(node);
+        }
+    }
+
+    int failed = 0;
+    for (Node& node : nodes) failed += (node.state == FAILED);
+    printf("%zu board(s) in %.1fs, %d failed\n", nodes.size(),
+           std::chrono::duration<double>(Clock::now() - start).count(), failed);
+    return failed ? 1 : 0;
+}
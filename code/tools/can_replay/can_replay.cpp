@@ -0,0 +1,245 @@
+//! \file can_replay.cpp
+//! \brief Host replay of speed frames to a MotorBoard, with the loss and latency statistics (Linux, SocketCAN)
+//! \date 2026 10 18
+//!
+//! Usage: can_replay [-i interface] [-b board] [-n frames] [-p period_ms] [-s max_speed] [-f candump.log]
+//!     - board : the number of the board (make BOARD=n), its speed frames are sent to 0x040 + 0x10*n
+//!       and its configuration commands to 0x042 + 0x10*n
+//!     - without -f, n frames (1000) are sent every period_ms (10ms), the speed sweeps from
+//!       -max_speed to +max_speed (mrad/s, 10000) and back
+//!     - with -f, the speed frames of the board in a candump log ("(time) interface id#data",
+//!       candump -L) are sent again with their original timing
+//! The statistics of the board are reset before the replay and read after it (CONFIG_GET_CAN_STATS),
+//! every STATS_CHUNK frames for the long replays (the frame counter of the board is 16 bits).
+//! The interface can be a vcan interface bridged to the bus (cangw), or the vcan interface of the
+//! host run of the firmware (tools/firmware_sim, make sim).
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ID_MOTORBOARD_BASE(n)   (0x040 + 0x010*(n)) //!< First CAN ID of a board (see main.cpp)
+#define ID_DATASPEED(n)         (ID_MOTORBOARD_BASE(n) + 0) //!< The CAN ID of the speed commands
+#define ID_CONFIG(n)            (ID_MOTORBOARD_BASE(n) + 2) //!< The CAN ID of the configuration commands
+#define ID_REPLY(n)             (ID_MOTORBOARD_BASE(n) + 3) //!< The CAN ID of the replies
+#define CONFIG_GET_CAN_STATS    0x0A        //!< Configuration command of the application (see main.cpp)
+#define CAN_TIMER_US            100         //!< CAN timer period of the board (us), unit of the latency
+
+#define REPLY_TIMEOUT_MS        300         //!< Delay for the replies to CONFIG_GET_CAN_STATS
+#define DRAIN_MS                100         //!< Delay for the last frames to be received before reading the statistics
+#define STATS_CHUNK             10000       //!< Number of frames between two readings of the statistics
+
+typedef std::chrono::steady_clock Clock;
+
+//! \struct SpeedFrame
+//! \brief A speed frame to send
+struct SpeedFrame
+{
+    double  time;       //!< Time of the frame from the start of the replay (s)
+    uint8_t data[3];    //!< | rotationCW | speed(MSB) | speed(LSB) (mrad/s)
+};
+
+//! \struct Stats
+//! \brief Statistics of the board (CONFIG_GET_CAN_STATS), accumulated over the replay
+struct Stats
+{
+    unsigned long frames;   //!< Speed frames received
+    unsigned long invalid;  //!< Speed frames with a wrong length
+    unsigned latencyMax;    //!< Longest delay from the reception to the PWM update (CAN timer counts)
+    uint8_t rec;            //!< Receive error counter of the last reading
+    uint8_t tec;            //!< Transmit error counter of the last reading
+    double roundTripMax;    //!< Longest delay from a command to its reply (s)
+};
+
+static int canSocket = -1;
+static int board = 0;
+
+//! \brief Send a frame (retried while the socket buffer is full)
+static void sendFrame(uint32_t id, const uint8_t* data, uint8_t dlc)
+{
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id;
+    frame.can_dlc = dlc;
+    memcpy(frame.data, data, dlc);
+    while (write(canSocket, &frame, sizeof(frame)) != sizeof(frame)) {
+        if (errno != ENOBUFS && errno != EAGAIN) { perror("write"); exit(1); }
+        usleep(200);
+    }
+}
+
+//! \brief Read the statistics of the board and reset them, accumulated in stats
+//! \return false if the board did not reply
+static bool readStats(Stats& stats)
+{
+    const uint8_t command[2] = {CONFIG_GET_CAN_STATS, 1};
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::milliseconds(REPLY_TIMEOUT_MS);
+    sendFrame(ID_CONFIG(board), command, 2);
+    while (Clock::now() < deadline) {
+        struct pollfd fd = {canSocket, POLLIN, 0};
+        if (poll(&fd, 1, 10) <= 0) continue;
+        struct can_frame frame;
+        if (read(canSocket, &frame, sizeof(frame)) != sizeof(frame)) continue;
+        if ((frame.can_id & CAN_SFF_MASK) != (canid_t)ID_REPLY(board)) continue;
+        if (frame.can_dlc != 8 || frame.data[0] != CONFIG_GET_CAN_STATS) continue;
+
+        double roundTrip = std::chrono::duration<double>(Clock::now() - start).count();
+        if (roundTrip > stats.roundTripMax) stats.roundTripMax = roundTrip;
+        stats.frames += (frame.data[1] << 8) | frame.data[2];
+        stats.invalid += frame.data[3];
+        unsigned latency = (frame.data[4] << 8) | frame.data[5];
+        if (latency > stats.latencyMax) stats.latencyMax = latency;
+        stats.rec = frame.data[6];
+        stats.tec = frame.data[7];
+        return true;
+    }
+    return false;
+}
+
+//! \brief Speed frame of a speed (mrad/s)
+static SpeedFrame speedFrame(double time, long speed)
+{
+    SpeedFrame frame;
+    unsigned mrads = (speed < 0) ? -speed : speed;
+    if (mrads > 0xFFFF) mrads = 0xFFFF;
+    frame.time = time;
+    frame.data[0] = (speed < 0);
+    frame.data[1] = mrads >> 8;
+    frame.data[2] = mrads & 0xFF;
+    return frame;
+}
+
+//! \brief Speed frames of the board in a candump log (candump -L)
+static bool readLog(const char* file, std::vector<SpeedFrame>& frames)
+{
+    std::ifstream input(file);
+    if (!input) { perror(file); return false; }
+    std::string line;
+    double first = -1;
+    while (std::getline(input, line)) {
+        double time;
+        unsigned id;
+        char data[32];
+        if (sscanf(line.c_str(), "(%lf) %*s %x#%31s", &time, &id, data) != 3) continue;
+        if (id != (unsigned)ID_DATASPEED(board) || strlen(data) != 6) continue;
+        if (first < 0) first = time;
+        SpeedFrame frame;
+        frame.time = time - first;
+        for (int i = 0; i < 3; i++) frame.data[i] = strtoul(std::string(data + 2*i, 2).c_str(), 0, 16);
+        frames.push_back(frame);
+    }
+    return true;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-i interface] [-b board] [-n frames] [-p period_ms] [-s max_speed] [-f candump.log]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* interface = "can0";
+    const char* file = 0;
+    long nbFrames = 1000;
+    double period = 10;
+    long maxSpeed = 10000;
+    int option;
+    while ((option = getopt(argc, argv, "i:b:n:p:s:f:")) != -1) {
+        switch (option) {
+        case 'i': interface = optarg; break;
+        case 'b': board = strtol(optarg, 0, 0); break;
+        case 'n': nbFrames = strtol(optarg, 0, 0); break;
+        case 'p': period = strtod(optarg, 0); break;
+        case 's': maxSpeed = strtol(optarg, 0, 0); break;
+        case 'f': file = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || board < 0 || ID_MOTORBOARD_BASE(board) + 5 > (int)CAN_SFF_MASK ||
+        nbFrames <= 0 || period <= 0 || maxSpeed < 0 || maxSpeed > 0xFFFF) {
+        usage(argv[0]);
+    }
+
+    // the frames to send
+    std::vector<SpeedFrame> frames;
+    if (file) {
+        if (!readLog(file, frames)) return 1;
+        if (frames.empty()) { fprintf(stderr, "%s: no speed frame for 0x%03X\n", file, ID_DATASPEED(board)); return 1; }
+    } else {
+        for (long i = 0; i < nbFrames; i++) {
+            // triangle from -maxSpeed to +maxSpeed and back, 200 frames per sweep
+            long phase = i % 400;
+            long step = (phase < 200) ? phase : 400 - phase;
+            frames.push_back(speedFrame(i*period/1000, -maxSpeed + (2*maxSpeed*step)/200));
+        }
+    }
+
+    // CAN socket, only the replies of the board are received
+    canSocket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (canSocket < 0) { perror("socket"); return 1; }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface, IFNAMSIZ - 1);
+    if (ioctl(canSocket, SIOCGIFINDEX, &ifr) < 0) { perror(interface); return 1; }
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(canSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return 1; }
+    struct can_filter filter = {(canid_t)ID_REPLY(board), CAN_SFF_MASK};
+    setsockopt(canSocket, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter));
+
+    // statistics reset (the counts of the previous traffic are dropped)
+    Stats stats = Stats();
+    if (!readStats(stats)) { fprintf(stderr, "board %d (0x%03X): no reply\n", board, ID_CONFIG(board)); return 1; }
+    stats = Stats();
+
+    printf("board %d: %zu speed frames to 0x%03X over %.1fs\n", board, frames.size(), ID_DATASPEED(board),
+           frames.back().time);
+    Clock::time_point start = Clock::now();
+    double lateMax = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+                                                  std::chrono::duration<double>(frames[i].time)));
+        double late = std::chrono::duration<double>(Clock::now() - start).count() - frames[i].time;
+        if (late > lateMax) lateMax = late;
+        sendFrame(ID_DATASPEED(board), frames[i].data, 3);
+
+        if ((i + 1) % STATS_CHUNK == 0 && i + 1 < frames.size()) {
+            // the speed frames have a higher priority than the command, they are all counted
+            if (!readStats(stats)) { fprintf(stderr, "board %d: no reply during the replay\n", board); return 1; }
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_MS));
+    if (!readStats(stats)) { fprintf(stderr, "board %d: no reply after the replay\n", board); return 1; }
+
+    long sent = frames.size();
+    long lost = sent - (long)(stats.frames + stats.invalid);
+    printf("sent      %ld (sending up to %.2fms late)\n", sent, lateMax*1e3);
+    printf("received  %lu valid, %lu invalid\n", stats.frames, stats.invalid);
+    if (lost >= 0) {
+        printf("lost      %ld (%.2f%%)\n", lost, 100.0*lost/sent);
+    } else {
+        printf("lost      unknown, %ld frames more than sent (another node sends speed frames)\n", -lost);
+    }
+    printf("latency   %.1fms max (reception to PWM update)\n", stats.latencyMax*CAN_TIMER_US/1000.0);
+    printf("reply     %.1fms max (CONFIG_GET_CAN_STATS round trip)\n", stats.roundTripMax*1e3);
+    printf("errors    REC %u, TEC %u\n", stats.rec, stats.tec);
+    return (lost != 0) ? 1 : 0;
+}
@@ -0,0 +1,382 @@
+//! \file cycles.cpp
+//! \brief Cycle counts of the firmware ELF under simavr: boot time, calls of the probed functions and interruptions
+//! \date 2026 10 18
+//!
+//! Usage: cycles [-m mcu] [-f frequency] [-n ticks] -s symbols.txt -p probes.txt firmware.elf
+//!     - symbols.txt : avr-nm -C --defined-only of the ELF ("address type name")
+//!     - probes.txt : "label symbol" per line, the symbol as in symbols.txt (see probes.txt and the Makefile)
+//!     - the firmware runs until n timer interruptions (200) have returned
+//! The results are printed as "name value" lines, exact integer cycle counts:
+//!     - boot: from the reset to the first idle sleep of the main loop, boot_<stage>: the boot stages
+//!       of main.cpp (bootTimes, timer 1 counts of 8 cycles since the timer start)
+//!     - <label>.calls, .min, .max, .total: the cycles from the first instruction of the function to
+//!       the instruction after its return, the interruptions nested in the call included
+//! A call starts when the PC reaches the address of the symbol, it ends when the stack pointer goes
+//! above its value at the start (ret, reti).
+//! The board around the MCU is modeled as much as the firmware needs to run its control loop:
+//!     - the PLL locks as soon as it is enabled (PLOCK set with PLLE)
+//!     - an LS7366R on the SPI bus (chip select PC1), its counter advances by COUNTS_PER_TICK at each
+//!       timer interruption
+//!     - a speed frame every CAN_PERIOD_US, a CONFIG_GET_CAN_STATS command every CONFIG_PERIOD_US: the
+//!       CAN controller is not modeled (simavr has none), its registers are plain memory. The frame is
+//!       written in CANSIT2, CANCDMOB and CANMSG (every data byte the same) before CAN_INT_vect is raised.
+//! The timer, SPI and EEPROM are the simavr models of the core (-m, atmega32m1 by default; atmega64m1
+//! has the same instruction timings, for a simavr build without the atmega32m1 core).
+
+#include <sim_avr.h>
+#include <sim_elf.h>
+#include <sim_interrupts.h>
+#include <sim_cycle_timers.h>
+#include <sim_io.h>
+#include <sim_irq.h>
+#include <avr_spi.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Registers of the ATmega32M1 (data space addresses)
+#define REG_PORTC           0x28        //!< PORTC, chip select of the counter on PC1 (active low)
+#define REG_PLLCSR          0x49        //!< PLLCSR: PLLE bit 1, PLOCK bit 0
+#define REG_SPL             0x5D        //!< Stack pointer, low byte
+#define REG_SPH             0x5E        //!< Stack pointer, high byte
+#define REG_CANGIE          0xDB        //!< CANGIE: ENIT bit 7
+#define REG_CANSIT2         0xE0        //!< CANSIT2: interruption of each MOB
+#define REG_CANCDMOB        0xEF        //!< CANCDMOB: reception enabled (0x80) | dlc
+#define REG_CANMSG          0xFA        //!< CANMSG: data byte
+#define SPI_CS_BIT          1
+#define PLLE_BIT            1
+#define PLOCK_BIT           0
+#define ENIT_BIT            7
+#define DATA_OFFSET         0x800000    //!< Offset of the data space in the ELF addresses
+
+// The MOBs and commands of main.cpp
+#define CAN_MOB_SPEED       1
+#define CAN_MOB_CONFIG      2
+#define CONFIG_GET_CAN_STATS 0x0A
+#define BOOT_NB_STAGES      6
+
+#define COUNTS_PER_TICK     40          //!< Counter increment of the LS7366R model at each timer interruption
+#define CAN_PERIOD_US       10000       //!< Period of the speed frames (us)
+#define CONFIG_PERIOD_US    100000      //!< Period of the CONFIG_GET_CAN_STATS commands (us)
+#define CONFIG_PHASE_US     5000        //!< Delay of the commands after the speed frames (us)
+#define TICK_MAX_US         50000       //!< Maximum delay between two timer interruptions (twice the period)
+
+// LS7366R registers (op-code bits 5:3)
+#define LS7366R_MDR0        1
+#define LS7366R_MDR1        2
+#define LS7366R_DTR         3
+#define LS7366R_CNTR        4
+#define LS7366R_OTR         5
+#define LS7366R_STR         6
+#define LS7366R_STR_INIT    0x03        //!< STR at power up: CEN | PLS
+
+//! \struct Probe
+//! \brief Cycle counts of a probed symbol
+struct Probe
+{
+    std::string label;
+    std::string symbol;
+    uint32_t address;       //!< Byte address in the flash (0: not in the ELF)
+    unsigned long calls;
+    unsigned long min;
+    unsigned long max;
+    unsigned long long total;
+};
+
+//! \struct Call
+//! \brief A probed call not returned yet
+struct Call
+{
+    size_t probe;
+    uint16_t sp;            //!< Stack pointer at the first instruction
+    avr_cycle_count_t start;
+};
+
+static std::vector<Probe> probes;
+static size_t timerProbe;
+static size_t canProbe;
+static avr_int_vector_t canVector;
+static unsigned long nbFrames;
+static avr_irq_t* spiInput;
+
+//! \struct Ls7366r
+//! \brief LS7366R model: a byte exchanged on the SPI bus when the chip is selected
+static struct Ls7366r
+{
+    uint8_t mdr0;
+    uint8_t mdr1;
+    uint8_t str;
+    uint32_t dtr;
+    uint32_t cntr;
+    uint32_t otr;
+    uint8_t opcode;
+    uint8_t remaining;      //!< Data bytes of the op-code still to exchange
+    uint32_t value;
+
+    uint8_t size(uint8_t reg) const
+    {
+        if (reg == LS7366R_MDR0 || reg == LS7366R_MDR1 || reg == LS7366R_STR) return 1;
+        return 4 - (mdr1 & 0x03);
+    }
+
+    uint8_t exchange(uint8_t mosi)
+    {
+        uint8_t reg = (opcode >> 3) & 0x07;
+        if (remaining == 0) {
+            opcode = mosi;
+            reg = (opcode >> 3) & 0x07;
+            switch (opcode >> 6) {
+            case 0: // CLR
+                if (reg == LS7366R_MDR0) mdr0 = 0;
+                if (reg == LS7366R_MDR1) mdr1 = 0;
+                if (reg == LS7366R_CNTR) cntr = 0;
+                if (reg == LS7366R_STR) str &= LS7366R_STR_INIT;
+                break;
+            case 1: // RD
+                remaining = size(reg);
+                value = (reg == LS7366R_MDR0) ? mdr0 : (reg == LS7366R_MDR1) ? mdr1 : (reg == LS7366R_DTR) ? dtr
+                      : (reg == LS7366R_CNTR) ? cntr : (reg == LS7366R_OTR) ? otr : str;
+                break;
+            case 2: // WR
+                remaining = size(reg);
+                value = 0;
+                break;
+            default: // LOAD
+                if (reg == LS7366R_CNTR) cntr = dtr;
+                if (reg == LS7366R_OTR) otr = cntr;
+                break;
+            }
+            return 0;
+        }
+
+        remaining--;
+        if ((opcode >> 6) == 1) return value >> (8*remaining);
+        value = (value << 8) | mosi;
+        if (remaining == 0) {
+            if (reg == LS7366R_MDR0) mdr0 = value;
+            if (reg == LS7366R_MDR1) mdr1 = value;
+            if (reg == LS7366R_DTR) dtr = value;
+        }
+        return 0;
+    }
+} counter;
+
+//! \brief A byte sent by the SPI master: the reply of the counter if it is selected
+static void spiOutput(struct avr_irq_t* irq, uint32_t value, void* param)
+{
+    (void)irq;
+    avr_t* avr = (avr_t*)param;
+    uint8_t miso = (avr->data[REG_PORTC] & (1 << SPI_CS_BIT)) ? 0 : counter.exchange(value);
+    avr_raise_irq(spiInput, miso);
+}
+
+//! \brief A frame received by a MOB: the registers of the MOB, then the CAN interruption
+static void canFrame(avr_t* avr, uint8_t mob, uint8_t dlc, uint8_t data)
+{
+    avr->data[REG_CANSIT2] = (1 << mob);
+    avr->data[REG_CANCDMOB] = 0x80 | dlc;
+    avr->data[REG_CANMSG] = data;
+    avr_raise_interrupt(avr, &canVector);
+    nbFrames++;
+}
+
+//! \brief The speed frames, two speeds one after the other
+static avr_cycle_count_t speedFrame(avr_t* avr, avr_cycle_count_t when, void* param)
+{
+    (void)param;
+    canFrame(avr, CAN_MOB_SPEED, 3, (nbFrames & 1) ? 0x01 : 0x02);
+    return when + avr_usec_to_cycles(avr, CAN_PERIOD_US);
+}
+
+//! \brief The configuration commands: statistics read and reset
+static avr_cycle_count_t configFrame(avr_t* avr, avr_cycle_count_t when, void* param)
+{
+    (void)param;
+    canFrame(avr, CAN_MOB_CONFIG, 2, CONFIG_GET_CAN_STATS);
+    return when + avr_usec_to_cycles(avr, CONFIG_PERIOD_US);
+}
+
+//! \brief Symbols of the ELF (avr-nm -C --defined-only): name -> address
+static bool readSymbols(const char* file, std::map<std::string, uint32_t>& symbols)
+{
+    std::ifstream input(file);
+    if (!input) { perror(file); return false; }
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string address, type, name;
+        if (!(fields >> address >> type)) continue;
+        std::getline(fields >> std::ws, name);
+        if (!name.empty()) symbols[name] = strtoul(address.c_str(), 0, 16);
+    }
+    return true;
+}
+
+//! \brief The probes ("label symbol" per line, # comments)
+static bool readProbes(const char* file, const std::map<std::string, uint32_t>& symbols)
+{
+    std::ifstream input(file);
+    if (!input) { perror(file); return false; }
+    std::string line;
+    timerProbe = canProbe = (size_t)-1;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        Probe probe = Probe();
+        if (!(fields >> probe.label) || probe.label[0] == '#') continue;
+        std::getline(fields >> std::ws, probe.symbol);
+        std::map<std::string, uint32_t>::const_iterator symbol = symbols.find(probe.symbol);
+        probe.address = (symbol != symbols.end()) ? symbol->second : 0;
+        if (probe.label == "timer_isr") timerProbe = probes.size();
+        if (probe.label == "can_isr") canProbe = probes.size();
+        probes.push_back(probe);
+    }
+    if (timerProbe == (size_t)-1 || !probes[timerProbe].address || canProbe == (size_t)-1 || !probes[canProbe].address) {
+        fprintf(stderr, "%s: timer_isr and can_isr must be probed, with symbols of the ELF\n", file);
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-m mcu] [-f frequency] [-n ticks] -s symbols.txt -p probes.txt firmware.elf\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* mcu = "atmega32m1";
+    unsigned long frequency = 16000000;
+    unsigned long nbTicks = 200;
+    const char* symbolFile = 0;
+    const char* probeFile = 0;
+    int option;
+    while ((option = getopt(argc, argv, "m:f:n:s:p:")) != -1) {
+        switch (option) {
+        case 'm': mcu = optarg; break;
+        case 'f': frequency = strtoul(optarg, 0, 0); break;
+        case 'n': nbTicks = strtoul(optarg, 0, 0); break;
+        case 's': symbolFile = optarg; break;
+        case 'p': probeFile = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || !symbolFile || !probeFile || frequency == 0 || nbTicks == 0) usage(argv[0]);
+    const char* elf = argv[optind];
+
+    std::map<std::string, uint32_t> symbols;
+    if (!readSymbols(symbolFile, symbols) || !readProbes(probeFile, symbols)) return 1;
+    std::map<std::string, uint32_t>::const_iterator bootTimes = symbols.find("bootTimes");
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(elf, &firmware) != 0) { fprintf(stderr, "%s: not an AVR ELF\n", elf); return 1; }
+    avr_t* avr = avr_make_mcu_by_name(mcu);
+    if (!avr) { fprintf(stderr, "%s: no such core in simavr (-m)\n", mcu); return 1; }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+    avr->frequency = frequency;
+
+    // the board: counter on the SPI bus, CAN frames
+    // the SPI of the core is named '0' or 0, depending on the simavr version
+    uint32_t spiName = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ('0'), SPI_IRQ_OUTPUT) ? '0' : 0;
+    avr_irq_t* spiOutputIrq = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(spiName), SPI_IRQ_OUTPUT);
+    spiInput = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(spiName), SPI_IRQ_INPUT);
+    if (!spiOutputIrq || !spiInput) { fprintf(stderr, "%s: no SPI in the simavr core\n", mcu); return 1; }
+    avr_irq_register_notify(spiOutputIrq, spiOutput, avr);
+    counter.str = LS7366R_STR_INIT;
+
+    // the CAN interruption: __vector_N of CAN_INT_vect (see the Makefile), enabled by ENIT
+    const std::string& canSymbol = probes[canProbe].symbol;
+    if (canSymbol.compare(0, 9, "__vector_") != 0) { fprintf(stderr, "%s: not a vector\n", canSymbol.c_str()); return 1; }
+    canVector.vector = strtoul(canSymbol.c_str() + 9, 0, 10);
+    canVector.enable.reg = REG_CANGIE;
+    canVector.enable.bit = ENIT_BIT;
+    canVector.enable.mask = 1;
+    avr_register_vector(avr, &canVector);
+    avr_cycle_timer_register_usec(avr, CAN_PERIOD_US, speedFrame, 0);
+    avr_cycle_timer_register_usec(avr, CAN_PERIOD_US + CONFIG_PHASE_US, configFrame, 0);
+
+    // index of the probes by flash address (word)
+    std::vector<int> probeAt(avr->flashend/2 + 1, -1);
+    for (size_t i = 0; i < probes.size(); i++) {
+        if (probes[i].address) probeAt[probes[i].address/2] = i;
+    }
+
+    std::vector<Call> calls;
+    avr_cycle_count_t boot = 0;
+    uint16_t bootStages[BOOT_NB_STAGES] = {0};
+    avr_cycle_count_t lastTick = 0;
+    unsigned long ticks = 0;
+    int state = cpu_Running;
+    while (ticks < nbTicks && state != cpu_Done && state != cpu_Crashed) {
+        uint16_t sp = avr->data[REG_SPL] | (avr->data[REG_SPH] << 8);
+        while (!calls.empty() && sp > calls.back().sp) {
+            // the probed call has returned
+            Probe& probe = probes[calls.back().probe];
+            unsigned long cycles = avr->cycle - calls.back().start;
+            if (probe.calls == 0 || cycles < probe.min) probe.min = cycles;
+            if (cycles > probe.max) probe.max = cycles;
+            probe.total += cycles;
+            probe.calls++;
+            if (calls.back().probe == timerProbe) {
+                ticks++;
+                lastTick = avr->cycle;
+            }
+            calls.pop_back();
+        }
+        int probe = (avr->pc/2 < probeAt.size()) ? probeAt[avr->pc/2] : -1;
+        if (probe >= 0 && (calls.empty() || calls.back().probe != (size_t)probe || calls.back().sp != sp)) {
+            Call call = {(size_t)probe, sp, avr->cycle};
+            calls.push_back(call);
+            if ((size_t)probe == timerProbe) counter.cntr += COUNTS_PER_TICK;
+        }
+        if (avr->data[REG_PLLCSR] & (1 << PLLE_BIT)) avr->data[REG_PLLCSR] |= (1 << PLOCK_BIT);
+
+        state = avr_run(avr);
+        if (state == cpu_Sleeping && boot == 0) {
+            boot = avr->cycle;
+            lastTick = boot;
+            if (bootTimes != symbols.end()) {
+                memcpy(bootStages, avr->data + (bootTimes->second - DATA_OFFSET), sizeof(bootStages));
+            }
+        }
+        if (avr->cycle - lastTick > avr_usec_to_cycles(avr, TICK_MAX_US)) {
+            fprintf(stderr, "%s: no timer interruption for %dms after %lu ticks (pc 0x%04X)\n",
+                    elf, TICK_MAX_US/1000, ticks, (unsigned)avr->pc);
+            return 1;
+        }
+    }
+    if (ticks < nbTicks) {
+        fprintf(stderr, "%s: the firmware stopped after %lu ticks (pc 0x%04X)\n", elf, ticks, (unsigned)avr->pc);
+        return 1;
+    }
+
+    // boot_<stage>: BOOT_STAGE_XXX of main.cpp, 0xFFFF reached after the first timer period
+    static const char* const stages[BOOT_NB_STAGES] = {"io", "counter", "can", "adc", "pll", "ready"};
+    printf("boot %llu\n", (unsigned long long)boot);
+    for (int i = 0; i < BOOT_NB_STAGES && bootTimes != symbols.end(); i++) {
+        if (bootStages[i] != 0xFFFF) printf("boot_%s %lu\n", stages[i], 8ul*bootStages[i]);
+    }
+    printf("can_frames %lu\n", nbFrames);
+    for (size_t i = 0; i < probes.size(); i++) {
+        const Probe& probe = probes[i];
+        if (!probe.address) {
+            printf("# %s: %s not in the ELF (inlined)\n", probe.label.c_str(), probe.symbol.c_str());
+            continue;
+        }
+        printf("%s.calls %lu\n", probe.label.c_str(), probe.calls);
+        printf("%s.min %lu\n", probe.label.c_str(), probe.min);
+        printf("%s.max %lu\n", probe.label.c_str(), probe.max);
+        printf("%s.total %llu\n", probe.label.c_str(), probe.total);
+    }
+    return 0;
+}
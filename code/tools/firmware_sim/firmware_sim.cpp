@@ -0,0 +1,303 @@
+//! \file firmware_sim.cpp
+//! \brief Host run of the firmware on a SocketCAN interface: frame losses and command latency (Linux)
+//! \date 2026 10 18
+//!
+//! Usage: firmware_sim [-i interface] [-c can_isr_us] [-t timer_isr_us] [-v]
+//! The firmware (main.cpp) runs on the host against the mock registers and the CAN controller
+//! model of the unit tests (see ../../test/mock_firmware.h), in real time on the interface (vcan0):
+//!     - the frames are given to the controller at their reception time stamp (SO_TIMESTAMP), the
+//!       frames sent by the firmware are sent on the interface (replies to can_replay...)
+//!     - the timer interruption is called every 25.024ms, the counter follows the speed target of the
+//!       previous tick (ideal motor: enough for the timing of the PWM updates, not for the control)
+//!     - the interruptions take can_isr_us and timer_isr_us (the CPU time on the target, from make
+//!       PROFILE=1): an interruption raised meanwhile waits, the timer first. A frame received while
+//!       its MOB waits for the CAN interruption finds no MOB, it is lost as on the target.
+//! The time of each write of the duty cycle registers (POCRnSA, POCRnSB) is the time of the interruption
+//! writing it: the latency of a speed frame changing the command is the delay to the write of the next
+//! tick. The duty cycles are only written when they change (see M32m1_pwm::updateOutputs): the frames
+//! not changing them at the next tick (the PID output rounded to the same value) are counted apart.
+//! The statistics are printed at the end (SIGINT, SIGTERM).
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "mock_firmware.h"
+
+#ifndef MOTORBOARD
+#define MOTORBOARD              0           //!< Number of the board on the CAN bus (make BOARD=n)
+#endif
+#define ID_MOTORBOARD_BASE      (0x040 + 0x010*MOTORBOARD) //!< First CAN ID of the board (see main.cpp)
+#define ID_DATASPEED            (ID_MOTORBOARD_BASE + 0) //!< The CAN ID of the speed commands
+#define ID_CONFIG               (ID_MOTORBOARD_BASE + 2) //!< The CAN ID of the configuration commands
+#define SIDE_MOTOR              1           //!< Sign of the counter of main.cpp (RIGHT_MOTOR)
+#define TICK_US                 25024       //!< Period of the timer interruption (us)
+#define CAN_TIMER_US            100         //!< Period of the CAN timer (us)
+
+volatile uint8_t mockIo[0x100];     //!< The 8-bit registers of the mock
+volatile uint16_t mockIo16[0x100];  //!< The 16-bit registers of the mock
+void (*mockPscWrite)(uint8_t address);
+
+extern volatile int16_t nb_tics_target; //!< The speed target of the firmware (counter value per tick)
+
+//! \struct Stats
+//! \brief Statistics of a type of frame of the board
+struct Stats
+{
+    unsigned long received; //!< Frames stored by a MOB
+    unsigned long lost;     //!< Frames found no MOB (the previous one not read yet)
+};
+
+static volatile sig_atomic_t stopRequested;
+static int canSocket = -1;
+static bool verbose;
+static long canIsrUs = 100;
+static long timerIsrUs = 1000;
+
+static long long simNow;            //!< Time of the interruption running (us from the start)
+static long long busyUntil;         //!< End of the interruption running (us)
+static long long nextTick;          //!< Time of the next timer interruption (us)
+static bool canPending;             //!< A CAN interruption waits for the end of the running one
+static Stats speedStats;
+static Stats configStats;
+static long long lastArrival = -1;  //!< Reception time of the previous frame of the board (us)
+static long long gapMin = -1;       //!< Shortest delay between two frames of the board (us)
+static uint8_t lastCommand[3];      //!< Data of the last speed frame received
+static std::vector<long long> pending; //!< Reception times of the speed frames changing the command, not applied yet
+static unsigned long nbUnchanged;   //!< Speed frames changing the command, no duty cycle written at the next tick
+static unsigned long nbLatencies;
+static long long latencySum;
+static long long latencyMax;
+static unsigned long nbUpdates;     //!< Interruptions writing the duty cycle registers
+static long long lastUpdate = -1;   //!< Time of the last one (us)
+
+static void onSignal(int) { stopRequested = 1; }
+
+//! \brief Time of the host (us), same clock as the reception time stamps of the socket
+static long long hostTime()
+{
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec*1000000LL + now.tv_usec;
+}
+
+//! \brief A write of a duty cycle register: the pending commands are applied
+static void onPscWrite(uint8_t)
+{
+    if (simNow != lastUpdate) nbUpdates++;
+    lastUpdate = simNow;
+    for (size_t i = 0; i < pending.size(); i++) {
+        long long latency = simNow - pending[i];
+        nbLatencies++;
+        latencySum += latency;
+        if (latency > latencyMax) latencyMax = latency;
+    }
+    pending.clear();
+}
+
+//! \brief Send the frames sent by the firmware on the interface
+static void forwardSent()
+{
+    for (uint8_t i = 0; i < mockCanNbSent; i++) {
+        struct can_frame frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.can_id = mockCanSent[i].id | (mockCanSent[i].rtr ? CAN_RTR_FLAG : 0);
+        frame.can_dlc = mockCanSent[i].dlc;
+        memcpy(frame.data, mockCanSent[i].data, sizeof(frame.data));
+        if (write(canSocket, &frame, sizeof(frame)) != sizeof(frame)) perror("write");
+    }
+    mockCanNbSent = 0;
+}
+
+//! \brief The CAN interruption at time t, then the main loop
+static void serveCan(long long t)
+{
+    simNow = t;
+    CANTIM = t/CAN_TIMER_US;
+    mockFirmwareRun();
+    forwardSent();
+    canPending = false;
+    busyUntil = t + canIsrUs;
+}
+
+//! \brief The timer interruption at time t, then the main loop
+static void serveTick(long long t)
+{
+    simNow = t;
+    CANTIM = t/CAN_TIMER_US;
+    unsigned long nbUpdatesBefore = nbUpdates;
+    TIMER1_COMPA_vect();
+    if (nbUpdates == nbUpdatesBefore) {
+        nbUnchanged += pending.size();
+        pending.clear();
+    }
+    mockFirmwareRun();
+    forwardSent();
+    // the counter value of the next tick
+    mockCounterValue += SIDE_MOTOR*nb_tics_target;
+    busyUntil = t + timerIsrUs;
+    nextTick += TICK_US;
+}
+
+//! \brief Serve the interruptions raised until time t (in order, one at a time)
+static void advance(long long t)
+{
+    for (;;) {
+        long long start = (busyUntil > nextTick) ? busyUntil : nextTick;
+        if (canPending && busyUntil < start) {
+            // the CAN interruption waited for the end of the running one, before the timer
+            if (busyUntil > t) return;
+            serveCan(busyUntil);
+        } else {
+            if (start > t) return;
+            serveTick(start);
+        }
+    }
+}
+
+//! \brief A frame received at time t
+static void receive(long long t, const struct can_frame& frame)
+{
+    advance(t);
+    MockCanFrame received;
+    received.id = frame.can_id & CAN_SFF_MASK;
+    received.rtr = frame.can_id & CAN_RTR_FLAG;
+    received.dlc = frame.can_dlc;
+    memcpy(received.data, frame.data, sizeof(received.data));
+    bool speed = (received.id == ID_DATASPEED && !received.rtr);
+    bool config = (received.id == ID_CONFIG && !received.rtr);
+    if (speed || config) {
+        if (lastArrival >= 0 && (gapMin < 0 || t - lastArrival < gapMin)) gapMin = t - lastArrival;
+        lastArrival = t;
+    }
+
+    CANTIM = t/CAN_TIMER_US;
+    int8_t mob = mockCanReceive(received);
+    Stats* stats = speed ? &speedStats : config ? &configStats : 0;
+    if (stats) {
+        if (mob < 0) {
+            stats->lost++;
+            if (verbose) printf("%10.6f 0x%03X lost\n", t*1e-6, received.id);
+        } else {
+            stats->received++;
+        }
+    }
+    if (speed && mob >= 0 && memcmp(lastCommand, received.data, sizeof(lastCommand)) != 0) {
+        memcpy(lastCommand, received.data, sizeof(lastCommand));
+        pending.push_back(t);
+    }
+    if (mob < 0) return;
+    if (busyUntil <= t) {
+        serveCan(t);
+    } else {
+        canPending = true;
+    }
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-i interface] [-c can_isr_us] [-t timer_isr_us] [-v]\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    const char* interface = "vcan0";
+    int option;
+    while ((option = getopt(argc, argv, "i:c:t:v")) != -1) {
+        switch (option) {
+        case 'i': interface = optarg; break;
+        case 'c': canIsrUs = strtol(optarg, 0, 0); break;
+        case 't': timerIsrUs = strtol(optarg, 0, 0); break;
+        case 'v': verbose = true; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || canIsrUs < 0 || timerIsrUs < 0 || canIsrUs + timerIsrUs >= TICK_US) usage(argv[0]);
+
+    // CAN socket, with the reception time stamps
+    canSocket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (canSocket < 0) { perror("socket"); return 1; }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface, IFNAMSIZ - 1);
+    if (ioctl(canSocket, SIOCGIFINDEX, &ifr) < 0) { perror(interface); return 1; }
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(canSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0) { perror("bind"); return 1; }
+    int on = 1;
+    setsockopt(canSocket, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    // boot of the firmware, the time starts with its first tick
+    mockPscWrite = onPscWrite;
+    if (!mockFirmwareStart()) { fprintf(stderr, "the firmware reset during its initialization\n"); return 1; }
+    forwardSent();
+    long long origin = hostTime();
+    nextTick = TICK_US;
+    printf("board %d on %s: CAN interruption %ldus, timer interruption %ldus (every %dus)\n",
+           MOTORBOARD, interface, canIsrUs, timerIsrUs, TICK_US);
+    fflush(stdout);
+
+    while (!stopRequested && !mockFirmwareReset()) {
+        long long now = hostTime() - origin;
+        long long next = (canPending && busyUntil < nextTick) ? busyUntil : nextTick;
+        struct pollfd fd = {canSocket, POLLIN, 0};
+        int timeout = (next > now) ? (int)((next - now + 999)/1000) : 0;
+        if (poll(&fd, 1, timeout) > 0) {
+            // the frames received, in order
+            struct can_frame frame;
+            struct iovec iov = {&frame, sizeof(frame)};
+            char control[CMSG_SPACE(sizeof(struct timeval))];
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            while (recvmsg(canSocket, &msg, MSG_DONTWAIT) == sizeof(frame)) {
+                long long stamp = hostTime();
+                for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+                    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMP) {
+                        struct timeval tv;
+                        memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+                        stamp = tv.tv_sec*1000000LL + tv.tv_usec;
+                    }
+                }
+                stamp -= origin;
+                // never before the interruptions already served
+                receive((stamp > simNow) ? stamp : simNow, frame);
+                msg.msg_controllen = sizeof(control);
+            }
+        }
+        advance(hostTime() - origin);
+    }
+    if (mockFirmwareReset()) printf("the firmware reset itself\n");
+    mockFirmwareStop();
+
+    printf("speed     %lu received, %lu lost\n", speedStats.received, speedStats.lost);
+    printf("config    %lu received, %lu lost\n", configStats.received, configStats.lost);
+    if (gapMin >= 0) printf("gap       %lldus min between two frames of the board\n", gapMin);
+    if (nbLatencies) {
+        printf("latency   %.2fms mean, %.2fms max (%lu commands, reception to duty cycle write)\n",
+               latencySum*1e-3/nbLatencies, latencyMax*1e-3, nbLatencies);
+    }
+    printf("unchanged %lu commands without duty cycle change at the next tick\n", nbUnchanged);
+    printf("pwm       %lu duty cycle updates over %lld ticks\n", nbUpdates, nextTick/TICK_US - 1);
+    return (speedStats.received == 0) ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+//! \file motor_model.cpp
+//! \brief Host benchmark of the drive modes of the H-Bridge on a DC motor model
+//! \date 2026 10 18
+//!
+//! Usage: motor_model
+//! The firmware drivers (Motor_dc, M32m1_pwm) write the mock PSC registers (see
+//! ../../test/mock), the model reads them at each PWM period: the center-aligned
+//! PSC waveform with its dead-times, the body diodes of the H-Bridge (discontinuous
+//! current when both transistors of a half-bridge are open) and a DC motor with
+//! viscous and Coulomb friction. For each drive mode, it reports:
+//!     - the low-speed linearity: steady speed over the first 1/8 of the commands,
+//!       dead band and largest deviation from a straight line
+//!     - the current ripple (peak to peak) at 0 and at 25% of the command
+//!     - the stopping distance and time from 50% of the command, after setSpeed(0)
+
+#include <cmath>
+#include <cstdio>
+
+#include "motor_dc.h"
+
+volatile uint8_t mockIo[0x100];     //!< The 8-bit registers of the mock
+volatile uint16_t mockIo16[0x100];  //!< The 16-bit registers of the mock
+void (*mockPscWrite)(uint8_t address);  //!< No hook on the duty cycle registers
+
+// Motor (small 12V gear motor, values at the motor shaft)
+#define VBUS            12.0        //!< Supply voltage (V)
+#define DIODE_DROP      0.7         //!< Forward voltage of the body diodes (V)
+#define RESISTANCE      2.0         //!< Winding resistance (ohm)
+#define INDUCTANCE      1.0e-3      //!< Winding inductance (H)
+#define KE              0.02        //!< Back-EMF and torque constant (V.s/rad, N.m/A)
+#define INERTIA         5.0e-6      //!< Rotor and reduced load inertia (kg.m2)
+#define VISCOUS         1.0e-6      //!< Viscous friction (N.m.s/rad)
+#define COULOMB         2.0e-3      //!< Coulomb friction (N.m)
+
+// Simulation
+#define PSC_CLOCK       64.0e6      //!< PSC clock (Hz), PLL 64MHz without prescaler (Motor_dc defaults)
+#define STEP_CYCLES     8           //!< Longest integration step (PSC cycles)
+#define SETTLE_TIME     0.25        //!< Time to reach a steady speed (s)
+#define MEASURE_TIME    0.05        //!< Averaging time of a steady speed (s)
+#define STOP_TIMEOUT    2.0         //!< Longest stopping time (s)
+#define STOP_SPEED      0.5         //!< Speed considered as stopped (rad/s)
+#define NB_LOW_SPEEDS   16          //!< Number of commands of the low-speed sweep (up to MOTOR_SPEED_MAX/8)
+
+//! \brief Drive modes of the benchmark
+#define NB_DRIVE_MODES  4           //!< Number of drive modes of the benchmark
+static const uint8_t driveModes[NB_DRIVE_MODES] = {DRIVE_MODE_SLOW_DECAY, DRIVE_MODE_ASYNC_DECAY,
+                                                   DRIVE_MODE_LOCKED_ANTIPHASE, DRIVE_MODE_FAST_DECAY};
+static const char* driveModeNames[NB_DRIVE_MODES] = {"slow decay", "asynchronous slow decay", "locked anti-phase",
+                                                     "asynchronous fast decay"};
+
+//! \struct Model
+//! \brief State of the motor
+struct Model
+{
+    double current;     //!< Winding current (A), from the half-bridge 0 to the half-bridge 1
+    double speed;       //!< Shaft speed (rad/s)
+    double angle;       //!< Shaft angle (rad)
+    double time;        //!< Simulated time (s)
+    double currentMin;  //!< Lowest current since the last resetRipple (A)
+    double currentMax;  //!< Highest current since the last resetRipple (A)
+};
+
+//! \struct HalfBridge
+//! \brief Gate states of a half-bridge during a segment of the PWM period
+struct HalfBridge
+{
+    bool high;  //!< High side closed
+    bool low;   //!< Low side closed
+};
+
+//! \brief resetRipple Start a new measure of the current ripple
+static void resetRipple(Model* model)
+{
+    model->currentMin = model->current;
+    model->currentMax = model->current;
+}
+
+//! \brief terminalVoltage Voltage of a half-bridge output
+//! \param[in] bridge : the gate states
+//! \param[in] outCurrent : the current flowing out of the output, into the motor
+//! \param[out] voltage : the voltage
+//! \return false if the output is floating (both sides open, no current)
+static bool terminalVoltage(HalfBridge bridge, double outCurrent, double* voltage)
+{
+    if (bridge.high)            *voltage = VBUS;
+    else if (bridge.low)        *voltage = 0;
+    else if (outCurrent > 0)    *voltage = -DIODE_DROP;         // low side diode
+    else if (outCurrent < 0)    *voltage = VBUS + DIODE_DROP;   // high side diode
+    else return false;
+    return true;
+}
+
+//! \brief currentDerivative Derivative of the winding current for a direction of the current
+//! \return false if the bridges cannot drive a current in this direction (diodes blocked)
+static bool currentDerivative(const HalfBridge* bridges, const Model* model, double direction, double* derivative)
+{
+    double v0, v1;
+    double current = (model->current != 0) ? model->current : direction;
+    if (!terminalVoltage(bridges[0], current, &v0)) return false;
+    if (!terminalVoltage(bridges[1], -current, &v1)) return false;
+    *derivative = (v0 - v1 - RESISTANCE*model->current - KE*model->speed) / INDUCTANCE;
+    return model->current != 0 || *derivative*direction > 0;
+}
+
+//! \brief step Integrate the model over a step with constant gate states
+static void step(Model* model, const HalfBridge* bridges, double dt)
+{
+    // electrical part
+    double derivative = 0;
+    if (model->current != 0) {
+        currentDerivative(bridges, model, 0, &derivative);
+        double current = model->current + derivative*dt;
+        // the diodes block the reverse current of an open half-bridge
+        bool open = !(bridges[0].high || bridges[0].low) || !(bridges[1].high || bridges[1].low);
+        if (open && current*model->current < 0) current = 0;
+        model->current = current;
+    } else if (currentDerivative(bridges, model, 1, &derivative) ||
+               currentDerivative(bridges, model, -1, &derivative)) {
+        model->current = derivative*dt;
+    }
+    if (model->current < model->currentMin) model->currentMin = model->current;
+    if (model->current > model->currentMax) model->currentMax = model->current;
+
+    // mechanical part, the Coulomb friction holds the shaft at rest
+    double torque = KE*model->current - VISCOUS*model->speed;
+    if (model->speed == 0 && std::fabs(torque) <= COULOMB) {
+        torque = 0;
+    } else {
+        double friction = (model->speed != 0) ? model->speed : torque;
+        torque -= (friction > 0) ? COULOMB : -COULOMB;
+    }
+    double speed = model->speed + torque/INERTIA*dt;
+    if (model->speed != 0 && speed*model->speed < 0) speed = 0;
+    model->angle += 0.5*(model->speed + speed)*dt;
+    model->speed = speed;
+    model->time += dt;
+}
+
+//! \brief gates Gate states of a half-bridge at a counter value of the up-counting half-period
+//! \param[in] channel : the PSC channel (0 or 1)
+//! \param[in] counter : the PSC counter value
+static HalfBridge gates(uint8_t channel, uint16_t counter)
+{
+    static const uint8_t portA[2] = {GPIO_PORTD, GPIO_PORTC};
+    static const uint8_t pinA[2] = {PSCOUT0A_PIN, PSCOUT1A_PIN};
+    static const uint8_t pinB[2] = {PSCOUT0B_PIN, PSCOUT1B_PIN};
+    uint16_t sa = channel ? POCR1SA : POCR0SA;
+    uint16_t sb = channel ? POCR1SB : POCR0SB;
+    HalfBridge bridge;
+    // centered mode: output A active around the bottom of the counter, output B around the top
+    // (around the bottom too when inverted, POPB cleared)
+    bool activeB = (PCNF & (1 << POPB)) ? counter >= sb : counter < sb;
+    bridge.high = (POC & (1 << (2*channel)))     ? counter < sa : (_MMIO_BYTE(portA[channel]) & (1 << pinA[channel]));
+    bridge.low  = (POC & (1 << (2*channel + 1))) ? activeB      : (PORTB & (1 << pinB[channel]));
+    return bridge;
+}
+
+//! \brief period Simulate a PWM period with the current PSC registers
+static void period(Model* model)
+{
+    // segments of the up-counting half-period with constant gate states
+    uint16_t top = POCR_RB + 1;
+    uint16_t bounds[6] = {0, POCR0SA, POCR0SB, POCR1SA, POCR1SB, top};
+    for (uint8_t i=1; i<6; i++) {
+        for (uint8_t j=i; j>0 && bounds[j] < bounds[j-1]; j--) {
+            uint16_t swap = bounds[j]; bounds[j] = bounds[j-1]; bounds[j-1] = swap;
+        }
+    }
+    // up-counting half, then down-counting half (reverse order)
+    for (int8_t half=0; half<2; half++) {
+        for (int8_t k=0; k<5; k++) {
+            uint8_t i = half ? 4-k : k;
+            uint16_t start = bounds[i];
+            uint16_t end = (bounds[i+1] < top) ? bounds[i+1] : top;
+            if (end <= start) continue;
+            HalfBridge bridges[2] = {gates(0, start), gates(1, start)};
+            for (uint16_t c=start; c<end; c+=STEP_CYCLES) {
+                uint16_t n = (end - c < STEP_CYCLES) ? end - c : STEP_CYCLES;
+                step(model, bridges, n/PSC_CLOCK);
+            }
+        }
+    }
+}
+
+//! \brief run Simulate a duration
+static void run(Model* model, double duration)
+{
+    double end = model->time + duration;
+    while (model->time < end) period(model);
+}
+
+//! \brief steadySpeed Average speed after the settling time
+static double steadySpeed(Model* model)
+{
+    run(model, SETTLE_TIME);
+    double angle = model->angle;
+    double time = model->time;
+    run(model, MEASURE_TIME);
+    return (model->angle - angle) / (model->time - time);
+}
+
+//! \brief start A motor at rest, driven in a mode
+static void start(Model* model, Motor_dc* motor, uint8_t mode)
+{
+    *model = Model();
+    motor->enableMotor();
+    motor->setDriveMode(mode);
+    motor->setSpeed(0);
+}
+
+int main()
+{
+    PLLCSR = (1 << PLOCK); // the PSC starts at once
+    M32m1_pwm pwm;
+    Motor_dc motor(&pwm, 0);
+    Model model;
+
+    printf("DC motor model: %.0fV, %.1f ohm, %.1f mH, Ke %.3f V.s/rad, PWM %lu Hz, counter max %u\n",
+           VBUS, RESISTANCE, INDUCTANCE*1e3, KE, (unsigned long)pwm.getFrequency(), pwm.getCounterMax());
+    printf("(speeds in rad/s, at the motor shaft, no load speed %.0f rad/s)\n\n", VBUS/KE);
+
+    // low-speed linearity
+    printf("Low-speed linearity (steady speed per command)\n");
+    printf("%8s", "command");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%26s", driveModeNames[m]);
+    printf("\n");
+    double speeds[NB_DRIVE_MODES][NB_LOW_SPEEDS+1];
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) {
+        for (uint8_t i=0; i<=NB_LOW_SPEEDS; i++) {
+            start(&model, &motor, driveModes[m]);
+            motor.setSpeed(i * (MOTOR_SPEED_MAX/8/NB_LOW_SPEEDS));
+            speeds[m][i] = steadySpeed(&model);
+        }
+    }
+    for (uint8_t i=0; i<=NB_LOW_SPEEDS; i++) {
+        printf("%8d", i * (MOTOR_SPEED_MAX/8/NB_LOW_SPEEDS));
+        for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%26.2f", speeds[m][i]);
+        printf("\n");
+    }
+    printf("%8s", "deadband");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) {
+        uint8_t i = 0;
+        while (i < NB_LOW_SPEEDS && speeds[m][i] < STOP_SPEED) i++;
+        if (speeds[m][i] < STOP_SPEED) printf("%23s%3d", ">", MOTOR_SPEED_MAX/8); // over the sweep
+        else printf("%26d", i * (MOTOR_SPEED_MAX/8/NB_LOW_SPEEDS));
+    }
+    printf("\n%8s", "error");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) {
+        // largest deviation from the line through the first moving point and the last point,
+        // in % of the speed range of the sweep
+        uint8_t first = 0;
+        while (first < NB_LOW_SPEEDS && speeds[m][first] < STOP_SPEED) first++;
+        if (first == NB_LOW_SPEEDS) {
+            printf("%26s", "-"); // no moving point in the sweep
+            continue;
+        }
+        double slope = (speeds[m][NB_LOW_SPEEDS] - speeds[m][first]) / (NB_LOW_SPEEDS - first);
+        double error = 0;
+        for (uint8_t i=first; i<=NB_LOW_SPEEDS; i++) {
+            double deviation = std::fabs(speeds[m][i] - (speeds[m][first] + slope*(i - first)));
+            if (deviation > error) error = deviation;
+        }
+        printf("%25.2f%%", 100*error/speeds[m][NB_LOW_SPEEDS]);
+    }
+    printf("\n\n");
+
+    // current ripple
+    printf("Current ripple (A, peak to peak, steady state)\n");
+    printf("%8s", "command");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%26s", driveModeNames[m]);
+    printf("\n");
+    const int commands[2] = {0, MOTOR_SPEED_MAX/4};
+    for (uint8_t c=0; c<2; c++) {
+        printf("%8d", commands[c]);
+        for (uint8_t m=0; m<NB_DRIVE_MODES; m++) {
+            start(&model, &motor, driveModes[m]);
+            motor.setSpeed(commands[c]);
+            run(&model, SETTLE_TIME);
+            resetRipple(&model);
+            run(&model, MEASURE_TIME);
+            printf("%26.3f", model.currentMax - model.currentMin);
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    // stopping distance
+    printf("Stop from %d (setSpeed(0))\n", MOTOR_SPEED_MAX/2);
+    printf("%8s", "");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%26s", driveModeNames[m]);
+    printf("\n");
+    double distances[NB_DRIVE_MODES], times[NB_DRIVE_MODES], initial[NB_DRIVE_MODES];
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) {
+        start(&model, &motor, driveModes[m]);
+        motor.setSpeed(MOTOR_SPEED_MAX/2);
+        run(&model, SETTLE_TIME);
+        initial[m] = model.speed;
+        double angle = model.angle;
+        double time = model.time;
+        motor.setSpeed(0);
+        while (std::fabs(model.speed) >= STOP_SPEED && model.time - time < STOP_TIMEOUT) period(&model);
+        distances[m] = model.angle - angle;
+        times[m] = model.time - time;
+    }
+    printf("%8s", "speed");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%20.1f rad/s", initial[m]);
+    printf("\n%8s", "distance");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%22.2f rad", distances[m]);
+    printf("\n%8s", "time");
+    for (uint8_t m=0; m<NB_DRIVE_MODES; m++) printf("%23.1f ms", times[m]*1e3);
+    printf("\n");
+    return 0;
+}